@@ -0,0 +1,81 @@
+/**
+ * @file bip_buffer.h
+ */
+
+#ifndef _BIP_BUFFER_H
+#define _BIP_BUFFER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdlib.h"
+#include "assert.h"
+#include "stdatomic.h"
+#include "circular_buffer.h"
+
+/**@defgroup Bip_Buffer_Exported_Types
+ * @{
+ */
+
+/**
+ * @brief  Bip buffer data struct
+ * @note   The definition is only exposed to allow static allocation of the control block,
+ *         members must not be accessed directly, use the bip_buff_xxx() API.
+ * @struct bip_buff_t
+ */
+typedef struct bip_buff_t
+{
+    uint8_t *buffer;
+    size_t length;
+    atomic_size_t write;        /* end of the written data, only written by the producer */
+    atomic_size_t last;         /* end of the data before the write index wrapped, only written by the producer */
+    atomic_size_t read;         /* start of the data to be read, only written by the consumer */
+    size_t reserve_start;       /* start of the ongoing reservation, producer side */
+    uint8_t reserve_wrap;       /* ongoing reservation starts again at the beginning of the buffer, producer side */
+#if CIRCULAR_BUFF_STATS_ENABLE
+    circular_buff_stats_t stats; /* usage statistics, producer and consumer only update their own counters */
+#endif
+}bip_buff_t;
+
+/*@brief pointer typedef to bip buffer struct */
+typedef bip_buff_t* bip_buff_handle_t;
+
+/**@} */
+
+/**
+ * @defgroup Bip_Buffer_Exported_Functions Bip Buffer Exported Functions
+ * @{
+ */
+
+/** Initialize a bip buffer in a control block provided by the caller */
+bip_buff_handle_t bip_buff_init_static(bip_buff_t *bip_buff, uint8_t *buffer, size_t size);
+
+/** Reset bip buffer to default values (producer and consumer must be stopped) */
+void bip_buff_reset(bip_buff_handle_t bip_buff);
+
+/** Get amount of data available to be read in bip buffer */
+size_t bip_buff_get_data_len(bip_buff_handle_t bip_buff);
+
+/** Reserve a contiguous region of data_len bytes to be written */
+uint8_t *bip_buff_reserve(bip_buff_handle_t bip_buff, size_t data_len);
+
+/** Publish data written in the region obtained with bip_buff_reserve() */
+void bip_buff_commit_write(bip_buff_handle_t bip_buff, size_t data_len);
+
+/** Write an array of data segments as a single contiguous block (all or nothing) */
+circular_buff_st_t bip_buff_writev(bip_buff_handle_t bip_buff, const circular_buff_segment_t *segment, size_t segment_cnt);
+
+/** Get the contiguous block with the oldest data available to be read, without consuming it */
+size_t bip_buff_peek(bip_buff_handle_t bip_buff, uint8_t **data);
+
+/** Consume data previously accessed with bip_buff_peek() */
+void bip_buff_commit_read(bip_buff_handle_t bip_buff, size_t data_len);
+
+/** Get usage statistics of bip buffer */
+void bip_buff_get_stats(bip_buff_handle_t bip_buff, circular_buff_stats_t *stats);
+
+/** Reset usage statistics of bip buffer */
+void bip_buff_reset_stats(bip_buff_handle_t bip_buff);
+
+/**@} */
+
+#endif
@@ -10,6 +10,19 @@
 #include "stdint.h"
 #include "assert.h"
 #include "stdlib.h"
+#include "stdatomic.h"
+
+/**@brief Enable/Disable power-of-two mode.
+ * @note  When enabled, index wraparound is computed with a mask instead of a modulo,
+ *        every buffer registered in circular_buff_init() must have a power-of-two size.
+ *        It can be overridden from the build (the host tests build both modes).
+ */
+#ifndef CIRCULAR_BUFF_POW2_MODE
+#define CIRCULAR_BUFF_POW2_MODE (1)
+#endif
+
+/**@brief Enable/Disable usage statistics (bytes in/out, high-water mark, overflows) */
+#define CIRCULAR_BUFF_STATS_ENABLE (1)
 
 /**
  * @brief list enumeration for circular buffer state
@@ -27,14 +40,95 @@ typedef enum
  * @{
  */
 
-/*@brief typedef definition for circular buffer struct  */
-typedef struct circular_buff_t circular_buff_t;
+/*@brief circular buffer usage statistics */
+typedef struct
+{
+    uint32_t bytes_in;          /* number of bytes written */
+    uint32_t bytes_out;         /* number of bytes consumed (read, committed or flushed) */
+    uint32_t high_water;        /* maximum number of bytes stored at once */
+    uint32_t overflow_cnt;      /* number of writes rejected for lack of space */
+    uint32_t bytes_dropped;     /* number of bytes rejected for lack of space or overwritten */
+    uint32_t records_dropped;   /* number of records overwritten by circular_buff_overwrite_record() */
+}circular_buff_stats_t;
+
+/*@brief behavior of a broadcast tap that falls behind */
+typedef enum
+{
+    CIRCULAR_BUFF_TAP_GATING = 0x00,    /* producer waits for the tap, the tap never loses data */
+    CIRCULAR_BUFF_TAP_LAPPED,           /* producer ignores the tap, it skips data released by the other consumers */
+
+}circular_buff_tap_mode_t;
+
+/*@brief broadcast tap statistics */
+typedef struct
+{
+    uint32_t lap_cnt;           /* number of times the tap was lapped */
+    uint32_t bytes_lost;        /* number of bytes skipped because the tap was lapped */
+}circular_buff_tap_stats_t;
+
+/**
+ * @brief  Broadcast tap, an extra reader with its own cursor that does not consume data
+ * @note   Members must not be accessed directly, use the circular_buff_tap_xxx() API.
+ * @struct circular_buff_tap_t
+ */
+typedef struct circular_buff_tap_t
+{
+    struct circular_buff_tap_t *next;   /* next tap attached to the same buffer */
+    struct circular_buff_t *c_buff;     /* buffer the tap is attached to */
+    circular_buff_tap_mode_t mode;
+    atomic_size_t cursor;               /* tap read index, only written by the tap reader */
+    circular_buff_tap_stats_t stats;
+}circular_buff_tap_t;
+
+/**
+ * @brief  Circular buffer data struct
+ * @note   The definition is only exposed to allow static allocation of the control block,
+ *         members must not be accessed directly, use the circular_buff_xxx() API.
+ * @struct circular_buff_t
+ */
+typedef struct circular_buff_t
+{
+    uint8_t *buffer;
+    size_t length;
+    size_t limit;               /* wraparound limit of the free running indexes (multiple of length) */
+    atomic_size_t head;         /* producer index, only written by the producer */
+    atomic_size_t tail;         /* consumer index, only written by the consumer (and the producer in record overwrite mode) */
+    _Atomic(circular_buff_tap_t *) taps; /* list of attached broadcast taps */
+#if CIRCULAR_BUFF_STATS_ENABLE
+    circular_buff_stats_t stats; /* usage statistics, producer and consumer only update their own counters */
+#endif
+}circular_buff_t;
 
 /*@brief pointer typedef to circular buffer struct */
 typedef circular_buff_t* c_buff_handle_t;
 
+/*@brief contiguous region of memory inside the circular buffer */
+typedef struct
+{
+    uint8_t *data;      /* pointer to the first byte of the region */
+    size_t len;         /* number of bytes in the region */
+}circular_buff_region_t;
+
+/*@brief data segment of a gather write */
+typedef struct
+{
+    const uint8_t *data;    /* pointer to the data to be written */
+    size_t len;             /* number of bytes to be written */
+}circular_buff_segment_t;
+
 /**@} */
 
+/**@brief Size of the length prefix stored in front of every record */
+#define CIRCULAR_BUFF_RECORD_HDR_SIZE   (sizeof(uint16_t))
+
+/**
+ * @brief Define a statically allocated circular buffer (data storage and control block)
+ * @note  The handle is obtained with circular_buff_init_static(&name##_ctrl, name##_data, size)
+ */
+#define CIRCULAR_BUFF_DEF(name, size)       \
+    static uint8_t name##_data[size];       \
+    static circular_buff_t name##_ctrl
+
 
 /**
  * @defgroup Circular_Buffer_Exported_Functions Circular Buffer Exported Functions 
@@ -50,12 +144,18 @@ uint8_t circular_buff_full(c_buff_handle_t c_buff);
 /** Get an instance of circular buffer and initialize it */
 c_buff_handle_t circular_buff_init(uint8_t *buffer, size_t size);
 
+/** Initialize a circular buffer in a control block provided by the caller (no heap usage) */
+c_buff_handle_t circular_buff_init_static(circular_buff_t *c_buff, uint8_t *buffer, size_t size);
+
 /** Deallocate specified c_buffer */
 void circular_buff_free(c_buff_handle_t c_buff);
 
-/** Reset c_buffer to default values */
+/** Reset c_buffer to default values (producer and consumer must be stopped) */
 void circular_buff_reset(c_buff_handle_t c_buff);
 
+/** Discard all data available in c_buffer (consumer side) */
+void circular_buff_flush(c_buff_handle_t c_buff);
+
 /** Get amount of bytes available to be written in c_buffer */
 size_t circular_buff_get_free_space(c_buff_handle_t c_buff);
 
@@ -66,20 +166,86 @@ size_t circular_buff_capacity(c_buff_handle_t c_buff);
 size_t circular_buff_get_data_len(c_buff_handle_t c_buff);
 
 /** write byte in circular buffer */
-void circular_buff_put(c_buff_handle_t c_buff, uint8_t data);
+uint8_t circular_buff_put(c_buff_handle_t c_buff, uint8_t data);
 
 /** Read byte in circular buffer  */
 uint8_t circular_buff_get(c_buff_handle_t c_buff, uint8_t *data);
 
 /** Write amount of data in c_buff */
-circular_buff_st_t circular_buff_write(c_buff_handle_t c_buff, uint8_t *data, uint8_t data_len);
+circular_buff_st_t circular_buff_write(c_buff_handle_t c_buff, uint8_t *data, size_t data_len);
+
+/** Write an array of data segments in c_buff (all or nothing) */
+circular_buff_st_t circular_buff_writev(c_buff_handle_t c_buff, const circular_buff_segment_t *segment, size_t segment_cnt);
 
-/** Read amount of data in c_buff */
+/** Read amount of data in c_buff (all or nothing) */
 uint8_t circular_buff_read(c_buff_handle_t c_buff, uint8_t *data, size_t data_len);
 
 /** Fetch amount of data in c_buff */
 uint8_t circular_buff_fetch(c_buff_handle_t c_buff, uint8_t *data, size_t data_len);
 
+/** Fetch amount of data in c_buff starting at an offset from the oldest byte */
+uint8_t circular_buff_fetch_at(c_buff_handle_t c_buff, size_t offset, uint8_t *data, size_t data_len);
+
+/** Peek a little-endian 16 bit value at an offset from the oldest byte */
+uint8_t circular_buff_peek_u16_le(c_buff_handle_t c_buff, size_t offset, uint16_t *value);
+
+/** Peek a little-endian 32 bit value at an offset from the oldest byte */
+uint8_t circular_buff_peek_u32_le(c_buff_handle_t c_buff, size_t offset, uint32_t *value);
+
+/** Get the (at most two) contiguous regions with data available to be read, without consuming them */
+size_t circular_buff_peek(c_buff_handle_t c_buff, circular_buff_region_t region[2]);
+
+/** Consume data previously accessed with circular_buff_peek() */
+void circular_buff_commit_read(c_buff_handle_t c_buff, size_t data_len);
+
+/** Get the (at most two) contiguous regions available to be written */
+size_t circular_buff_reserve(c_buff_handle_t c_buff, circular_buff_region_t region[2]);
+
+/** Publish data written in the regions obtained with circular_buff_reserve() */
+void circular_buff_commit_write(c_buff_handle_t c_buff, size_t data_len);
+
+/** Search a pattern in the data available in c_buff, without consuming it */
+uint8_t circular_buff_find(c_buff_handle_t c_buff, const uint8_t *pattern, size_t pattern_len, size_t *offset);
+
+/** Write a record built from an array of data segments, rejected if there is no space */
+circular_buff_st_t circular_buff_write_record(c_buff_handle_t c_buff, const circular_buff_segment_t *segment, size_t segment_cnt);
+
+/** Write a record built from an array of data segments, oldest whole records are dropped to make room */
+circular_buff_st_t circular_buff_overwrite_record(c_buff_handle_t c_buff, const circular_buff_segment_t *segment, size_t segment_cnt);
+
+/** Read and remove the oldest record in c_buff */
+uint8_t circular_buff_read_record(c_buff_handle_t c_buff, uint8_t *data, size_t data_size, size_t *data_len);
+
+/** Fetch the oldest record in c_buff without removing it */
+uint8_t circular_buff_fetch_record(c_buff_handle_t c_buff, uint8_t *data, size_t data_size, size_t *data_len);
+
+/** Attach a broadcast tap to c_buff, it receives the data written from now on */
+void circular_buff_tap_attach(c_buff_handle_t c_buff, circular_buff_tap_t *tap, circular_buff_tap_mode_t mode);
+
+/** Detach a broadcast tap from its buffer */
+void circular_buff_tap_detach(circular_buff_tap_t *tap);
+
+/** Get amount of data available to be read by the tap */
+size_t circular_buff_tap_get_data_len(circular_buff_tap_t *tap);
+
+/** Get the (at most two) contiguous regions with data available for the tap, without consuming them */
+size_t circular_buff_tap_peek(circular_buff_tap_t *tap, circular_buff_region_t region[2]);
+
+/** Advance the tap cursor over data previously accessed with circular_buff_tap_peek() */
+uint8_t circular_buff_tap_commit(circular_buff_tap_t *tap, size_t data_len);
+
+/** Read up to data_size bytes available for the tap */
+size_t circular_buff_tap_read(circular_buff_tap_t *tap, uint8_t *data, size_t data_size);
+
+/** Get statistics of the tap */
+void circular_buff_tap_get_stats(circular_buff_tap_t *tap, circular_buff_tap_stats_t *stats);
+
+/** Get usage statistics of c_buff */
+void circular_buff_get_stats(c_buff_handle_t c_buff, circular_buff_stats_t *stats);
+
+/** Reset usage statistics of c_buff */
+void circular_buff_reset_stats(c_buff_handle_t c_buff);
+
 /**@} */
 
 #endif
\ No newline at end of file
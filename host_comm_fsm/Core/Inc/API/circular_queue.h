@@ -0,0 +1,129 @@
+/**
+ * @file circular_queue.h
+ * @brief  Type-generic circular queue with element type and capacity fixed at compile time
+ * @version 0.1
+ *
+ * @note   CIRCULAR_QUEUE_DECLARE() generates a queue type and its static inline functions for
+ *         one element type. The capacity must be a power of two so index math folds to constant
+ *         masks, and whole elements are moved with single struct copies. Like circular_buffer.c,
+ *         the queue is lock-free for a single producer and a single consumer.
+ *
+ * @example
+ *
+ * CIRCULAR_QUEUE_DECLARE(event_queue, event_t, 16)
+ *
+ * static event_queue_t events;
+ * event_queue_init(&events);
+ * event_queue_push(&events, &event);
+ * event_queue_pop(&events, &event);
+ */
+
+#ifndef _CIRCULAR_QUEUE_H
+#define _CIRCULAR_QUEUE_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+#include "stdatomic.h"
+
+/**
+ * @brief Declare a circular queue type 'name_t' of 'capacity' elements of 'type' and its functions:
+ *
+ *  - void    name_init(name_t *queue)                     : reset queue to empty
+ *  - size_t  name_count(name_t *queue)                    : number of elements stored
+ *  - bool    name_empty(name_t *queue)                    : check if queue is empty
+ *  - bool    name_full(name_t *queue)                     : check if queue is full
+ *  - bool    name_push(name_t *queue, const type *item)   : copy item at the end (producer side)
+ *  - bool    name_pop(name_t *queue, type *item)          : copy and remove oldest item (consumer side)
+ *  - type*   name_peek(name_t *queue)                     : pointer to oldest item or NULL (consumer side)
+ *  - type*   name_peek_at(name_t *queue, size_t idx)      : pointer to idx-th oldest item or NULL (consumer side)
+ *  - void    name_drop(name_t *queue)                     : remove oldest item, queue must not be empty (consumer side)
+ */
+#define CIRCULAR_QUEUE_DECLARE(name, type, capacity)                                            \
+                                                                                                \
+    _Static_assert(((capacity) > 0) && (((capacity) & ((capacity) - 1)) == 0),                  \
+                   #name " capacity must be a power of two");                                   \
+                                                                                                \
+    typedef struct                                                                              \
+    {                                                                                           \
+        type item[capacity];                                                                    \
+        atomic_size_t head;     /* producer index, only written by the producer */             \
+        atomic_size_t tail;     /* consumer index, only written by the consumer */             \
+    } name##_t;                                                                                 \
+                                                                                                \
+    static inline void name##_init(name##_t *queue)                                             \
+    {                                                                                           \
+        atomic_init(&queue->head, 0);                                                           \
+        atomic_init(&queue->tail, 0);                                                           \
+    }                                                                                           \
+                                                                                                \
+    static inline size_t name##_count(name##_t *queue)                                          \
+    {                                                                                           \
+        size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);                 \
+        size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);                 \
+        return head - tail;                                                                     \
+    }                                                                                           \
+                                                                                                \
+    static inline bool name##_empty(name##_t *queue)                                            \
+    {                                                                                           \
+        return (name##_count(queue) == 0);                                                      \
+    }                                                                                           \
+                                                                                                \
+    static inline bool name##_full(name##_t *queue)                                             \
+    {                                                                                           \
+        return (name##_count(queue) >= (capacity));                                             \
+    }                                                                                           \
+                                                                                                \
+    static inline bool name##_push(name##_t *queue, const type *item)                           \
+    {                                                                                           \
+        size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);                 \
+        size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);                 \
+                                                                                                \
+        if ((head - tail) >= (capacity))                                                        \
+        {                                                                                       \
+            return false;                                                                       \
+        }                                                                                       \
+                                                                                                \
+        queue->item[head & ((capacity) - 1)] = *item;                                           \
+        atomic_store_explicit(&queue->head, head + 1, memory_order_release);                    \
+        return true;                                                                            \
+    }                                                                                           \
+                                                                                                \
+    static inline type *name##_peek(name##_t *queue)                                            \
+    {                                                                                           \
+        size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);                 \
+        size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);                 \
+                                                                                                \
+        return (head == tail) ? NULL : &queue->item[tail & ((capacity) - 1)];                   \
+    }                                                                                           \
+                                                                                                \
+    static inline type *name##_peek_at(name##_t *queue, size_t idx)                            \
+    {                                                                                           \
+        size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);                 \
+        size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);                 \
+                                                                                                \
+        return (idx >= (head - tail)) ? NULL : &queue->item[(tail + idx) & ((capacity) - 1)];   \
+    }                                                                                           \
+                                                                                                \
+    static inline void name##_drop(name##_t *queue)                                             \
+    {                                                                                           \
+        size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);                 \
+        atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);                    \
+    }                                                                                           \
+                                                                                                \
+    static inline bool name##_pop(name##_t *queue, type *item)                                  \
+    {                                                                                           \
+        type *oldest = name##_peek(queue);                                                      \
+                                                                                                \
+        if (oldest == NULL)                                                                     \
+        {                                                                                       \
+            return false;                                                                       \
+        }                                                                                       \
+                                                                                                \
+        *item = *oldest;                                                                        \
+        name##_drop(queue);                                                                     \
+        return true;                                                                            \
+    }
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ * @file timestamp.h
+ * @brief  High resolution timestamps from the DWT cycle counter
+ * @version 0.1
+ *
+ * @note   Timestamps are free running core clock cycles, they wrap around every
+ *         2^32 / SystemCoreClock seconds (about 51 s at 84 MHz). Only differences between
+ *         timestamps taken less than a wraparound apart are meaningful.
+ */
+
+#ifndef _TIMESTAMP_H
+#define _TIMESTAMP_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stm32f4xx.h"
+
+/** Enable the DWT cycle counter, must be called before any timestamp is taken */
+void timestamp_init(void);
+
+/** Convert a number of cycles (difference between two timestamps) to microseconds */
+uint32_t timestamp_to_us(uint32_t cycles);
+
+/**
+ * @brief Return the current timestamp, callable from any context
+ */
+static inline uint32_t timestamp_now(void)
+{
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief Return the time elapsed since a timestamp, in cycles
+ */
+static inline uint32_t timestamp_elapsed(uint32_t timestamp)
+{
+    return DWT->CYCCNT - timestamp;
+}
+
+#endif
@@ -2,19 +2,146 @@
 #define UART_DRIVER_H
 
 #include "circular_buffer.h"
+#include "bip_buffer.h"
+#include "uart_rx_dma.h"
 #include "stm32f4xx_hal.h"
 
-#define MAX_DATA_CHUNK_SIZE     (100) 
+/**@brief Enable/Disable circular DMA reception with IDLE line detection.
+ * @note  When disabled, one byte is received per interrupt.
+ */
+#define UART_RX_DMA_ENABLE      (1)
+
+/**@brief Enable/Disable DMA transmission of the tx blocks (interrupt per byte otherwise) */
+#define UART_TX_DMA_ENABLE      (1)
+
+/**@brief Enable/Disable arrival timestamps of the received data, see uart_get_rx_timestamp() */
+#define UART_RX_TIMESTAMP_ENABLE (1)
+#define UART_RX_STAMP_QUEUE_SIZE (32)    /* chunks of the rx ring timestamped at once, power of two */
+
+/**@brief Enable/Disable each serial port, a disabled port keeps its pins free */
+#define UART_PORT_1_ENABLE      (1)
+#define UART_PORT_2_ENABLE      (1)
+#define UART_PORT_6_ENABLE      (1)
+
+/**@brief RS-485 half-duplex mode of each port, the transceiver driver is enabled with a GPIO
+ *        (USART1 PA8, USART6 PC8) while the port transmits.
+ * @note  The receiver enable (/RE) is expected to be tied to DE, so the port does not hear its
+ *        own frames. USART2 is wired to the ST-LINK virtual com port and has no DE pin.
+ */
+#define UART_PORT_1_RS485       (0)
+#define UART_PORT_6_RS485       (0)
+
+/**@brief Rx flow control of each port, see uart_flow_ctrl_t.
+ * @note  USART6 has no RTS/CTS pins on the STM32F411 packages, only in-band flow control.
+ */
+#define UART_PORT_1_FLOW_CTRL   UART_FLOW_CTRL_NONE
+#define UART_PORT_2_FLOW_CTRL   UART_FLOW_CTRL_NONE
+#define UART_PORT_6_FLOW_CTRL   UART_FLOW_CTRL_NONE
+
+/**@brief Max baudrate error accepted when a baudrate is requested, in percent */
+#define UART_BAUDRATE_MAX_ERROR_PCT (2)
+#define UART_BITS_PER_BYTE      (10)     /* start bit + 8 data bits + stop bit */
+
 #define RX_DATA_BUFF_SIZE       (512)
-#define TX_DATA_BUFF_SIZE       (512)
+#define TX_DATA_BUFF_SIZE       (1024)   /* bip buffer, a frame must fit in about half of it */
+
+/**@brief Rx ring levels of the flow control, the host is stopped when the ring reaches the high
+ *        watermark and resumed when it drains down to the low watermark.
+ * @note  With DMA reception the ring level is only updated on half/full transfer and IDLE events,
+ *        half of the ring may be received between two checks, so the high watermark must not
+ *        exceed half of the ring. RTS/CTS stops the host within a byte once it is reached.
+ */
+#define UART_RX_HIGH_WATERMARK  (RX_DATA_BUFF_SIZE / 2)
+#define UART_RX_LOW_WATERMARK   (RX_DATA_BUFF_SIZE / 4)
+
+/**@brief Max bytes received between two checks of the rx ring level */
+#if UART_RX_DMA_ENABLE
+#define UART_RX_LEVEL_CHECK_BYTES   (RX_DATA_BUFF_SIZE / 2)    /* half/full transfer events */
+#else
+#define UART_RX_LEVEL_CHECK_BYTES   (1)
+#endif
+
+/**@brief In-band flow control levels. Once the stop level is seen the host keeps sending until
+ *        the stop event reaches it and it reacts, UART_RX_IN_BAND_HEADROOM bytes are left for it
+ *        on top of the bytes received until the level is seen.
+ * @note  No byte is lost as long as the host stops within the headroom, which has to cover the
+ *        main loop latency, the tx block in flight ahead of the stop event and the host reaction
+ *        time, at the port baudrate. Otherwise the ring overruns and its content is dropped.
+ *        A larger ring raises the stop level.
+ */
+#define UART_RX_IN_BAND_HEADROOM        (128)
+#define UART_RX_IN_BAND_HIGH_WATERMARK  (RX_DATA_BUFF_SIZE - UART_RX_LEVEL_CHECK_BYTES - UART_RX_IN_BAND_HEADROOM)
+#define UART_RX_IN_BAND_LOW_WATERMARK   (UART_RX_IN_BAND_HIGH_WATERMARK / 2)
+
+_Static_assert(UART_RX_IN_BAND_HIGH_WATERMARK + UART_RX_LEVEL_CHECK_BYTES + UART_RX_IN_BAND_HEADROOM <= RX_DATA_BUFF_SIZE,
+               "in-band stop level leaves no room for the host to react");
+_Static_assert(UART_RX_IN_BAND_LOW_WATERMARK > 0, "rx ring too small for in-band flow control");
+
+/**
+ * @brief Serial ports available on the board, each one runs an independent link
+ */
+typedef enum
+{
+    UART_PORT_1,        /* USART1 : PA9 tx, PA10 rx */
+    UART_PORT_2,        /* USART2 : PA2 tx, PA3 rx (ST-LINK virtual com port) */
+    UART_PORT_6,        /* USART6 : PC6 tx, PC7 rx */
+    UART_PORT_CNT
+}uart_port_id_t;
+
+/**
+ * @brief Rx flow control modes
+ */
+typedef enum
+{
+    UART_FLOW_CTRL_NONE,    /* bytes that do not fit in the rx ring are dropped */
+    UART_FLOW_CTRL_RTS_CTS, /* hardware RTS/CTS, the reception is paused above the high watermark so RTS is released */
+    UART_FLOW_CTRL_IN_BAND, /* the link layer tells the host to stop and resume, see uart_rx_flow_is_stopped() and UART_RX_IN_BAND_HEADROOM */
+}uart_flow_ctrl_t;
+
+/**@brief Port used for debug messages and test procedures */
+#define UART_HOST_PORT          UART_PORT_2
+
+/**@brief Serial port object, it owns the uart handle and the rx/tx buffers (opaque) */
+typedef struct uart_port_t uart_port_t;
 
 uint8_t uart_init(void);
-uint8_t uart_get_rx_data_len(void);
-uint8_t uart_read_rx_data(uint8_t *data, uint8_t len);
-uint8_t uart_fetch_rx_data(uint8_t *data, uint8_t len);
-uint8_t uart_clear_rx_data(void);
-uint8_t uart_transmit(uint8_t *data, uint8_t len);
-uint8_t uart_transmit_it(uint8_t *data, uint8_t len);
-uint8_t uart_write_rx_data(uint8_t *data, uint8_t len);
-
-#endif
\ No newline at end of file
+uart_port_t *uart_get_port(uart_port_id_t id);
+size_t uart_get_rx_data_len(uart_port_t *port);
+uint8_t uart_read_rx_data(uart_port_t *port, uint8_t *data, size_t len);
+uint8_t uart_fetch_rx_data(uart_port_t *port, uint8_t *data, size_t len);
+uint8_t uart_fetch_rx_data_at(uart_port_t *port, size_t offset, uint8_t *data, size_t len);
+uint8_t uart_peek_rx_u32(uart_port_t *port, size_t offset, uint32_t *value);
+size_t uart_peek_rx_data(uart_port_t *port, circular_buff_region_t region[2]);
+uint8_t uart_commit_rx_data(uart_port_t *port, size_t len);
+uint8_t uart_get_rx_timestamp(uart_port_t *port, size_t offset, uint32_t *timestamp);
+uint8_t uart_find_rx_data(uart_port_t *port, const uint8_t *pattern, size_t pattern_len, size_t *offset);
+uint8_t uart_attach_rx_tap(uart_port_t *port, circular_buff_tap_t *tap, circular_buff_tap_mode_t mode);
+uint8_t uart_detach_rx_tap(circular_buff_tap_t *tap);
+uint8_t uart_clear_rx_data(uart_port_t *port);
+uint8_t uart_get_rx_stats(uart_port_t *port, circular_buff_stats_t *stats);
+uint8_t uart_get_tx_stats(uart_port_t *port, circular_buff_stats_t *stats);
+uint8_t uart_reset_stats(uart_port_t *port);
+uint8_t uart_transmit(uart_port_t *port, uint8_t *data, size_t len);
+uint8_t uart_transmit_it(uart_port_t *port, uint8_t *data, size_t len);
+uint8_t uart_transmit_itv(uart_port_t *port, const circular_buff_segment_t *segment, size_t segment_cnt);
+void uart_tx_service(uart_port_t *port);
+uint8_t uart_write_rx_data(uart_port_t *port, uint8_t *data, size_t len);
+uint8_t uart_check_baudrate(uart_port_t *port, uint32_t baudrate);
+uint8_t uart_set_baudrate(uart_port_t *port, uint32_t baudrate);
+uint32_t uart_get_baudrate(uart_port_t *port);
+uint32_t uart_bytes_to_ms(uart_port_t *port, size_t len);
+bool uart_is_tx_idle(uart_port_t *port);
+bool uart_is_rs485(uart_port_t *port);
+uart_flow_ctrl_t uart_get_flow_ctrl(uart_port_t *port);
+bool uart_rx_flow_is_stopped(uart_port_t *port);
+
+/**@brief Interrupt handlers, called from stm32f4xx_it.c with the port that owns the interrupt line */
+void uart_irq_handler(uart_port_id_t id);
+#if UART_RX_DMA_ENABLE
+void uart_rx_dma_irq_handler(uart_port_id_t id);
+#endif
+#if UART_TX_DMA_ENABLE
+void uart_tx_dma_irq_handler(uart_port_id_t id);
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * @file uart_rx_dma.h
+ * @brief  Publishing of bytes received by a circular DMA into a circular buffer
+ * @version 0.1
+ *
+ * @note   The DMA writes straight into the circular buffer memory, this module only turns the
+ *         DMA write position reported by the half/full transfer and IDLE line events into
+ *         producer commits. It does not depend on the HAL, the caller provides the position.
+ */
+
+#ifndef _UART_RX_DMA_H
+#define _UART_RX_DMA_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stdatomic.h"
+#include "circular_buffer.h"
+
+/**
+ * @brief  Circular DMA reception control block
+ * @struct uart_rx_dma_t
+ */
+typedef struct
+{
+    c_buff_handle_t cb;         /* circular buffer used as DMA memory, must be empty at init */
+    size_t pos;                 /* DMA write position already published */
+    atomic_bool overrun;        /* DMA overwrote data not yet consumed, publishing is stopped */
+    uint32_t overrun_cnt;       /* number of overruns detected */
+}uart_rx_dma_t;
+
+/** Initialize the DMA reception control block, the DMA must start writing at the beginning of the buffer */
+void uart_rx_dma_init(uart_rx_dma_t *rx_dma, c_buff_handle_t cb);
+
+/** Restart publishing after the buffer was reset and the DMA restarted at its beginning */
+void uart_rx_dma_restart(uart_rx_dma_t *rx_dma);
+
+/** Publish the bytes written by the DMA up to dma_pos (producer side, DMA event context) */
+size_t uart_rx_dma_publish(uart_rx_dma_t *rx_dma, size_t dma_pos);
+
+/** Check if an overrun stopped the publishing of received bytes */
+bool uart_rx_dma_is_overrun(uart_rx_dma_t *rx_dma);
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file frame_parser.h
+ * @brief  Streaming parser of the frame fields that follow the preamble
+ * @version 0.1
+ *
+ * @note   The parser takes the received bytes in chunks of any size, as they arrive. Header and
+ *         payload are copied to the packet and the CRC is accumulated in the same pass, so the
+ *         verdict is known as soon as the last postamble byte is fed. It does not depend on the
+ *         HAL, the caller provides the bytes.
+ *         A rolling window of the last 4 bytes tracks where the next preamble may start, so the
+ *         caller can keep only those bytes and hunt again from there if the frame is rejected.
+ */
+
+#ifndef _FRAME_PARSER_H
+#define _FRAME_PARSER_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+#include "protocol.h"
+
+/**
+ * @brief Frame field being parsed
+ */
+typedef enum
+{
+    FRAME_PARSER_FIELD_HEADER,
+    FRAME_PARSER_FIELD_PAYLOAD,
+    FRAME_PARSER_FIELD_CRC,
+    FRAME_PARSER_FIELD_POSTAMBLE,
+    FRAME_PARSER_FIELD_DONE,        /* verdict given, nothing else is parsed until the next frame */
+}frame_parser_field_t;
+
+/**
+ * @brief Result of feeding bytes to the parser, the parser stops at every field boundary
+ */
+typedef enum
+{
+    FRAME_PARSER_MORE,              /* field not complete, every byte fed was consumed */
+    FRAME_PARSER_HEADER_DONE,       /* header complete, to be checked before the payload is parsed */
+    FRAME_PARSER_PAYLOAD_DONE,      /* payload complete */
+    FRAME_PARSER_FRAME_OK,          /* last postamble byte parsed, crc and postamble ok */
+    FRAME_PARSER_HEADER_ERROR,      /* payload length above MAX_PAYLOAD_SIZE */
+    FRAME_PARSER_CRC_ERROR,         /* last postamble byte parsed, crc mismatch */
+    FRAME_PARSER_POSTAMBLE_ERROR,   /* postamble byte mismatch, the wrong byte is not consumed */
+}frame_parser_result_t;
+
+/**
+ * @brief  Streaming frame parser control block
+ * @struct frame_parser_t
+ */
+typedef struct
+{
+    packet_data_t *packet;          /* packet the header and payload are written to */
+    frame_parser_field_t field;     /* field being parsed */
+    size_t field_idx;               /* bytes of the field already parsed */
+    uint32_t crc;                   /* crc of the header and payload bytes parsed */
+    byte_t recv_crc;                /* crc field received */
+    uint32_t window;                /* last 4 bytes of the frame, starting with the preamble */
+    size_t resync_len;              /* bytes since the 2nd preamble byte where no preamble can start */
+    bool resync_found;              /* a preamble starts at resync_len, the window is not tracked any more */
+}frame_parser_t;
+
+/** Initialize the parser, header and payload of every frame are written to packet */
+void frame_parser_init(frame_parser_t *parser, packet_data_t *packet);
+
+/** Start a new frame, to be called once its preamble is found */
+void frame_parser_start(frame_parser_t *parser);
+
+/** Parse a chunk of received bytes, up to the end of the current field */
+frame_parser_result_t frame_parser_feed(frame_parser_t *parser, const uint8_t *data, size_t len, size_t *consumed);
+
+/** Get the number of bytes, from the 2nd preamble byte, that can not start a preamble */
+size_t frame_parser_get_resync_len(const frame_parser_t *parser);
+
+#endif
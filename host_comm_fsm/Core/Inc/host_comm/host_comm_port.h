@@ -0,0 +1,127 @@
+/**
+ * @file host_comm_port.h
+ * @author Bayron Cabrera (bayron.cabrera@titoma.com)
+ * @brief  Communication port, a serial port with its own rx and tx state machines
+ * @version 0.1
+ * 
+ * @note   Every port is an independent protocol endpoint, ports only share code. The rx fsm of
+ *         a port answers ACK/NACK through the tx fsm of the same port.
+ *
+ *         Baudrate negotiation:
+ *          1. host sends HOST_TO_TARGET_CMD_SET_BAUDRATE at the current baudrate, the target answers
+ *             TARGET_TO_HOST_RES_BAUDRATE with the baudrate to be used (current one if rejected).
+ *          2. once its answer is transmitted the target switches, the host switches on reception.
+ *          3. host sends HOST_TO_TARGET_CMD_BAUDRATE_PROBE at the new baudrate, the target echoes it.
+ *          4. if no probe is received within BAUDRATE_PROBE_TIMEOUT_MS the target falls back to the
+ *             previous baudrate, the host does the same if the probe is not answered.
+ *
+ *         In-band flow control (UART_FLOW_CTRL_IN_BAND): TARGET_TO_HOST_EVT_RX_FLOW_OFF is sent when
+ *         the rx buffer reaches UART_RX_IN_BAND_HIGH_WATERMARK and TARGET_TO_HOST_EVT_RX_FLOW_ON once
+ *         it drains, both ahead of any queued packet. The host must stop sending in between, within
+ *         UART_RX_IN_BAND_HEADROOM bytes, or received bytes are lost.
+ *
+ *         RS-485 bus (UART_PORT_x_RS485 and a node address): frames carry the node address, frames
+ *         for other nodes are dropped right after their header. A node only answers frames
+ *         addressed to it (ACK/NACK), then sends the packets queued since its last turn.
+ *         The host polls every node with HOST_TO_TARGET_CMD_POLL to collect them.
+ *
+ *         Command dispatch: every packet received is looked up by its type in a table of 256
+ *         entries shared by all ports, see host_comm_port_register_cmd(). Types without handler
+ *         or with a payload length out of the registered bounds are answered with
+ *         TARGET_TO_HOST_EVT_HANDLER_ERROR (payload: the type), unicast frames only.
+ */
+
+#ifndef HOST_COMM_PORT_H
+#define HOST_COMM_PORT_H
+
+#include "uart_driver.h"
+#include "host_comm_tx_fsm.h"
+#include "host_comm_rx_fsm.h"
+
+#define BAUDRATE_PROBE_TIMEOUT_MS   (200)   /* time for the host to switch and send the probe frame */
+
+/**@brief Enable/Disable draining the rx fsm of each port on every run, one reaction per run otherwise */
+#define HOST_COMM_PORT_RX_DRAIN_ENABLE  (1)
+#define HOST_COMM_PORT_DRAIN_MAX_BYTES  (RX_DATA_BUFF_SIZE / 2) /* bytes parsed per port and run, fairness with the other ports */
+
+/**@brief Bus address of the node on each port, PROTOCOL_ADDR_P2P on a point to point link */
+#ifndef HOST_COMM_PORT_1_NODE_ADDR
+#define HOST_COMM_PORT_1_NODE_ADDR  PROTOCOL_ADDR_P2P
+#endif
+#ifndef HOST_COMM_PORT_2_NODE_ADDR
+#define HOST_COMM_PORT_2_NODE_ADDR  PROTOCOL_ADDR_P2P
+#endif
+#ifndef HOST_COMM_PORT_6_NODE_ADDR
+#define HOST_COMM_PORT_6_NODE_ADDR  PROTOCOL_ADDR_P2P
+#endif
+
+/**@brief Command flags, see host_comm_port_register_cmd() */
+#define HOST_COMM_CMD_FLAG_NONE         (0x00)
+#define HOST_COMM_CMD_FLAG_BROADCAST    (0x01)  /* also handled when the frame is broadcast, no error reply then */
+
+/**
+ * @brief Baudrate negotiation states
+ * 
+ */
+typedef enum
+{
+    BAUDRATE_ST_IDLE,               /* no negotiation ongoing */
+    BAUDRATE_ST_SWITCH_PENDING,     /* new baudrate accepted, switch once the answer is transmitted */
+    BAUDRATE_ST_PROBE_WAIT,         /* new baudrate set, waiting for the host probe frame */
+}host_comm_baudrate_state_t;
+
+/**
+ * @brief Communication port data struct
+ * 
+ */
+typedef struct
+{
+    uart_port_t         *uart;  /* serial port, NULL if the port is not enabled */
+    host_comm_rx_fsm_t  rx;     /* rx comm state machine */
+    host_comm_tx_fsm_t  tx;     /* tx comm state machine */
+
+    struct
+    {
+        host_comm_baudrate_state_t state;
+        uint32_t requested;         /* baudrate accepted in the last request */
+        uint32_t fallback;          /* baudrate restored if the new one is not confirmed */
+        time_event_t probe_timeout;
+    }baudrate;
+
+    bool flow_off_sent;             /* in-band flow control, host was told to stop sending */
+
+    struct
+    {
+        uint32_t handled_cnt;       /* packets dispatched to their handler */
+        uint32_t rejected_cnt;      /* packets without handler or out of the payload bounds */
+        uint32_t last_cycles;       /* run time of the last handler, in timestamp cycles */
+        uint32_t max_cycles;        /* longest handler run time, in timestamp cycles */
+    }cmd;
+}host_comm_port_t;
+
+/**
+ * @brief Command handler, called with the packet received by a port. It can answer straight
+ *        through the tx fsm of the port. The packet is released once it returns.
+ */
+typedef void (*host_comm_cmd_handler_t)(host_comm_port_t *port, packet_data_t *packet);
+
+/**
+ * @brief Command dispatch table entry
+ * 
+ */
+typedef struct
+{
+    host_comm_cmd_handler_t handler;    /* NULL if the type is not handled */
+    uint16_t min_len;                   /* payload length bounds, both included */
+    uint16_t max_len;
+    uint8_t flags;                      /* HOST_COMM_CMD_FLAG_x */
+}host_comm_cmd_t;
+
+/**@Exported Functions*/
+void host_comm_port_init(void);
+host_comm_port_t *host_comm_port_get(uart_port_id_t id);
+uint32_t host_comm_port_run(void);
+void host_comm_port_time_event_update(void);
+uint8_t host_comm_port_register_cmd(uint8_t type, host_comm_cmd_handler_t handler, uint16_t min_len, uint16_t max_len, uint8_t flags);
+
+#endif
@@ -4,12 +4,21 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "time_event.h"
+#include "timestamp.h"
 #include "host_comm_tx_fsm.h"
+#include "frame_parser.h"
+#include "circular_queue.h"
 #include <string.h>
 
+/* Time allowed on top of the transfer time of the expected bytes at the current baudrate,
+ * counted from the arrival of the previous field */
 #define HEADER_BYTES_TIMEOUT_MS     (30)
+#define PAYLOAD_BYTES_TIMEOUT_MS    (5)
 #define POSTAMBLE_BYTES_TIMEOUT_MS  (5)
 
+/**@brief Packets received waiting to be processed while the next frames are parsed, power of two */
+#define HOST_COMM_RX_PACKET_POOL_SIZE (4)
+
 /*
  * Enum of states names in the statechart.
  */
@@ -21,6 +30,7 @@ typedef enum
     st_comm_rx_payload_proc,
     st_comm_rx_crc_and_postamble_proc,
     st_comm_rx_packet_ready,
+    st_comm_rx_skip_proc,
     st_comm_rx_last,
 } host_comm_rx_states_t;
 
@@ -33,11 +43,13 @@ typedef enum
     ev_int_preamble_ok,
     ev_int_header_ok,
     ev_int_header_error,
+    ev_int_header_skip,
     ev_int_payload_ok,
     ev_int_crc_and_postamble_ok,
     ev_int_postamble_error,
     ev_int_crc_error,
     ev_int_req_packet_ready,
+    ev_int_skip_done,
     ev_int_comm_rx_last,
 
 } host_comm_rx_internal_events_t;
@@ -49,7 +61,6 @@ typedef enum
 typedef enum
 {
     ev_ext_comm_rx_invalid,
-    ev_ext_comm_rx_packet_proccessed,
     ev_ext_comm_rx_last,
 
 }host_comm_rx_external_events_t;
@@ -62,6 +73,7 @@ typedef struct
     time_event_t header_timeout;
     time_event_t payload_timeout;
     time_event_t crc_and_postamble_timeout;
+    time_event_t skip_timeout;
 }host_comm_rx_time_events_t;
 
 
@@ -72,9 +84,34 @@ typedef struct
     host_comm_rx_time_events_t     time;
 }host_comm_rx_event_t;
 
+/**
+ * @brief Received packet, owned by the rx fsm while its frame is parsed, then by the consumer until
+ *        it is given back with host_comm_rx_fsm_release_packet()
+ */
 typedef struct
 {
     packet_data_t packet;
+    uint32_t arrival_end;       /* arrival time of the frame postamble, see timestamp.h */
+    protocol_addr_match_t addr_match; /* frame addressed to this node or to every node */
+}host_comm_rx_packet_t;
+
+/*@brief pointer typedef to received packet, the pool queues pass packets by reference */
+typedef host_comm_rx_packet_t* rx_packet_handle_t;
+
+CIRCULAR_QUEUE_DECLARE(host_comm_rx_packet_queue, rx_packet_handle_t, HOST_COMM_RX_PACKET_POOL_SIZE)
+
+typedef struct
+{
+    host_comm_rx_packet_t *slot; /* packet the frame is parsed into, taken from the free queue */
+    frame_parser_t parser;      /* parses the frame into the slot as its bytes arrive */
+    uint32_t arrival_start;     /* arrival time of the frame preamble, see timestamp.h */
+    uint32_t arrival_end;       /* arrival time of the last byte parsed, the postamble once the frame is ready */
+    size_t parse_offset;        /* bytes of the frame parsed and still held in the rx buffer */
+    size_t released;            /* bytes of the frame released, from the 2nd preamble byte */
+    size_t bytes_processed;     /* bytes hunted, parsed or skipped so far (wraps around), tells a reaction made progress */
+    protocol_addr_match_t addr_match; /* frame addressed to this node, to every node or to another one */
+    size_t skip_len;            /* bytes of a frame of another node left to be dropped */
+    uint32_t packet_cnt;        /* packets completed so far (wraps around) */
 }host_comm_rx_iface_t;
 
 /*! 
@@ -86,13 +123,20 @@ typedef struct
 	host_comm_rx_states_t      state;	
     host_comm_rx_event_t       event;
     host_comm_rx_iface_t       iface;
+    uart_port_t                *port;   /* serial port used for reception */
+    host_comm_tx_fsm_t         *tx;     /* tx fsm of the same port, used to answer ACK/NACK */
+    uint8_t                    node_addr; /* bus address of the node, PROTOCOL_ADDR_P2P on a point to point link */
+    host_comm_rx_packet_t      pool[HOST_COMM_RX_PACKET_POOL_SIZE]; /* packet buffers */
+    host_comm_rx_packet_queue_t free;   /* packets the rx fsm can parse a frame into */
+    host_comm_rx_packet_queue_t ready;  /* packets completed, in reception order, waiting for the consumer */
 } host_comm_rx_fsm_t;
 
-extern host_comm_rx_fsm_t host_comm_rx_handle;
-
 /**@Exported Functions*/
-void host_comm_rx_fsm_init(host_comm_rx_fsm_t* handle);
+void host_comm_rx_fsm_init(host_comm_rx_fsm_t* handle, uart_port_t *port, host_comm_tx_fsm_t *tx, uint8_t node_addr);
 void host_comm_rx_fsm_run(host_comm_rx_fsm_t* handle);
+uint32_t host_comm_rx_fsm_drain(host_comm_rx_fsm_t* handle, size_t *budget);
+host_comm_rx_packet_t *host_comm_rx_fsm_get_packet(host_comm_rx_fsm_t* handle);
+void host_comm_rx_fsm_release_packet(host_comm_rx_fsm_t* handle, host_comm_rx_packet_t *packet);
 
 void host_comm_rx_fsm_time_event_update(host_comm_rx_fsm_t *handle);
 bool host_comm_rx_fsm_is_active(const host_comm_rx_fsm_t* handle);
@@ -15,7 +15,7 @@
 #include "host_comm_tx_queue.h"
 
 #define MAX_NUM_OF_TRANSFER_RETRIES (2)
-#define MAX_ACK_TIMEOUT_MS          (50)
+#define MAX_ACK_TIMEOUT_MS          (50)     /* on top of the transfer time of the packet and its ACK */
 #define DBG_MSG_BUFF_SIZE           (200)
 
 
@@ -85,6 +85,7 @@ typedef struct
 {
     uint8_t retry_cnt;          /* counter for number of transmission retry */
     tx_request_t request;       /* tx request with the data to be transmitted */
+    host_comm_tx_queue_t queue; /* pending tx requests of this port */
 } host_comm_tx_iface_t;
 
 /**
@@ -96,33 +97,37 @@ typedef struct
 	host_comm_tx_states_t    state;	
     host_comm_tx_events_t    event;
     host_comm_tx_iface_t     iface;
+    uart_port_t              *port;     /* serial port used for transmission */
+    uint8_t                  node_addr; /* bus address of the node, PROTOCOL_ADDR_P2P on a point to point link */
+    bool                     bus_turn;  /* the host addressed the node, it may transmit */
 } host_comm_tx_fsm_t;
 
-extern host_comm_tx_fsm_t host_comm_tx_handle;
-
 /**@Exported Functions*/
-void host_comm_tx_fsm_init(host_comm_tx_fsm_t* handle);
+void host_comm_tx_fsm_init(host_comm_tx_fsm_t* handle, uart_port_t *port, uint8_t node_addr);
 void host_comm_tx_fsm_run(host_comm_tx_fsm_t* handle);
 void host_comm_tx_fsm_time_event_update(host_comm_tx_fsm_t *handle);
 void host_comm_tx_fsm_set_ext_event(host_comm_tx_fsm_t* handle, host_comm_tx_external_events_t event);
 
 /**@Miscellaneous */
-void crc32_accumulate(uint32_t *buff, size_t len, uint32_t *crc_value);
 uint8_t host_comm_tx_fsm_write_dbg_msg(host_comm_tx_fsm_t *handle, char *dbg_msg, bool ack_expected);
 uint8_t host_comm_tx_fsm_send_packet_no_payload(host_comm_tx_fsm_t *handle, uint8_t type, bool ack_expected);
+uint8_t host_comm_tx_fsm_send_packet(host_comm_tx_fsm_t *handle, uint8_t type, const uint8_t *payload, uint16_t len, bool ack_expected);
+uint8_t host_comm_tx_fsm_send_event_now(host_comm_tx_fsm_t *handle, uint8_t type);
+void host_comm_tx_fsm_grant_bus_turn(host_comm_tx_fsm_t *handle);
+bool host_comm_tx_fsm_is_idle(host_comm_tx_fsm_t *handle);
 
 
 /**
  * @}
  */
 
-#define host_comm_printf(format, ...)                                       \
+#define host_comm_printf(handle, format, ...)                               \
     do                                                                      \
     {                                                                       \
         char buff[DBG_MSG_BUFF_SIZE];                                       \
         size_t len = sprintf(buff, format, ##__VA_ARGS__);                  \
         buff[len] = '\0';                                                   \
-        host_comm_tx_fsm_write_dbg_msg(&host_comm_tx_handle, buff);         \
+        host_comm_tx_fsm_write_dbg_msg(handle, buff, false);                \
     } while (0)
 
 #endif
@@ -13,9 +13,21 @@
 #include "protocol.h"
 #include "stdint.h"
 #include "circular_buffer.h"
+#include "circular_queue.h"
 #include "stdbool.h"
 
+#ifndef TX_QUEUE_BUFF_SIZE
 #define TX_QUEUE_BUFF_SIZE       (1024)
+#endif
+#define TX_QUEUE_MAX_REQUESTS    (32)     /* must be a power of two */
+#ifndef TX_QUEUE_LOSSY_BUFF_SIZE
+#define TX_QUEUE_LOSSY_BUFF_SIZE (512)    /* lossy requests, oldest ones are dropped when full */
+#endif
+
+_Static_assert(TX_QUEUE_BUFF_SIZE >= MAX_PAYLOAD_SIZE, "tx queue payload buffer smaller than a payload");
+_Static_assert(TX_QUEUE_LOSSY_BUFF_SIZE >= CIRCULAR_BUFF_RECORD_HDR_SIZE + sizeof(packet_header_t) + MAX_PAYLOAD_SIZE,
+               "lossy buffer smaller than a lossy record");
+_Static_assert(sizeof(packet_header_t) + MAX_PAYLOAD_SIZE <= UINT16_MAX, "lossy record length is 16 bit");
 
 /**
  * @brief Enumeration of the process source that request a transmission
@@ -38,10 +50,45 @@ typedef struct
 
 }tx_request_t;
 
-void host_comm_tx_queue_init(void);
-size_t host_comm_tx_queue_get_pending_transfers(void);
-uint8_t host_comm_tx_queue_write_request(tx_request_t *tx_request);
-uint8_t host_comm_tx_queue_read_request(tx_request_t *tx_request);
-uint8_t host_comm_tx_queue_fetch_request(tx_request_t *tx_request);
+/**
+ * @brief Transmission request descriptor, the payload bytes are stored apart in the payload buffer
+ * 
+ */
+typedef struct
+{
+    tx_request_source_t src;  /*!< process that request a transmission */
+    bool ack_expected;        /*!< ACK response expected ? */
+    packet_header_t header;   /*!< packet header, header.payload_len bytes are waiting in the payload buffer */
+}tx_request_desc_t;
+
+CIRCULAR_QUEUE_DECLARE(tx_desc_queue, tx_request_desc_t, TX_QUEUE_MAX_REQUESTS)
+
+/**
+ * @brief Transmission queue data struct, one per communication port
+ * 
+ */
+typedef struct
+{ 
+    tx_desc_queue_t  desc;               /*!< queue of pending transmission request descriptors */
+    circular_buff_t  ctrl;               /*!< circular buffer control block */
+    c_buff_handle_t  cb;                 /*!< circular buffer that stores the payload data to be transmit  */
+    uint8_t buffer[TX_QUEUE_BUFF_SIZE];  /*!< buffer to store the payload data to be transmitted */     
+    circular_buff_t  lossy_ctrl;         /*!< lossy requests circular buffer control block */
+    c_buff_handle_t  lossy_cb;           /*!< circular buffer that stores lossy requests as header + payload records */
+    uint8_t lossy_buffer[TX_QUEUE_LOSSY_BUFF_SIZE]; /*!< buffer to store the lossy requests */
+}host_comm_tx_queue_t;
+
+void host_comm_tx_queue_init(host_comm_tx_queue_t *tx_queue);
+size_t host_comm_tx_queue_get_pending_transfers(host_comm_tx_queue_t *tx_queue);
+uint8_t host_comm_tx_queue_write_request(host_comm_tx_queue_t *tx_queue, tx_request_t *tx_request);
+uint8_t host_comm_tx_queue_write_lossy_request(host_comm_tx_queue_t *tx_queue, tx_request_t *tx_request);
+uint8_t host_comm_tx_queue_write_packet(host_comm_tx_queue_t *tx_queue, tx_request_source_t src, bool ack_expected,
+                                        const packet_header_t *header, const uint8_t *payload);
+uint8_t host_comm_tx_queue_write_lossy_packet(host_comm_tx_queue_t *tx_queue, const packet_header_t *header, const uint8_t *payload);
+uint8_t host_comm_tx_queue_read_request(host_comm_tx_queue_t *tx_queue, tx_request_t *tx_request);
+uint8_t host_comm_tx_queue_fetch_request(host_comm_tx_queue_t *tx_queue, tx_request_t *tx_request);
+void host_comm_tx_queue_get_stats(host_comm_tx_queue_t *tx_queue, circular_buff_stats_t *stats);
+void host_comm_tx_queue_get_lossy_stats(host_comm_tx_queue_t *tx_queue, circular_buff_stats_t *stats);
+void host_comm_tx_queue_reset_stats(host_comm_tx_queue_t *tx_queue);
 
 #endif
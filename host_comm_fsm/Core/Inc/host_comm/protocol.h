@@ -11,7 +11,13 @@
 #include "stdint.h"
 #include "stdio.h"
 
+/**@brief Max payload of a frame, it can be raised up to UINT16_MAX (16 bit payload_len) for bulk
+ *        transfers. The uart and tx queue buffers must hold a whole frame, it is checked at build time.
+ *        It can be overridden from the build (the host tests build a jumbo frame configuration).
+ */
+#ifndef MAX_PAYLOAD_SIZE
 #define MAX_PAYLOAD_SIZE	(256)
+#endif
 
 /* 1 byte = 256 possible cmd/res/evt */
 #define CMD_START   (0x00)
@@ -25,16 +31,24 @@
 #define TARGET_TO_HOST_DIR   (0xAA)
 #define HOST_TO_TARGET_DIR   (0xBB)
 
+/* Node addresses, used on a RS-485 multi-drop bus */
+#define PROTOCOL_ADDR_P2P       (0x00)  /* point to point link, the address is not checked */
+#define PROTOCOL_ADDR_BROADCAST (0xFF)  /* host to every node, nodes do not answer */
+
 /* Packet Format Sizes */
 #define PREAMBLE_SIZE_BYTES     sizeof(uint32_t)
 #define POSTAMBLE_SIZE_BYTES    sizeof(uint32_t)
 #define HEADER_SIZE_BYTES       sizeof(packet_header_t)
 #define CRC_SIZE_BYTES          sizeof(uint32_t)
+#define FRAME_OVERHEAD_BYTES    (PREAMBLE_SIZE_BYTES + HEADER_SIZE_BYTES + CRC_SIZE_BYTES + POSTAMBLE_SIZE_BYTES)
+#define MAX_FRAME_SIZE          (FRAME_OVERHEAD_BYTES + MAX_PAYLOAD_SIZE)
 
 /* Packet structure 
-    ------------------------------------------------------------------------------
-   | PREAMBLE : 2B | HEADER : 4B | PAYLOAD : [0 - 256]B | CRC : 4B | POSTAMBLE :4B| 
-    ------------------------------------------------------------------------------
+    -------------------------------------------------------------------------------------------
+   | PREAMBLE : 4B | HEADER : 6B | PAYLOAD : [0 - MAX_PAYLOAD_SIZE]B | CRC : 4B | POSTAMBLE : 4B |
+    -------------------------------------------------------------------------------------------
+
+   Header : | TYPE : 1B | DIR : 1B | PAYLOAD LEN : 2B (LE) | ADDR : 1B | RESERVED : 1B (0) |
 */
 
 /* Preamble / Postamble bytes */
@@ -63,11 +77,18 @@ typedef struct
         uint8_t evt;
     }type;
 
-    packet_dir_t  dir;
+    uint8_t  dir;           /* packet_dir_t, a single byte on the wire */
     uint16_t payload_len;
+    uint8_t  addr;          /* node the frame is sent to (host) or sent by (target) on a bus */
+    uint8_t  reserved;      /* sent as 0, keeps the header free of padding */
 
 }packet_header_t;
 
+/* The header is sent as it is laid out in memory, its layout is the wire format */
+_Static_assert(sizeof(packet_header_t) == 6, "packet header must be 6 bytes without padding");
+
+_Static_assert(MAX_PAYLOAD_SIZE <= UINT16_MAX, "payload_len is a 16 bit field");
+
 typedef struct
 {
 	uint8_t buffer[MAX_PAYLOAD_SIZE];
@@ -90,6 +111,9 @@ typedef enum
     HOST_TO_TARGET_CMD_TURN_ON_LED,
     HOST_TO_TARGET_CMD_TURN_OFF_LED,
     HOST_TO_TARGET_CMD_GET_FW_VERSION,
+    HOST_TO_TARGET_CMD_SET_BAUDRATE,    /* payload: uint32_t baudrate, answered at the current baudrate */
+    HOST_TO_TARGET_CMD_BAUDRATE_PROBE,  /* payload: any, echoed back, confirms a new baudrate */
+    HOST_TO_TARGET_CMD_POLL,            /* bus turn of the node, it sends the packets queued since its last turn */
     HOST_TO_TARGET_CMD_END = CMD_END
 }host_to_target_cmd_t;
 #define IS_HOST_TO_TARGET_CMD(cmd) ((cmd > HOST_TO_TARGET_CMD_START) && (cmd < HOST_TO_TARGET_CMD_END))
@@ -128,6 +152,8 @@ typedef enum
     TARGET_TO_HOST_EVT_START = EVT_START,
     TARGET_TO_HOST_EVT_HANDLER_ERROR,
     TARGET_TO_HOST_EVT_PRINT_DBG_MSG,
+    TARGET_TO_HOST_EVT_RX_FLOW_OFF,     /* in-band flow control: target rx buffer above high watermark, stop sending */
+    TARGET_TO_HOST_EVT_RX_FLOW_ON,      /* in-band flow control: target rx buffer drained, resume sending */
     TARGET_TO_HOST_EVT_END = EVT_END
 }target_to_host_evt_t;
 #define IS_TARGET_TO_HOST_EVT(evt) ((evt > TARGET_TO_HOST_EVT_START) && (evt < TARGET_TO_HOST_EVT_END))
@@ -141,6 +167,8 @@ typedef enum
     TARGET_TO_HOST_RES_LED_ON,
     TARGET_TO_HOST_RES_LED_OFF,
     TARGET_TO_HOST_RES_FW_VERSION,
+    TARGET_TO_HOST_RES_BAUDRATE,        /* payload: uint32_t baudrate to be used, the current one if rejected */
+    TARGET_TO_HOST_RES_BAUDRATE_PROBE,  /* payload: probe payload echoed */
     TARGET_TO_HOST_RES_END = RES_END
 }target_to_host_resp_t;
 #define IS_TARGET_TO_HOST_RES(res) ((res > TARGET_TO_HOST_RES_START) && (res < TARGET_TO_HOST_RES_END))
@@ -148,12 +176,25 @@ typedef enum
 
 /*##################################################################################################*/
 
+/**
+ * @brief Result of matching the address of a received frame against the node address
+ */
+typedef enum
+{
+    PROTOCOL_ADDR_MATCH_NONE,       /* frame for another node or sent by another node, dropped */
+    PROTOCOL_ADDR_MATCH_UNICAST,    /* frame for this node, answered with ACK/NACK */
+    PROTOCOL_ADDR_MATCH_BROADCAST,  /* frame for every node, processed without answer */
+}protocol_addr_match_t;
+
 extern const byte_t protocol_preamble;
 extern const byte_t protocol_postamble;
 
 void print_buff_ascii(uint8_t *buff, size_t len);
 void print_buff_hex(uint8_t *buff, size_t len);
 uint8_t protocol_check_valid_header(packet_data_t *packet);
+protocol_addr_match_t protocol_check_addr(const packet_header_t *header, uint8_t node_addr);
+void crc32_accumulate(const uint8_t *buff, size_t len, uint32_t *crc_value);
+void crc32_copy_accumulate(uint8_t *dst, const uint8_t *src, size_t len, uint32_t *crc_value);
 
 
 #endif
@@ -12,12 +12,15 @@
 #define TDD_H
 
 #include "protocol.h"
-#include "host_comm_tx_fsm.h"
-#include "host_comm_rx_fsm.h"
+#include "host_comm_port.h"
+
+/**@brief Enable/Disable the target benchmarks at startup, they block the main loop while they run */
+#define TDD_BENCH_ENABLE    (0)
 
 void rx_comm_test_0(void); // packet information
 void rx_comm_test_1(void); // testing frames
 void tx_comm_test_0(void); // testing tx ack retries
+void rx_comm_bench_0(void); // frame parser throughput and verdict latency
 
 
 
@@ -10,6 +10,26 @@
 #define USART_TX_GPIO_Port GPIOA
 #define USART_RX_Pin GPIO_PIN_3
 #define USART_RX_GPIO_Port GPIOA
+#define USART1_TX_Pin GPIO_PIN_9
+#define USART1_TX_GPIO_Port GPIOA
+#define USART1_RX_Pin GPIO_PIN_10
+#define USART1_RX_GPIO_Port GPIOA
+#define USART1_CTS_Pin GPIO_PIN_11
+#define USART1_CTS_GPIO_Port GPIOA
+#define USART1_RTS_Pin GPIO_PIN_12
+#define USART1_RTS_GPIO_Port GPIOA
+#define USART2_CTS_Pin GPIO_PIN_0
+#define USART2_CTS_GPIO_Port GPIOA
+#define USART2_RTS_Pin GPIO_PIN_1
+#define USART2_RTS_GPIO_Port GPIOA
+#define USART1_DE_Pin GPIO_PIN_8
+#define USART1_DE_GPIO_Port GPIOA
+#define USART6_TX_Pin GPIO_PIN_6
+#define USART6_TX_GPIO_Port GPIOC
+#define USART6_RX_Pin GPIO_PIN_7
+#define USART6_RX_GPIO_Port GPIOC
+#define USART6_DE_Pin GPIO_PIN_8
+#define USART6_DE_GPIO_Port GPIOC
 #define LD2_Pin GPIO_PIN_5
 #define LD2_GPIO_Port GPIOA
 #define TMS_Pin GPIO_PIN_13
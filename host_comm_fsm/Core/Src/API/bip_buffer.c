@@ -0,0 +1,315 @@
+/**
+ * @file bip_buffer.c
+ * @brief  Bip buffer (bipartite circular buffer) implementation
+ * @version 0.1
+ *
+ * @note   Unlike circular_buffer.c, every reservation and every read is a single contiguous
+ *         block, so a peripheral (IT or DMA) can work directly on the buffer memory. When a
+ *         reservation does not fit at the end of the buffer it starts again at the beginning,
+ *         the unused tail space is skipped by the reader using the 'last' index.
+ *         As the circular buffer, it is lock-free for a single producer and a single consumer.
+ */
+
+#include "bip_buffer.h"
+#include "string.h"
+
+/**
+ * @defgroup Bip_Buffer_Private_Functions
+ * @{
+ */
+
+/**
+ * @brief Return the number of bytes stored in bip buffer
+ *
+ * @param write write index
+ * @param last  end of the data before the write index wrapped
+ * @param read  read index
+ * @return size_t number of bytes stored
+ */
+static inline size_t buff_get_used(size_t write, size_t last, size_t read)
+{
+    return (write >= read) ? (write - read) : ((last - read) + write);
+}
+
+/**@} */
+
+/**
+ * @defgroup Bip_Buffer_Public_Functions
+ * @{
+ */
+
+/**
+ * @brief Initialize bip buffer in a control block provided by the caller.
+ *
+ * @param bip_buff pointer to a control block reserved in memory by the user
+ * @param buffer   pointer to a buffer reserved in memory by the user that is going to be register in bip buffer
+ * @param size     size of the buffer to be register.
+ * @return bip_buff_handle_t handle associated to the initialized bip buffer.
+ */
+bip_buff_handle_t bip_buff_init_static(bip_buff_t *bip_buff, uint8_t *buffer, size_t size)
+{
+    assert(bip_buff && buffer && size);
+
+    bip_buff->buffer = buffer;
+    bip_buff->length = size;
+    bip_buff->reserve_start = 0;
+    bip_buff->reserve_wrap = 0;
+    atomic_init(&bip_buff->write, 0);
+    atomic_init(&bip_buff->last, 0);
+    atomic_init(&bip_buff->read, 0);
+#if CIRCULAR_BUFF_STATS_ENABLE
+    memset(&bip_buff->stats, 0, sizeof(bip_buff->stats));
+#endif
+
+    return bip_buff;
+}
+
+/**
+ * @brief Reset bip buffer to default configuration
+ *
+ * @param bip_buff variable of type bip_buff_t* which contains the struct associated to the bip buffer
+ * @note  Producer and consumer must not be running at the same time.
+ */
+void bip_buff_reset(bip_buff_handle_t bip_buff)
+{
+    assert(bip_buff);
+
+    bip_buff->reserve_start = 0;
+    bip_buff->reserve_wrap = 0;
+    atomic_store_explicit(&bip_buff->write, 0, memory_order_relaxed);
+    atomic_store_explicit(&bip_buff->last, 0, memory_order_relaxed);
+    atomic_store_explicit(&bip_buff->read, 0, memory_order_release);
+}
+
+/**
+ * @brief Return the data available in bip buffer
+ *
+ * @param bip_buff variable of type bip_buff_t* which contains the struct associated to the bip buffer
+ * @return size_t return number of bytes in buffer, it may be split in two blocks.
+ */
+size_t bip_buff_get_data_len(bip_buff_handle_t bip_buff)
+{
+    assert(bip_buff);
+
+    size_t read = atomic_load_explicit(&bip_buff->read, memory_order_acquire);
+    size_t write = atomic_load_explicit(&bip_buff->write, memory_order_acquire);
+    size_t last = atomic_load_explicit(&bip_buff->last, memory_order_acquire);
+
+    return buff_get_used(write, last, read);
+}
+
+/**
+ * @brief Reserve a contiguous region to be written
+ *
+ * @param bip_buff variable of type bip_buff_t* which contains the struct associated to the bip buffer
+ * @param data_len number of bytes to be reserved
+ * @return uint8_t* pointer to the reserved region, NULL if there is no contiguous space for data_len bytes
+ * @note   Producer side operation. Data becomes visible to the consumer after bip_buff_commit_write().
+ *         In the worst case only about half of the buffer can be reserved in one block.
+ */
+uint8_t *bip_buff_reserve(bip_buff_handle_t bip_buff, size_t data_len)
+{
+    assert(bip_buff && bip_buff->buffer);
+
+    size_t write = atomic_load_explicit(&bip_buff->write, memory_order_relaxed);
+    size_t read = atomic_load_explicit(&bip_buff->read, memory_order_acquire);
+
+    if (write >= read)
+    {
+        if ((bip_buff->length - write) >= data_len)
+        {
+            bip_buff->reserve_start = write;
+            bip_buff->reserve_wrap = 0;
+            return &bip_buff->buffer[write];
+        }
+
+        /* Wrap, the write index must stay behind the read index to tell full from empty */
+        if (read > data_len)
+        {
+            bip_buff->reserve_start = 0;
+            bip_buff->reserve_wrap = 1;
+            return bip_buff->buffer;
+        }
+    }
+    else if ((read - write) > data_len)
+    {
+        bip_buff->reserve_start = write;
+        bip_buff->reserve_wrap = 0;
+        return &bip_buff->buffer[write];
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Publish data written in the region obtained with bip_buff_reserve()
+ *
+ * @param bip_buff variable of type bip_buff_t* which contains the struct associated to the bip buffer
+ * @param data_len number of bytes written, must not exceed the amount reserved
+ * @note  Producer side operation.
+ */
+void bip_buff_commit_write(bip_buff_handle_t bip_buff, size_t data_len)
+{
+    assert(bip_buff);
+
+    if (data_len == 0)
+    {
+        return;
+    }
+
+    size_t write = atomic_load_explicit(&bip_buff->write, memory_order_relaxed);
+    size_t last = atomic_load_explicit(&bip_buff->last, memory_order_relaxed);
+    size_t read = atomic_load_explicit(&bip_buff->read, memory_order_acquire);
+
+    if (bip_buff->reserve_wrap)
+    {
+        /* Region wrapped, 'last' must be visible before the consumer sees the write index behind it */
+        last = write;
+        atomic_store_explicit(&bip_buff->last, last, memory_order_release);
+    }
+
+    write = bip_buff->reserve_start + data_len;
+    atomic_store_explicit(&bip_buff->write, write, memory_order_release);
+
+#if CIRCULAR_BUFF_STATS_ENABLE
+    size_t used = buff_get_used(write, last, read);
+
+    bip_buff->stats.bytes_in += data_len;
+
+    if (used > bip_buff->stats.high_water)
+    {
+        bip_buff->stats.high_water = used;
+    }
+#endif
+}
+
+/**
+ * @brief Write an array of data segments as a single contiguous block
+ *
+ * @param bip_buff variable of type bip_buff_t* which contains the struct associated to the bip buffer
+ * @param segment array of data segments, copied in order
+ * @param segment_cnt number of segments in the array
+ * @return circular_buff_st_t CIRCULAR_BUFF_OK if all the segments were written,
+ *         CIRCUILAR_BUFF_NOT_ENOUGH_SPACE if none was written
+ */
+circular_buff_st_t bip_buff_writev(bip_buff_handle_t bip_buff, const circular_buff_segment_t *segment, size_t segment_cnt)
+{
+    assert(bip_buff && (segment || !segment_cnt));
+
+    size_t data_len = 0;
+
+    for (size_t seg_idx = 0; seg_idx < segment_cnt; seg_idx++)
+    {
+        data_len += segment[seg_idx].len;
+    }
+
+    uint8_t *block = bip_buff_reserve(bip_buff, data_len);
+
+    if (block == NULL)
+    {
+#if CIRCULAR_BUFF_STATS_ENABLE
+        bip_buff->stats.overflow_cnt++;
+        bip_buff->stats.bytes_dropped += data_len;
+#endif
+        return CIRCUILAR_BUFF_NOT_ENOUGH_SPACE;
+    }
+
+    for (size_t seg_idx = 0; seg_idx < segment_cnt; seg_idx++)
+    {
+        memcpy(block, segment[seg_idx].data, segment[seg_idx].len);
+        block += segment[seg_idx].len;
+    }
+
+    bip_buff_commit_write(bip_buff, data_len);
+
+    return CIRCULAR_BUFF_OK;
+}
+
+/**
+ * @brief Get the contiguous block with the oldest data available to be read
+ *
+ * @param bip_buff variable of type bip_buff_t* which contains the struct associated to the bip buffer
+ * @param data pointer to be set to the first byte of the block
+ * @return size_t number of bytes in the block, 0 if the buffer is empty.
+ * @note   Consumer side operation. The block stays valid until it is released with bip_buff_commit_read().
+ */
+size_t bip_buff_peek(bip_buff_handle_t bip_buff, uint8_t **data)
+{
+    assert(bip_buff && bip_buff->buffer && data);
+
+    size_t read = atomic_load_explicit(&bip_buff->read, memory_order_relaxed);
+    size_t write = atomic_load_explicit(&bip_buff->write, memory_order_acquire);
+
+    if (write < read)
+    {
+        size_t last = atomic_load_explicit(&bip_buff->last, memory_order_acquire);
+
+        if (read < last)
+        {
+            *data = &bip_buff->buffer[read];
+            return last - read;
+        }
+
+        /* Data up to 'last' already consumed, continue from the beginning */
+        read = 0;
+        atomic_store_explicit(&bip_buff->read, read, memory_order_release);
+    }
+
+    *data = &bip_buff->buffer[read];
+    return write - read;
+}
+
+/**
+ * @brief Consume data previously accessed with bip_buff_peek()
+ *
+ * @param bip_buff variable of type bip_buff_t* which contains the struct associated to the bip buffer
+ * @param data_len number of bytes to be consumed, must not exceed the amount returned by the last peek
+ * @note   Consumer side operation.
+ */
+void bip_buff_commit_read(bip_buff_handle_t bip_buff, size_t data_len)
+{
+    assert(bip_buff);
+
+    size_t read = atomic_load_explicit(&bip_buff->read, memory_order_relaxed);
+
+    atomic_store_explicit(&bip_buff->read, read + data_len, memory_order_release);
+
+#if CIRCULAR_BUFF_STATS_ENABLE
+    bip_buff->stats.bytes_out += data_len;
+#endif
+}
+
+/**
+ * @brief Get usage statistics of bip buffer
+ *
+ * @param bip_buff variable of type bip_buff_t* which contains the struct associated to the bip buffer
+ * @param stats    pointer to a struct to be filled with the statistics, zeroed if statistics are disabled.
+ */
+void bip_buff_get_stats(bip_buff_handle_t bip_buff, circular_buff_stats_t *stats)
+{
+    assert(bip_buff && stats);
+
+#if CIRCULAR_BUFF_STATS_ENABLE
+    *stats = bip_buff->stats;
+#else
+    memset(stats, 0, sizeof(circular_buff_stats_t));
+#endif
+}
+
+/**
+ * @brief Reset usage statistics of bip buffer, high-water mark restarts from the current data length
+ *
+ * @param bip_buff variable of type bip_buff_t* which contains the struct associated to the bip buffer
+ * @note  Counters written by an ongoing producer/consumer update may be lost.
+ */
+void bip_buff_reset_stats(bip_buff_handle_t bip_buff)
+{
+    assert(bip_buff);
+
+#if CIRCULAR_BUFF_STATS_ENABLE
+    memset(&bip_buff->stats, 0, sizeof(bip_buff->stats));
+    bip_buff->stats.high_water = bip_buff_get_data_len(bip_buff);
+#endif
+}
+
+/**@} */
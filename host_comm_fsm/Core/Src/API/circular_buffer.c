@@ -4,60 +4,440 @@
  * @brief  	Circular buffer implementation
  * @version 0.1
  * @date 2019-07-30
+ * 
+ * @note   The buffer is lock-free for a single producer and a single consumer (e.g. an ISR
+ *         writing and the main loop reading). The producer only writes the head index and the
+ *         consumer only writes the tail index, both are published with release semantics and
+ *         observed with acquire semantics, so neither side needs to mask interrupts.
+ *
+ *         Record functions store length prefixed records. circular_buff_overwrite_record() lets
+ *         the producer advance the tail to drop the oldest records, so it is moved with
+ *         compare-and-swap and a buffer written in overwrite mode must only be consumed with
+ *         circular_buff_read_record().
+ *
+ *         Broadcast taps are extra readers with their own cursor. Gating taps hold back the
+ *         producer like the tail does, lapped taps are never waited for and skip forward when
+ *         the data under their cursor is released. Taps are not supported in record overwrite mode.
  */
 
 #include "circular_buffer.h"
+#include "string.h"
+
+/**
+ * @defgroup Circular_Buffer_Private_Functions
+ * @{
+ */
 
 /**
- * @brief  Circular buffer data struct
- * @note   The definition of our circular buffer structure is hidden from the user
- * @struct circular_buff_t
+ * @brief Convert a free running index into a position inside the buffer
  * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param idx    free running index
+ * @return size_t position inside the buffer
  */
-struct circular_buff_t
+static inline size_t idx_pos(c_buff_handle_t c_buff, size_t idx)
 {
-    uint8_t *buffer;
-    size_t head;
-    size_t tail;
-    size_t length;
-    uint8_t full;
-};
+#if CIRCULAR_BUFF_POW2_MODE
+    return idx & (c_buff->length - 1);
+#else
+    return idx % c_buff->length;
+#endif
+}
 
 /**
- * @defgroup Circular_Buffer_Private_Functions
- * @{
+ * @brief Advance a free running index by n positions
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param idx    free running index
+ * @param n      number of positions to advance
+ * @return size_t advanced index
  */
+static inline size_t idx_advance(c_buff_handle_t c_buff, size_t idx, size_t n)
+{
+#if CIRCULAR_BUFF_POW2_MODE
+    /* Natural overflow keeps positions consistent because length divides SIZE_MAX + 1 */
+    (void)c_buff;
+    return idx + n;
+#else
+    idx += n;
+    return (idx >= c_buff->limit) ? (idx - c_buff->limit) : idx;
+#endif
+}
 
 /**
- * @brief Advance head pointer by 1 position
+ * @brief Return the number of positions from index 'from' up to index 'to'
  * 
  * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param to     free running index (head side)
+ * @param from   free running index (tail side)
+ * @return size_t distance between both indexes
  */
-static void head_ptr_advance(c_buff_handle_t c_buff)
+static inline size_t idx_distance(c_buff_handle_t c_buff, size_t to, size_t from)
 {
-    assert(c_buff);
+#if CIRCULAR_BUFF_POW2_MODE
+    (void)c_buff;
+    return to - from;
+#else
+    return (to >= from) ? (to - from) : (to + (c_buff->limit - from));
+#endif
+}
+
+/**
+ * @brief Get the oldest index the producer must preserve, the tail or the cursor of a gating
+ *        tap that is behind it
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param head   current producer index
+ * @return size_t oldest index still in use
+ */
+static inline size_t buff_get_oldest(c_buff_handle_t c_buff, size_t head)
+{
+    size_t oldest = atomic_load_explicit(&c_buff->tail, memory_order_acquire);
+    size_t used = idx_distance(c_buff, head, oldest);
 
-    if (c_buff->full)
+    for (circular_buff_tap_t *tap = atomic_load_explicit(&c_buff->taps, memory_order_acquire); tap != NULL; tap = tap->next)
     {
-        c_buff->tail = (c_buff->tail + 1) % c_buff->length;
+        if (tap->mode == CIRCULAR_BUFF_TAP_GATING)
+        {
+            size_t cursor = atomic_load_explicit(&tap->cursor, memory_order_acquire);
+
+            if (idx_distance(c_buff, head, cursor) > used)
+            {
+                oldest = cursor;
+                used = idx_distance(c_buff, head, cursor);
+            }
+        }
     }
 
-    // We mark full because we will advance tail on the next time around
-    c_buff->head = (c_buff->head + 1) % c_buff->length;
-    c_buff->full = (c_buff->head == c_buff->tail);
+    return oldest;
 }
 
 /**
- * @brief Retreat tail pointer by 1 position
+ * @brief Update statistics after data is written in the buffer
  * 
  * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param data_len number of bytes written
+ * @param used     number of bytes stored in the buffer after the write
  */
-static void tail_ptr_retreat(c_buff_handle_t c_buff)
+static inline void stats_on_write(c_buff_handle_t c_buff, size_t data_len, size_t used)
 {
-    assert(c_buff);
+#if CIRCULAR_BUFF_STATS_ENABLE
+    c_buff->stats.bytes_in += data_len;
+
+    if (used > c_buff->stats.high_water)
+    {
+        c_buff->stats.high_water = used;
+    }
+#endif
+}
+
+/**
+ * @brief Update statistics after a write is rejected for lack of space
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param data_len number of bytes rejected
+ */
+static inline void stats_on_overflow(c_buff_handle_t c_buff, size_t data_len)
+{
+#if CIRCULAR_BUFF_STATS_ENABLE
+    c_buff->stats.overflow_cnt++;
+    c_buff->stats.bytes_dropped += data_len;
+#endif
+}
+
+/**
+ * @brief Update statistics after the oldest record is dropped to make room for a new one
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param rec_len number of bytes dropped, length prefix included
+ */
+static inline void stats_on_record_drop(c_buff_handle_t c_buff, size_t rec_len)
+{
+#if CIRCULAR_BUFF_STATS_ENABLE
+    c_buff->stats.records_dropped++;
+    c_buff->stats.bytes_dropped += rec_len;
+#endif
+}
+
+/**
+ * @brief Update statistics after data is consumed from the buffer
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param data_len number of bytes consumed
+ */
+static inline void stats_on_read(c_buff_handle_t c_buff, size_t data_len)
+{
+#if CIRCULAR_BUFF_STATS_ENABLE
+    c_buff->stats.bytes_out += data_len;
+#endif
+}
+
+/**
+ * @brief Copy data into the buffer starting at index, in at most two contiguous segments.
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param idx    buffer index where the first byte is written
+ * @param data   pointer to the data to be copied
+ * @param data_len number of bytes to be copied, must not exceed the buffer length
+ */
+static void buff_copy_in(c_buff_handle_t c_buff, size_t idx, const uint8_t *data, size_t data_len)
+{
+    size_t first_seg = c_buff->length - idx;
+
+    if (first_seg > data_len)
+    {
+        first_seg = data_len;
+    }
+
+    memcpy(&c_buff->buffer[idx], data, first_seg);
+    memcpy(c_buff->buffer, &data[first_seg], data_len - first_seg);
+}
+
+/**
+ * @brief Copy data out of the buffer starting at index, in at most two contiguous segments.
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param idx    buffer index of the first byte to be copied
+ * @param data   pointer to a buffer to be filled
+ * @param data_len number of bytes to be copied, must not exceed the buffer length
+ */
+static void buff_copy_out(c_buff_handle_t c_buff, size_t idx, uint8_t *data, size_t data_len)
+{
+    size_t first_seg = c_buff->length - idx;
+
+    if (first_seg > data_len)
+    {
+        first_seg = data_len;
+    }
+
+    memcpy(data, &c_buff->buffer[idx], first_seg);
+    memcpy(&data[first_seg], c_buff->buffer, data_len - first_seg);
+}
+
+/**
+ * @brief Split len bytes starting at index in at most two contiguous regions.
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param idx    buffer index of the first byte of the regions
+ * @param len    total number of bytes, must not exceed the buffer length
+ * @param region array of two regions to be filled, unused regions are set to zero length
+ */
+static void buff_get_regions(c_buff_handle_t c_buff, size_t idx, size_t len, circular_buff_region_t region[2])
+{
+    size_t first_seg = c_buff->length - idx;
+
+    if (first_seg > len)
+    {
+        first_seg = len;
+    }
+
+    region[0].data = &c_buff->buffer[idx];
+    region[0].len = first_seg;
+    region[1].data = c_buff->buffer;
+    region[1].len = len - first_seg;
+}
+
+/**
+ * @brief Compare a pattern against the data found at an offset of the readable regions
+ * 
+ * @param region  readable regions of the buffer
+ * @param offset  offset of the first byte to be compared, offset + len must not exceed the data available
+ * @param pattern pointer to the pattern
+ * @param len     pattern length in bytes
+ * @return uint8_t return 1 if data matches the pattern, return 0 otherwise.
+ */
+static uint8_t regions_match(const circular_buff_region_t region[2], size_t offset, const uint8_t *pattern, size_t len)
+{
+    size_t first_seg = 0;
+
+    if (offset < region[0].len)
+    {
+        first_seg = region[0].len - offset;
+        first_seg = (first_seg > len) ? len : first_seg;
+
+        if (memcmp(&region[0].data[offset], pattern, first_seg) != 0)
+        {
+            return 0;
+        }
+
+        offset = 0;
+    }
+    else
+    {
+        offset -= region[0].len;
+    }
+
+    return (memcmp(&region[1].data[offset], &pattern[first_seg], len - first_seg) == 0);
+}
+
+/**
+ * @brief Read the length prefix of the record starting at index
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param idx    free running index of the record
+ * @return size_t record data length, length prefix excluded
+ */
+static size_t record_get_len(c_buff_handle_t c_buff, size_t idx)
+{
+    uint16_t rec_len;
+
+    buff_copy_out(c_buff, idx_pos(c_buff, idx), (uint8_t *)&rec_len, sizeof(rec_len));
+    return rec_len;
+}
+
+/**
+ * @brief Write a length prefixed record built from an array of data segments
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param segment array of data segments, concatenated in order
+ * @param segment_cnt number of segments in the array
+ * @param overwrite if 1, oldest whole records are dropped until the new record fits
+ * @return circular_buff_st_t CIRCULAR_BUFF_OK if the record was written
+ */
+static circular_buff_st_t record_write(c_buff_handle_t c_buff, const circular_buff_segment_t *segment, size_t segment_cnt, uint8_t overwrite)
+{
+    assert(c_buff && c_buff->buffer && (segment || !segment_cnt));
+
+    size_t data_len = 0;
+
+    for (size_t seg_idx = 0; seg_idx < segment_cnt; seg_idx++)
+    {
+        data_len += segment[seg_idx].len;
+    }
+
+    size_t rec_len = CIRCULAR_BUFF_RECORD_HDR_SIZE + data_len;
+
+    if ((data_len > UINT16_MAX) || (rec_len > c_buff->length))
+    {
+        stats_on_overflow(c_buff, data_len);
+        return CIRCUILAR_BUFF_NOT_ENOUGH_SPACE;
+    }
+
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&c_buff->tail, memory_order_acquire);
+
+    while ((c_buff->length - idx_distance(c_buff, head, tail)) < rec_len)
+    {
+        if (!overwrite)
+        {
+            stats_on_overflow(c_buff, data_len);
+            return CIRCUILAR_BUFF_NOT_ENOUGH_SPACE;
+        }
+
+        /* Records are always complete before head is published, so tail is a record boundary */
+        size_t old_len = CIRCULAR_BUFF_RECORD_HDR_SIZE + record_get_len(c_buff, tail);
+        size_t next_tail = idx_advance(c_buff, tail, old_len);
+
+        /* On failure the consumer released records meanwhile and tail is reloaded */
+        if (atomic_compare_exchange_strong_explicit(&c_buff->tail, &tail, next_tail,
+                                                    memory_order_acq_rel, memory_order_acquire))
+        {
+            tail = next_tail;
+            stats_on_record_drop(c_buff, old_len);
+        }
+    }
+
+    uint16_t rec_hdr = (uint16_t)data_len;
+    size_t idx = head;
+
+    buff_copy_in(c_buff, idx_pos(c_buff, idx), (const uint8_t *)&rec_hdr, sizeof(rec_hdr));
+    idx = idx_advance(c_buff, idx, sizeof(rec_hdr));
+
+    for (size_t seg_idx = 0; seg_idx < segment_cnt; seg_idx++)
+    {
+        buff_copy_in(c_buff, idx_pos(c_buff, idx), segment[seg_idx].data, segment[seg_idx].len);
+        idx = idx_advance(c_buff, idx, segment[seg_idx].len);
+    }
+
+    atomic_store_explicit(&c_buff->head, idx, memory_order_release);
+    stats_on_write(c_buff, rec_len, idx_distance(c_buff, idx, tail));
+
+    return CIRCULAR_BUFF_OK;
+}
+
+/**
+ * @brief Copy the oldest record, and optionally remove it
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param data      pointer to a buffer to be filled with the record data
+ * @param data_size size of the data buffer in bytes
+ * @param data_len  record data length, also set when the record does not fit in data_size
+ * @param consume   if 1, the record is removed from the buffer
+ * @return uint8_t return 1 if a record was copied, return 0 otherwise.
+ * @note   The producer may overwrite the record while it is copied. The copy is only accepted if
+ *         tail did not move meanwhile, otherwise the new oldest record is copied.
+ */
+static uint8_t record_read(c_buff_handle_t c_buff, uint8_t *data, size_t data_size, size_t *data_len, uint8_t consume)
+{
+    assert(c_buff && c_buff->buffer && data && data_len);
 
-    c_buff->full = 0;
-    c_buff->tail = (c_buff->tail + 1) % c_buff->length;
+    for (;;)
+    {
+        size_t tail = atomic_load_explicit(&c_buff->tail, memory_order_acquire);
+        size_t head = atomic_load_explicit(&c_buff->head, memory_order_acquire);
+
+        if (head == tail)
+        {
+            *data_len = 0;
+            return 0;
+        }
+
+        size_t rec_data_len = record_get_len(c_buff, tail);
+        size_t rec_len = CIRCULAR_BUFF_RECORD_HDR_SIZE + rec_data_len;
+        uint8_t valid = (rec_len <= idx_distance(c_buff, head, tail)) && (rec_data_len <= data_size);
+
+        if (valid)
+        {
+            buff_copy_out(c_buff, idx_pos(c_buff, idx_advance(c_buff, tail, CIRCULAR_BUFF_RECORD_HDR_SIZE)), data, rec_data_len);
+        }
+
+        if (consume && valid)
+        {
+            /* Success proves the producer did not drop the record while it was copied */
+            if (atomic_compare_exchange_strong_explicit(&c_buff->tail, &tail, idx_advance(c_buff, tail, rec_len),
+                                                        memory_order_acq_rel, memory_order_relaxed))
+            {
+                *data_len = rec_data_len;
+                stats_on_read(c_buff, rec_len);
+                return 1;
+            }
+            continue;
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+
+        if (atomic_load_explicit(&c_buff->tail, memory_order_relaxed) == tail)
+        {
+            *data_len = rec_data_len;
+            return valid;
+        }
+    }
+}
+
+/**
+ * @brief Move a lapped tap cursor forward if the data under it was released by the other readers
+ * 
+ * @param tap    broadcast tap in CIRCULAR_BUFF_TAP_LAPPED mode
+ * @param head   producer index observed by the tap reader
+ * @param cursor tap cursor, updated if the tap was lapped
+ * @return uint8_t return 1 if the tap was lapped, return 0 otherwise.
+ */
+static uint8_t tap_check_lapped(circular_buff_tap_t *tap, size_t head, size_t *cursor)
+{
+    c_buff_handle_t c_buff = tap->c_buff;
+    size_t oldest = buff_get_oldest(c_buff, head);
+
+    if (idx_distance(c_buff, head, *cursor) <= idx_distance(c_buff, head, oldest))
+    {
+        return 0;
+    }
+
+    tap->stats.lap_cnt++;
+    tap->stats.bytes_lost += idx_distance(c_buff, oldest, *cursor);
+    *cursor = oldest;
+    atomic_store_explicit(&tap->cursor, oldest, memory_order_release);
+
+    return 1;
 }
 
 /**@} */
@@ -77,7 +457,7 @@ uint8_t circular_buff_empty(c_buff_handle_t c_buff)
 {
     assert(c_buff);
 
-    return (!c_buff->full && (c_buff->tail == c_buff->head));
+    return (circular_buff_get_data_len(c_buff) == 0);
 }
 
 /**
@@ -90,7 +470,7 @@ uint8_t circular_buff_full(c_buff_handle_t c_buff)
 {
     assert(c_buff);
 
-    return c_buff->full;
+    return (circular_buff_get_free_space(c_buff) == 0);
 }
 
 /**
@@ -99,17 +479,40 @@ uint8_t circular_buff_full(c_buff_handle_t c_buff)
  * @param buffer  pointer to a buffer reserved in memory by the user that is going to be register in circular buffer
  * @param size    size of the buffer to be register.
  * @param c_buff variable of type circular_buff_t* which contains the struct associated to the initialized circular buffer.
+ * @note  The control block is allocated in heap, see circular_buff_init_static() for a heap-free alternative.
  */
 c_buff_handle_t circular_buff_init(uint8_t *buffer, size_t size)
 {
-    assert(buffer && size);
-
     c_buff_handle_t c_buff = malloc(sizeof(circular_buff_t));
     assert(c_buff);
 
+    return circular_buff_init_static(c_buff, buffer, size);
+}
+
+/**
+ * @brief Initialize Circular buffer in a control block provided by the caller.
+ * 
+ * @param c_buff  pointer to a control block reserved in memory by the user (e.g. with CIRCULAR_BUFF_DEF)
+ * @param buffer  pointer to a buffer reserved in memory by the user that is going to be register in circular buffer
+ * @param size    size of the buffer to be register.
+ * @return c_buff_handle_t handle associated to the initialized circular buffer.
+ */
+c_buff_handle_t circular_buff_init_static(circular_buff_t *c_buff, uint8_t *buffer, size_t size)
+{
+    assert(c_buff && buffer && size);
+#if CIRCULAR_BUFF_POW2_MODE
+    assert((size & (size - 1)) == 0);
+#endif
+
     c_buff->buffer = buffer;
     c_buff->length = size;
-    circular_buff_reset(c_buff);
+    c_buff->limit = size * ((SIZE_MAX / 2) / size);
+    atomic_init(&c_buff->head, 0);
+    atomic_init(&c_buff->tail, 0);
+    atomic_init(&c_buff->taps, NULL);
+#if CIRCULAR_BUFF_STATS_ENABLE
+    memset(&c_buff->stats, 0, sizeof(c_buff->stats));
+#endif
 
     assert(circular_buff_empty(c_buff));
 
@@ -117,9 +520,10 @@ c_buff_handle_t circular_buff_init(uint8_t *buffer, size_t size)
 }
 
 /**
- * @brief Deallocate an specified circular buffer handler 
+ * @brief Deallocate an specified circular buffer handler
  * 
  * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @note  Only for handlers obtained with circular_buff_init()
  */
 void circular_buff_free(c_buff_handle_t c_buff)
 {
@@ -131,13 +535,36 @@ void circular_buff_free(c_buff_handle_t c_buff)
  * @brief Reset Circular buffer to default configuration
  * 
  * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @note  Both indexes and the tap cursors are written, producer and readers must not be running
+ *        at the same time. Use circular_buff_flush() to drop data from the consumer side.
  */
 void circular_buff_reset(c_buff_handle_t c_buff)
 {
     assert(c_buff);
-    c_buff->head = 0;
-    c_buff->tail = 0;
-    c_buff->full = 0;
+    atomic_store_explicit(&c_buff->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&c_buff->tail, 0, memory_order_release);
+
+    for (circular_buff_tap_t *tap = atomic_load_explicit(&c_buff->taps, memory_order_acquire); tap != NULL; tap = tap->next)
+    {
+        atomic_store_explicit(&tap->cursor, 0, memory_order_release);
+    }
+}
+
+/**
+ * @brief Discard all the data available in circular buffer
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @note  Consumer side operation, it is safe while the producer keeps writing.
+ */
+void circular_buff_flush(c_buff_handle_t c_buff)
+{
+    assert(c_buff);
+
+    size_t tail = atomic_load_explicit(&c_buff->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_acquire);
+
+    stats_on_read(c_buff, idx_distance(c_buff, head, tail));
+    atomic_store_explicit(&c_buff->tail, head, memory_order_release);
 }
 
 /**
@@ -150,28 +577,17 @@ size_t circular_buff_get_data_len(c_buff_handle_t c_buff)
 {
     assert(c_buff);
 
-    size_t size = c_buff->length;
-
-    if (!c_buff->full)
-    {
-        if (c_buff->head >= c_buff->tail)
-        {
-            size = (c_buff->head - c_buff->tail);
-        }
-        else
-        {
-            size = (c_buff->length + c_buff->head - c_buff->tail);
-        }
-    }
+    size_t tail = atomic_load_explicit(&c_buff->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_acquire);
 
-    return size;
+    return idx_distance(c_buff, head, tail);
 }
 
 /**
- * @brief Return the capacity of the circular buffer 
+ * @brief Return the capacity of the circular buffer
  * 
  * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
- * @return size_t return length of the buffer registered in circular buffer 
+ * @return size_t return length of the buffer registered in circular buffer
  */
 size_t circular_buff_capacity(c_buff_handle_t c_buff)
 {
@@ -180,15 +596,19 @@ size_t circular_buff_capacity(c_buff_handle_t c_buff)
 }
 
 /**
- * @brief Return the free space available in circular buffer 
+ * @brief Return the free space available in circular buffer
  * 
  * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
- * @return size_t return the number of bytes available in circular buffer 
+ * @return size_t return the number of bytes available in circular buffer
+ * @note  Data not yet read by a gating tap is not free.
  */
 size_t circular_buff_get_free_space(c_buff_handle_t c_buff)
 {
     assert(c_buff);
-    return (c_buff->length - circular_buff_get_data_len(c_buff));
+
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_acquire);
+
+    return (c_buff->length - idx_distance(c_buff, head, buff_get_oldest(c_buff, head)));
 }
 
 /**
@@ -196,18 +616,32 @@ size_t circular_buff_get_free_space(c_buff_handle_t c_buff)
  * 
  * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
  * @param data byte to be written in buffer.
+ * @return uint8_t  return 0 if the buffer is full and the byte was dropped, return 1 otherwise.
  */
-void circular_buff_put(c_buff_handle_t c_buff, uint8_t data)
+uint8_t circular_buff_put(c_buff_handle_t c_buff, uint8_t data)
 {
     assert(c_buff && c_buff->buffer);
 
-    c_buff->buffer[c_buff->head] = data;
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_relaxed);
+    size_t tail = buff_get_oldest(c_buff, head);
+
+    size_t used = idx_distance(c_buff, head, tail);
+
+    if (used >= c_buff->length)
+    {
+        stats_on_overflow(c_buff, 1);
+        return 0;
+    }
+
+    c_buff->buffer[idx_pos(c_buff, head)] = data;
+    atomic_store_explicit(&c_buff->head, idx_advance(c_buff, head, 1), memory_order_release);
+    stats_on_write(c_buff, 1, used + 1);
 
-    head_ptr_advance(c_buff);
+    return 1;
 }
 
 /**
- * @brief Get byte from circular buffer 
+ * @brief Get byte from circular buffer
  * 
  * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
  * @param data   pointer to a variable to be fill whit the data in buffer.
@@ -217,17 +651,19 @@ uint8_t circular_buff_get(c_buff_handle_t c_buff, uint8_t *data)
 {
     assert(c_buff && data && c_buff->buffer);
 
-    int r = 0;
+    size_t tail = atomic_load_explicit(&c_buff->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_acquire);
 
-    if (!circular_buff_empty(c_buff))
+    if (head == tail)
     {
-        *data = c_buff->buffer[c_buff->tail];
-        tail_ptr_retreat(c_buff);
-
-        r = 1;
+        return 0;
     }
 
-    return r;
+    *data = c_buff->buffer[idx_pos(c_buff, tail)];
+    atomic_store_explicit(&c_buff->tail, idx_advance(c_buff, tail, 1), memory_order_release);
+    stats_on_read(c_buff, 1);
+
+    return 1;
 }
 
 /**
@@ -238,30 +674,78 @@ uint8_t circular_buff_get(c_buff_handle_t c_buff, uint8_t *data)
  * @param data_len number of bytes of data to be written in buffer
  * @return circular_buff_st_t  return status of buffer.
  */
-circular_buff_st_t circular_buff_write(c_buff_handle_t c_buff, uint8_t *data, uint8_t data_len)
+circular_buff_st_t circular_buff_write(c_buff_handle_t c_buff, uint8_t *data, size_t data_len)
 {
     assert(c_buff && c_buff->buffer);
 
-    if (c_buff->full)
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_relaxed);
+    size_t tail = buff_get_oldest(c_buff, head);
+    size_t free_space = c_buff->length - idx_distance(c_buff, head, tail);
+
+    if (free_space == 0)
     {
+        stats_on_overflow(c_buff, data_len);
         return CIRCULAR_BUFF_FULL;
     }
 
-    if (circular_buff_get_free_space(c_buff) < data_len)
+    if (free_space < data_len)
     {
+        stats_on_overflow(c_buff, data_len);
         return CIRCUILAR_BUFF_NOT_ENOUGH_SPACE;
     }
-    else
+
+    buff_copy_in(c_buff, idx_pos(c_buff, head), data, data_len);
+    atomic_store_explicit(&c_buff->head, idx_advance(c_buff, head, data_len), memory_order_release);
+    stats_on_write(c_buff, data_len, c_buff->length - free_space + data_len);
+
+    return CIRCULAR_BUFF_OK;
+}
+
+/**
+ * @brief Write an array of data segments in circular buffer (gather write)
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param segment  array of segments to be written in order
+ * @param segment_cnt number of segments in the array
+ * @return circular_buff_st_t  return status of buffer.
+ * @note   Either all the segments are written or none, data is published at once when all segments are copied.
+ */
+circular_buff_st_t circular_buff_writev(c_buff_handle_t c_buff, const circular_buff_segment_t *segment, size_t segment_cnt)
+{
+    assert(c_buff && c_buff->buffer && (segment || !segment_cnt));
+
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_relaxed);
+    size_t tail = buff_get_oldest(c_buff, head);
+    size_t free_space = c_buff->length - idx_distance(c_buff, head, tail);
+    size_t data_len = 0;
+
+    for (size_t seg_idx = 0; seg_idx < segment_cnt; seg_idx++)
     {
-        size_t data_counter = 0;
+        data_len += segment[seg_idx].len;
+    }
 
-        while (data_counter < data_len)
-        {
-            circular_buff_put(c_buff, data[data_counter++]);
-        }
+    if (free_space == 0)
+    {
+        stats_on_overflow(c_buff, data_len);
+        return CIRCULAR_BUFF_FULL;
+    }
 
-        return CIRCULAR_BUFF_OK;
+    if (free_space < data_len)
+    {
+        stats_on_overflow(c_buff, data_len);
+        return CIRCUILAR_BUFF_NOT_ENOUGH_SPACE;
     }
+
+    for (size_t seg_idx = 0; seg_idx < segment_cnt; seg_idx++)
+    {
+        buff_copy_in(c_buff, idx_pos(c_buff, head), segment[seg_idx].data, segment[seg_idx].len);
+        head = idx_advance(c_buff, head, segment[seg_idx].len);
+    }
+
+    atomic_store_explicit(&c_buff->head, head, memory_order_release);
+    stats_on_write(c_buff, data_len, c_buff->length - free_space + data_len);
+
+    return CIRCULAR_BUFF_OK;
 }
 
 /**
@@ -271,26 +755,29 @@ circular_buff_st_t circular_buff_write(c_buff_handle_t c_buff, uint8_t *data, ui
  * @param data pointer to a buffer to be filled.
  * @param data_len  number of bytes to be read in circular buffer.
  * @return uint8_t  return 1 if number of bytes requested to be read is correct, return 0 otherwise.
+ * @note   Nothing is consumed from the buffer if less than data_len bytes are available.
  */
 uint8_t circular_buff_read(c_buff_handle_t c_buff, uint8_t *data, size_t data_len)
 {
     assert(c_buff && c_buff->buffer && data);
 
-    size_t data_counter = 0;
+    size_t tail = atomic_load_explicit(&c_buff->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_acquire);
 
-    while (data_counter < data_len)
+    if (data_len > idx_distance(c_buff, head, tail))
     {
-        if (!circular_buff_get(c_buff, &data[data_counter++]))
-        {
-            return 0;
-        }
+        return 0;
     }
 
+    buff_copy_out(c_buff, idx_pos(c_buff, tail), data, data_len);
+    atomic_store_explicit(&c_buff->tail, idx_advance(c_buff, tail, data_len), memory_order_release);
+    stats_on_read(c_buff, data_len);
+
     return 1;
 }
 
 /**
- * @brief Fetch data in ring buffer 
+ * @brief Fetch data in ring buffer
  * 
  * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
  * @param data   buffer to be filled with the fetch data in circular buffer.
@@ -298,28 +785,483 @@ uint8_t circular_buff_read(c_buff_handle_t c_buff, uint8_t *data, size_t data_le
  * @return uint8_t  return 1 if number of bytes requested to be fetch is correct, return 0 otherwise.
  */
 uint8_t circular_buff_fetch(c_buff_handle_t c_buff, uint8_t *data, size_t data_len)
+{
+    return circular_buff_fetch_at(c_buff, 0, data, data_len);
+}
+
+/**
+ * @brief Fetch data in ring buffer starting at an offset from the oldest byte
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param offset number of bytes to skip from the oldest byte available
+ * @param data   buffer to be filled with the fetch data in circular buffer.
+ * @param data_len number of bytes to be fetch.
+ * @return uint8_t  return 1 if offset + data_len bytes are available, return 0 otherwise.
+ * @note   Consumer side operation, the data is not consumed.
+ */
+uint8_t circular_buff_fetch_at(c_buff_handle_t c_buff, size_t offset, uint8_t *data, size_t data_len)
 {
     assert(c_buff && c_buff->buffer && data);
 
-    size_t data_counter = 0;
-    size_t tail_idx = c_buff->tail;
+    size_t tail = atomic_load_explicit(&c_buff->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_acquire);
+    size_t available = idx_distance(c_buff, head, tail);
 
-    assert(c_buff && c_buff->buffer);
+    if ((offset > available) || (data_len > (available - offset)))
+    {
+        return 0;
+    }
+
+    buff_copy_out(c_buff, idx_pos(c_buff, idx_advance(c_buff, tail, offset)), data, data_len);
 
-    if (data_len > circular_buff_get_data_len(c_buff))
+    return 1;
+}
+
+/**
+ * @brief Peek a little-endian 16 bit value at an offset from the oldest byte
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param offset number of bytes to skip from the oldest byte available
+ * @param value  pointer to be filled with the value
+ * @return uint8_t  return 1 if the value is available, return 0 otherwise.
+ */
+uint8_t circular_buff_peek_u16_le(c_buff_handle_t c_buff, size_t offset, uint16_t *value)
+{
+    assert(value);
+
+    uint8_t bytes[sizeof(uint16_t)];
+
+    if (!circular_buff_fetch_at(c_buff, offset, bytes, sizeof(bytes)))
+    {
+        return 0;
+    }
+
+    *value = (uint16_t)(bytes[0] | (bytes[1] << 8));
+    return 1;
+}
+
+/**
+ * @brief Peek a little-endian 32 bit value at an offset from the oldest byte
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param offset number of bytes to skip from the oldest byte available
+ * @param value  pointer to be filled with the value
+ * @return uint8_t  return 1 if the value is available, return 0 otherwise.
+ */
+uint8_t circular_buff_peek_u32_le(c_buff_handle_t c_buff, size_t offset, uint32_t *value)
+{
+    assert(value);
+
+    uint8_t bytes[sizeof(uint32_t)];
+
+    if (!circular_buff_fetch_at(c_buff, offset, bytes, sizeof(bytes)))
     {
         return 0;
     }
+
+    *value = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    return 1;
+}
+
+/**
+ * @brief Get the regions with data available to be read without consuming them (zero-copy read)
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param region array of two regions to be filled, the second region is only used when data wraps around.
+ * @return size_t  return the total number of bytes available in both regions.
+ * @note   Consumer side operation, data must be released with circular_buff_commit_read().
+ */
+size_t circular_buff_peek(c_buff_handle_t c_buff, circular_buff_region_t region[2])
+{
+    assert(c_buff && c_buff->buffer && region);
+
+    size_t tail = atomic_load_explicit(&c_buff->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_acquire);
+    size_t data_len = idx_distance(c_buff, head, tail);
+
+    buff_get_regions(c_buff, idx_pos(c_buff, tail), data_len, region);
+
+    return data_len;
+}
+
+/**
+ * @brief Consume data from circular buffer without copying it
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param data_len number of bytes to be consumed, must not exceed the data available.
+ */
+void circular_buff_commit_read(c_buff_handle_t c_buff, size_t data_len)
+{
+    assert(c_buff && data_len <= circular_buff_get_data_len(c_buff));
+
+    size_t tail = atomic_load_explicit(&c_buff->tail, memory_order_relaxed);
+    atomic_store_explicit(&c_buff->tail, idx_advance(c_buff, tail, data_len), memory_order_release);
+    stats_on_read(c_buff, data_len);
+}
+
+/**
+ * @brief Get the free regions of the circular buffer to be written in place (zero-copy write)
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param region array of two regions to be filled, the second region is only used when free space wraps around.
+ * @return size_t  return the total number of bytes available in both regions.
+ * @note   Producer side operation, data must be published with circular_buff_commit_write().
+ */
+size_t circular_buff_reserve(c_buff_handle_t c_buff, circular_buff_region_t region[2])
+{
+    assert(c_buff && c_buff->buffer && region);
+
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_relaxed);
+    size_t tail = buff_get_oldest(c_buff, head);
+    size_t free_space = c_buff->length - idx_distance(c_buff, head, tail);
+
+    buff_get_regions(c_buff, idx_pos(c_buff, head), free_space, region);
+
+    return free_space;
+}
+
+/**
+ * @brief Publish data written directly in the circular buffer memory
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param data_len number of bytes to be published, must not exceed the free space available.
+ */
+void circular_buff_commit_write(c_buff_handle_t c_buff, size_t data_len)
+{
+    assert(c_buff && data_len <= circular_buff_get_free_space(c_buff));
+
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_relaxed);
+    size_t tail = buff_get_oldest(c_buff, head);
+
+    head = idx_advance(c_buff, head, data_len);
+    atomic_store_explicit(&c_buff->head, head, memory_order_release);
+    stats_on_write(c_buff, data_len, idx_distance(c_buff, head, tail));
+}
+
+/**
+ * @brief Search a pattern in the data available in circular buffer without consuming it
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param pattern pointer to the pattern to be searched
+ * @param pattern_len pattern length in bytes
+ * @param offset  if found, offset from the oldest byte to the first byte of the pattern. Otherwise,
+ *                number of bytes that can be discarded because no pattern can start on them.
+ * @return uint8_t  return 1 if the pattern was found, return 0 otherwise.
+ * @note   Consumer side operation. Candidates are located with memchr() in both regions, which is
+ *         word-at-a-time on the Cortex-M newlib build and vectorized on host libc builds.
+ */
+uint8_t circular_buff_find(c_buff_handle_t c_buff, const uint8_t *pattern, size_t pattern_len, size_t *offset)
+{
+    assert(c_buff && c_buff->buffer && pattern && pattern_len && offset);
+
+    circular_buff_region_t region[2];
+    size_t data_len = circular_buff_peek(c_buff, region);
+
+    if (data_len < pattern_len)
+    {
+        *offset = 0;
+        return 0;
+    }
+
+    /* Number of offsets where a complete pattern can start */
+    size_t scan_len = data_len - pattern_len + 1;
+    size_t region_start = 0;
+
+    for (uint8_t reg_idx = 0; reg_idx < 2; reg_idx++)
+    {
+        size_t reg_scan_len = (scan_len > region_start) ? (scan_len - region_start) : 0;
+        reg_scan_len = (reg_scan_len > region[reg_idx].len) ? region[reg_idx].len : reg_scan_len;
+
+        const uint8_t *start = region[reg_idx].data;
+        const uint8_t *end = start + reg_scan_len;
+
+        while (start < end)
+        {
+            const uint8_t *candidate = memchr(start, pattern[0], end - start);
+
+            if (candidate == NULL)
+            {
+                break;
+            }
+
+            size_t candidate_offset = region_start + (candidate - region[reg_idx].data);
+
+            if (regions_match(region, candidate_offset, pattern, pattern_len))
+            {
+                *offset = candidate_offset;
+                return 1;
+            }
+
+            start = candidate + 1;
+        }
+
+        region_start += region[reg_idx].len;
+    }
+
+    *offset = scan_len;
+    return 0;
+}
+
+/**
+ * @brief Write a record in circular buffer, all or nothing
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param segment array of data segments, concatenated in order in a single record
+ * @param segment_cnt number of segments in the array
+ * @return circular_buff_st_t CIRCULAR_BUFF_OK if the record was written, CIRCUILAR_BUFF_NOT_ENOUGH_SPACE otherwise
+ * @note   Producer side operation. The record takes CIRCULAR_BUFF_RECORD_HDR_SIZE extra bytes.
+ */
+circular_buff_st_t circular_buff_write_record(c_buff_handle_t c_buff, const circular_buff_segment_t *segment, size_t segment_cnt)
+{
+    return record_write(c_buff, segment, segment_cnt, 0);
+}
+
+/**
+ * @brief Write a record in circular buffer, dropping the oldest whole records if there is no space
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param segment array of data segments, concatenated in order in a single record
+ * @param segment_cnt number of segments in the array
+ * @return circular_buff_st_t CIRCULAR_BUFF_OK, or CIRCUILAR_BUFF_NOT_ENOUGH_SPACE if the record is larger than the buffer
+ * @note   Producer side operation, it never waits for the consumer. Each dropped record costs one
+ *         length prefix read, so the time is bounded by the number of records it replaces.
+ */
+circular_buff_st_t circular_buff_overwrite_record(c_buff_handle_t c_buff, const circular_buff_segment_t *segment, size_t segment_cnt)
+{
+    return record_write(c_buff, segment, segment_cnt, 1);
+}
+
+/**
+ * @brief Read and remove the oldest record in circular buffer
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param data      pointer to a buffer to be filled with the record data
+ * @param data_size size of the data buffer in bytes
+ * @param data_len  record data length. If the record does not fit in data_size it is left in
+ *                  the buffer and data_len reports the size needed.
+ * @return uint8_t return 1 if a record was read, return 0 otherwise.
+ */
+uint8_t circular_buff_read_record(c_buff_handle_t c_buff, uint8_t *data, size_t data_size, size_t *data_len)
+{
+    return record_read(c_buff, data, data_size, data_len, 1);
+}
+
+/**
+ * @brief Fetch the oldest record in circular buffer without removing it
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param data      pointer to a buffer to be filled with the record data
+ * @param data_size size of the data buffer in bytes
+ * @param data_len  record data length, also set when the record does not fit in data_size
+ * @return uint8_t return 1 if a record was fetched, return 0 otherwise.
+ */
+uint8_t circular_buff_fetch_record(c_buff_handle_t c_buff, uint8_t *data, size_t data_size, size_t *data_len)
+{
+    return record_read(c_buff, data, data_size, data_len, 0);
+}
+
+/**
+ * @brief Attach a broadcast tap to circular buffer
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param tap    tap control block provided by the caller
+ * @param mode   CIRCULAR_BUFF_TAP_GATING to hold back the producer while the tap has unread data,
+ *               CIRCULAR_BUFF_TAP_LAPPED to let the tap lose data instead
+ * @note  The tap receives the data written from now on. It is safe while the producer keeps
+ *        writing, but attach and detach must be called from a single context.
+ */
+void circular_buff_tap_attach(c_buff_handle_t c_buff, circular_buff_tap_t *tap, circular_buff_tap_mode_t mode)
+{
+    assert(c_buff && tap);
+
+    tap->c_buff = c_buff;
+    tap->mode = mode;
+    memset(&tap->stats, 0, sizeof(tap->stats));
+    atomic_init(&tap->cursor, atomic_load_explicit(&c_buff->head, memory_order_acquire));
+    tap->next = atomic_load_explicit(&c_buff->taps, memory_order_relaxed);
+
+    atomic_store_explicit(&c_buff->taps, tap, memory_order_release);
+}
+
+/**
+ * @brief Detach a broadcast tap from its circular buffer
+ * 
+ * @param tap tap previously attached with circular_buff_tap_attach()
+ * @note  The producer may still be walking the tap list, the tap memory must stay valid until
+ *        the write in progress, if any, has finished.
+ */
+void circular_buff_tap_detach(circular_buff_tap_t *tap)
+{
+    assert(tap && tap->c_buff);
+
+    c_buff_handle_t c_buff = tap->c_buff;
+    circular_buff_tap_t *head_tap = atomic_load_explicit(&c_buff->taps, memory_order_relaxed);
+
+    if (head_tap == tap)
+    {
+        atomic_store_explicit(&c_buff->taps, tap->next, memory_order_release);
+    }
     else
     {
-        while (data_counter < data_len)
+        for (circular_buff_tap_t *prev = head_tap; prev != NULL; prev = prev->next)
         {
-            data[data_counter++] = c_buff->buffer[tail_idx++];
-            tail_idx = (tail_idx) % c_buff->length;
+            if (prev->next == tap)
+            {
+                prev->next = tap->next;
+                break;
+            }
         }
     }
 
+    tap->c_buff = NULL;
+}
+
+/**
+ * @brief Return the data available to be read by a broadcast tap
+ * 
+ * @param tap broadcast tap
+ * @return size_t return number of bytes available for the tap.
+ */
+size_t circular_buff_tap_get_data_len(circular_buff_tap_t *tap)
+{
+    assert(tap && tap->c_buff);
+
+    circular_buff_region_t region[2];
+
+    return circular_buff_tap_peek(tap, region);
+}
+
+/**
+ * @brief Get the contiguous regions with data available for a broadcast tap, without copying them
+ * 
+ * @param tap    broadcast tap
+ * @param region array of two regions to be filled, unused regions are set to zero length
+ * @return size_t total number of bytes available in both regions
+ * @note  Tap reader operation. A lapped tap may lose the data while it is being accessed,
+ *        circular_buff_tap_commit() reports if that happened.
+ */
+size_t circular_buff_tap_peek(circular_buff_tap_t *tap, circular_buff_region_t region[2])
+{
+    assert(tap && tap->c_buff && region);
+
+    c_buff_handle_t c_buff = tap->c_buff;
+    size_t cursor = atomic_load_explicit(&tap->cursor, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&c_buff->head, memory_order_acquire);
+
+    if (tap->mode == CIRCULAR_BUFF_TAP_LAPPED)
+    {
+        tap_check_lapped(tap, head, &cursor);
+    }
+
+    size_t data_len = idx_distance(c_buff, head, cursor);
+    buff_get_regions(c_buff, idx_pos(c_buff, cursor), data_len, region);
+
+    return data_len;
+}
+
+/**
+ * @brief Advance a broadcast tap over data previously accessed with circular_buff_tap_peek()
+ * 
+ * @param tap      broadcast tap
+ * @param data_len number of bytes to skip, must not exceed the amount returned by the last peek
+ * @return uint8_t return 1 if the data stayed valid while it was accessed, return 0 if the tap was
+ *                 lapped meanwhile, the data must be discarded and the cursor is already moved forward.
+ */
+uint8_t circular_buff_tap_commit(circular_buff_tap_t *tap, size_t data_len)
+{
+    assert(tap && tap->c_buff);
+
+    c_buff_handle_t c_buff = tap->c_buff;
+    size_t cursor = atomic_load_explicit(&tap->cursor, memory_order_relaxed);
+
+    if (tap->mode == CIRCULAR_BUFF_TAP_LAPPED)
+    {
+        /* Data accesses must complete before the release state of the other readers is checked */
+        atomic_thread_fence(memory_order_acquire);
+
+        if (tap_check_lapped(tap, atomic_load_explicit(&c_buff->head, memory_order_acquire), &cursor))
+        {
+            return 0;
+        }
+    }
+
+    atomic_store_explicit(&tap->cursor, idx_advance(c_buff, cursor, data_len), memory_order_release);
+
     return 1;
 }
 
+/**
+ * @brief Read data available for a broadcast tap
+ * 
+ * @param tap       broadcast tap
+ * @param data      pointer to a buffer to be filled
+ * @param data_size size of the data buffer in bytes
+ * @return size_t number of bytes read, 0 if there is no data available.
+ */
+size_t circular_buff_tap_read(circular_buff_tap_t *tap, uint8_t *data, size_t data_size)
+{
+    assert(tap && tap->c_buff && data);
+
+    c_buff_handle_t c_buff = tap->c_buff;
+    circular_buff_region_t region[2];
+    size_t data_len;
+
+    do
+    {
+        data_len = circular_buff_tap_peek(tap, region);
+        data_len = (data_len > data_size) ? data_size : data_len;
+
+        buff_copy_out(c_buff, region[0].data - c_buff->buffer, data, data_len);
+
+    } while (!circular_buff_tap_commit(tap, data_len));
+
+    return data_len;
+}
+
+/**
+ * @brief Get statistics of a broadcast tap
+ * 
+ * @param tap   broadcast tap
+ * @param stats pointer to a struct to be filled with the statistics
+ */
+void circular_buff_tap_get_stats(circular_buff_tap_t *tap, circular_buff_tap_stats_t *stats)
+{
+    assert(tap && stats);
+
+    *stats = tap->stats;
+}
+
+/**
+ * @brief Get usage statistics of circular buffer
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @param stats  pointer to a struct to be filled with the statistics, zeroed if statistics are disabled.
+ */
+void circular_buff_get_stats(c_buff_handle_t c_buff, circular_buff_stats_t *stats)
+{
+    assert(c_buff && stats);
+
+#if CIRCULAR_BUFF_STATS_ENABLE
+    *stats = c_buff->stats;
+#else
+    memset(stats, 0, sizeof(circular_buff_stats_t));
+#endif
+}
+
+/**
+ * @brief Reset usage statistics of circular buffer, high-water mark restarts from the current data length
+ * 
+ * @param c_buff variable of type circular_buff_t* which contains the struct associated to the circular buffer
+ * @note  Counters written by an ongoing producer/consumer update may be lost.
+ */
+void circular_buff_reset_stats(c_buff_handle_t c_buff)
+{
+    assert(c_buff);
+
+#if CIRCULAR_BUFF_STATS_ENABLE
+    memset(&c_buff->stats, 0, sizeof(c_buff->stats));
+    c_buff->stats.high_water = circular_buff_get_data_len(c_buff);
+#endif
+}
+
 /**@} */
@@ -1,8 +1,7 @@
 
 #include "time_event.h"
 #include "stm32f4xx_hal.h"
-#include "host_comm_tx_fsm.h"
-#include "host_comm_rx_fsm.h"
+#include "host_comm_port.h"
 
 /**
  * @brief Systick Callback Function 
@@ -11,7 +10,6 @@
 void HAL_SYSTICK_Callback(void)
 {
     /* update FSM time events*/
-    host_comm_tx_fsm_time_event_update(&host_comm_tx_handle);
-    host_comm_rx_fsm_time_event_update(&host_comm_rx_handle);
+    host_comm_port_time_event_update();
 
 }
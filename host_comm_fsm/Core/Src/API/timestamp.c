@@ -0,0 +1,29 @@
+/**
+ * @file timestamp.c
+ * @brief  High resolution timestamps from the DWT cycle counter
+ * @version 0.1
+ */
+
+#include "timestamp.h"
+
+/**
+ * @brief Enable the DWT cycle counter
+ * @note  The trace block must be enabled (TRCENA) for the DWT to count, it is shared with the ITM.
+ */
+void timestamp_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief Convert a number of cycles to microseconds
+ *
+ * @param cycles number of core clock cycles
+ * @return uint32_t time in us, rounded down
+ */
+uint32_t timestamp_to_us(uint32_t cycles)
+{
+    return (uint32_t)(((uint64_t)cycles * 1000000U) / SystemCoreClock);
+}
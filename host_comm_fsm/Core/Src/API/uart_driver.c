@@ -9,6 +9,10 @@
  * 
  */
 #include "uart_driver.h"
+#include "peripherals_init.h"
+#include "circular_queue.h"
+#include "timestamp.h"
+#include "stddef.h"
 
 extern void Error_Handler(void);
 
@@ -27,171 +31,1031 @@ extern void Error_Handler(void);
 #endif
 
 
-/* Handle driver type used for host communication*/
-UART_HandleTypeDef huart2;
+/**
+ * @brief Hardware resources of a serial port
+ */
+typedef struct
+{
+    USART_TypeDef *instance;           /* usart peripheral */
+    uint32_t baudrate;                 /* default baudrate */
+    uint8_t enabled;                   /* port is initialized by uart_init() */
+    uart_flow_ctrl_t flow_ctrl;        /* rx flow control mode */
+    GPIO_TypeDef *de_port;             /* RS-485 driver enable pin, NULL for a full duplex port */
+    uint16_t de_pin;
+#if UART_RX_DMA_ENABLE
+    DMA_Stream_TypeDef *rx_dma_stream; /* dma stream and channel mapped to usart rx request */
+    uint32_t rx_dma_channel;
+    IRQn_Type rx_dma_irq;
+#endif
+#if UART_TX_DMA_ENABLE
+    DMA_Stream_TypeDef *tx_dma_stream; /* dma stream and channel mapped to usart tx request */
+    uint32_t tx_dma_channel;
+    IRQn_Type tx_dma_irq;
+#endif
+}uart_port_hw_t;
+
+static const uart_port_hw_t uart_port_hw[UART_PORT_CNT] =
+{
+    [UART_PORT_1] =
+    {
+        .instance = USART1, .baudrate = 115200, .enabled = UART_PORT_1_ENABLE,
+        .flow_ctrl = UART_PORT_1_FLOW_CTRL,
+#if UART_PORT_1_RS485
+        .de_port = USART1_DE_GPIO_Port, .de_pin = USART1_DE_Pin,
+#endif
+#if UART_RX_DMA_ENABLE
+        .rx_dma_stream = DMA2_Stream2, .rx_dma_channel = DMA_CHANNEL_4, .rx_dma_irq = DMA2_Stream2_IRQn,
+#endif
+#if UART_TX_DMA_ENABLE
+        .tx_dma_stream = DMA2_Stream7, .tx_dma_channel = DMA_CHANNEL_4, .tx_dma_irq = DMA2_Stream7_IRQn,
+#endif
+    },
+    [UART_PORT_2] =
+    {
+        .instance = USART2, .baudrate = 115200, .enabled = UART_PORT_2_ENABLE,
+        .flow_ctrl = UART_PORT_2_FLOW_CTRL,
+#if UART_RX_DMA_ENABLE
+        .rx_dma_stream = DMA1_Stream5, .rx_dma_channel = DMA_CHANNEL_4, .rx_dma_irq = DMA1_Stream5_IRQn,
+#endif
+#if UART_TX_DMA_ENABLE
+        .tx_dma_stream = DMA1_Stream6, .tx_dma_channel = DMA_CHANNEL_4, .tx_dma_irq = DMA1_Stream6_IRQn,
+#endif
+    },
+    [UART_PORT_6] =
+    {
+        .instance = USART6, .baudrate = 115200, .enabled = UART_PORT_6_ENABLE,
+        .flow_ctrl = UART_PORT_6_FLOW_CTRL,
+#if UART_PORT_6_RS485
+        .de_port = USART6_DE_GPIO_Port, .de_pin = USART6_DE_Pin,
+#endif
+#if UART_RX_DMA_ENABLE
+        .rx_dma_stream = DMA2_Stream1, .rx_dma_channel = DMA_CHANNEL_5, .rx_dma_irq = DMA2_Stream1_IRQn,
+#endif
+#if UART_TX_DMA_ENABLE
+        .tx_dma_stream = DMA2_Stream6, .tx_dma_channel = DMA_CHANNEL_5, .tx_dma_irq = DMA2_Stream6_IRQn,
+#endif
+    },
+};
 
+#if UART_RX_TIMESTAMP_ENABLE
+/**
+ * @brief Arrival timestamp of a chunk of received bytes
+ */
 typedef struct
 {
+    uint32_t end;          /* rx stream position right after the last byte of the chunk */
+    uint32_t timestamp;    /* arrival time of the chunk, see timestamp.h */
+}uart_rx_stamp_t;
+
+CIRCULAR_QUEUE_DECLARE(uart_rx_stamp_queue, uart_rx_stamp_t, UART_RX_STAMP_QUEUE_SIZE)
+#endif
+
+/**
+ * @brief Serial port data struct
+ */
+struct uart_port_t
+{
+    UART_HandleTypeDef huart;              /* uart handle, HAL callbacks find the port from it */
+    const uart_port_hw_t *hw;              /* hardware resources of the port */
+#if UART_RX_DMA_ENABLE
+    DMA_HandleTypeDef hdma_rx;             /* DMA handle used for reception */
+#endif
+#if UART_TX_DMA_ENABLE
+    DMA_HandleTypeDef hdma_tx;             /* DMA handle used for transmission */
+#endif
+
     struct
     {
         uint8_t buffer[RX_DATA_BUFF_SIZE]; /* Received Data over UART are stored in this buffer */
+        circular_buff_t ctrl;              /* circular buffer control block */
         c_buff_handle_t cb;                /* pointer typedef to circular buffer struct */
-        uint8_t byte;                      /* used to active RX reception interrupt mode */ 
+#if UART_RX_DMA_ENABLE
+        uart_rx_dma_t dma;                 /* circular DMA reception writing straight into the buffer */
+        atomic_bool restart;               /* reception stopped, restart it once the ring is drained */
+#else
+        uint8_t *slot;                     /* ring slot where the ongoing reception is being written */
+        uint8_t byte;                      /* used as reception slot when the ring is full (byte dropped) */ 
+#endif
+        atomic_bool stopped;               /* ring above the high watermark, host asked to stop sending */
+#if UART_RX_TIMESTAMP_ENABLE
+        uart_rx_stamp_queue_t stamps;      /* arrival time of the chunks stored in the ring */
+        uint32_t bytes_in;                 /* rx stream position of the producer (bytes published) */
+        uint32_t bytes_out;                /* rx stream position of the consumer (bytes consumed) */
+#endif
     } rx;
 
     struct
     {
         uint8_t buffer[TX_DATA_BUFF_SIZE]; /* Data to be transmitted via UART are stored in this buffer */
-        c_buff_handle_t cb;                /* pointer typedef to circular buffer struct */
+        bip_buff_t ctrl;                   /* bip buffer control block */
+        bip_buff_handle_t bb;              /* pointer typedef to bip buffer struct */
+        size_t inflight;                   /* length of the block being transmitted by the uart peripheral */
+        atomic_bool busy;                  /* a block is being transmitted, owned by whoever set it */
+        atomic_bool active;                /* transmission accepted by the HAL, set once it is started */
     } tx;
+};
 
+/**/
+static uart_port_t uart_ports[UART_PORT_CNT];
 
-}uart_data_t;
+/**
+ * @brief Return the port that owns a uart handle, NULL if the handle is not owned by this driver
+ */
+static uart_port_t *uart_port_from_handle(UART_HandleTypeDef *huart)
+{
+    uart_port_t *port = (uart_port_t *)((uint8_t *)huart - offsetof(uart_port_t, huart));
 
-/**/
-static uart_data_t uart_data; 
+    return (port >= &uart_ports[0] && port < &uart_ports[UART_PORT_CNT]) ? port : NULL;
+}
 
 /**
-  * @brief USART2 Initialization Function
-  * @param None
+  * @brief USART Initialization Function
+  * @param port serial port to be initialized
   * @retval None
   */
-static void MX_USART2_UART_Init(void)
-{
-  huart2.Instance = USART2;
-  huart2.Init.BaudRate = 115200;
-  huart2.Init.WordLength = UART_WORDLENGTH_8B;
-  huart2.Init.StopBits = UART_STOPBITS_1;
-  huart2.Init.Parity = UART_PARITY_NONE;
-  huart2.Init.Mode = UART_MODE_TX_RX;
-  huart2.Init.HwFlowCtl = UART_HWCONTROL_NONE;
-  huart2.Init.OverSampling = UART_OVERSAMPLING_16;
-  if (HAL_UART_Init(&huart2) != HAL_OK)
+static void MX_USART_UART_Init(uart_port_t *port)
+{
+  port->huart.Instance = port->hw->instance;
+  port->huart.Init.BaudRate = port->hw->baudrate;
+  port->huart.Init.WordLength = UART_WORDLENGTH_8B;
+  port->huart.Init.StopBits = UART_STOPBITS_1;
+  port->huart.Init.Parity = UART_PARITY_NONE;
+  port->huart.Init.Mode = UART_MODE_TX_RX;
+  port->huart.Init.HwFlowCtl = (port->hw->flow_ctrl == UART_FLOW_CTRL_RTS_CTS) ? UART_HWCONTROL_RTS_CTS : UART_HWCONTROL_NONE;
+  port->huart.Init.OverSampling = UART_OVERSAMPLING_16;
+  if (HAL_UART_Init(&port->huart) != HAL_OK)
   {
     Error_Handler();
   }
+
+  if (port->hw->de_port != NULL)
+  {
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    /* RS-485 driver disabled (receiving) until the port transmits, GPIO clock enabled by the MSP */
+    HAL_GPIO_WritePin(port->hw->de_port, port->hw->de_pin, GPIO_PIN_RESET);
+    GPIO_InitStruct.Pin = port->hw->de_pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    HAL_GPIO_Init(port->hw->de_port, &GPIO_InitStruct);
+  }
 }
 
+#if UART_RX_DMA_ENABLE || UART_TX_DMA_ENABLE
 /**
- * @brief Init host comm peripheral interface
- * 
- * @param rx_buff buffer in stack reserved for data reception 
- * @param tx_buff buffer in stack reserved for data transmission
- * @return uint8_t 
+  * @brief DMA stream Initialization Function
+  * @param hdma DMA handle to be initialized
+  * @retval None
+  */
+static void MX_DMA_Stream_Init(DMA_HandleTypeDef *hdma, DMA_Stream_TypeDef *stream, uint32_t channel,
+                               uint32_t direction, uint32_t mode, uint32_t priority, IRQn_Type irq)
+{
+  hdma->Instance = stream;
+  hdma->Init.Channel = channel;
+  hdma->Init.Direction = direction;
+  hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma->Init.MemInc = DMA_MINC_ENABLE;
+  hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  hdma->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  hdma->Init.Mode = mode;
+  hdma->Init.Priority = priority;
+  hdma->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+  if (HAL_DMA_Init(hdma) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  HAL_NVIC_SetPriority(irq, 0, 0);
+  HAL_NVIC_EnableIRQ(irq);
+}
+
+/**
+  * @brief DMA Initialization Function
+  * @param port serial port which dma streams are initialized and linked to its uart handle
+  * @retval None
+  */
+static void MX_DMA_Init(uart_port_t *port)
+{
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+#if UART_RX_DMA_ENABLE
+  MX_DMA_Stream_Init(&port->hdma_rx, port->hw->rx_dma_stream, port->hw->rx_dma_channel,
+                     DMA_PERIPH_TO_MEMORY, DMA_CIRCULAR, DMA_PRIORITY_HIGH, port->hw->rx_dma_irq);
+  __HAL_LINKDMA(&port->huart, hdmarx, port->hdma_rx);
+#endif
+#if UART_TX_DMA_ENABLE
+  MX_DMA_Stream_Init(&port->hdma_tx, port->hw->tx_dma_stream, port->hw->tx_dma_channel,
+                     DMA_MEMORY_TO_PERIPH, DMA_NORMAL, DMA_PRIORITY_LOW, port->hw->tx_dma_irq);
+  __HAL_LINKDMA(&port->huart, hdmatx, port->hdma_tx);
+#endif
+}
+#endif
+
+#if UART_RX_DMA_ENABLE
+/**
+ * @brief Start the circular DMA reception over the whole rx ring memory
+ * @note  The DMA starts at the beginning of the buffer, the ring must be empty and reset.
+ *        Received bytes are published on half transfer, transfer complete and IDLE line events.
  */
-uint8_t uart_init(void)
+static void uart_rx_arm(uart_port_t *port)
+{
+    HAL_UARTEx_ReceiveToIdle_DMA(&port->huart, port->rx.buffer, RX_DATA_BUFF_SIZE);
+}
+
+/**
+ * @brief Return the DMA write position in the rx ring memory
+ */
+static size_t uart_rx_dma_pos(uart_port_t *port)
 {
+    return RX_DATA_BUFF_SIZE - __HAL_DMA_GET_COUNTER(port->huart.hdmarx);
+}
+#else
+/**
+ * @brief Arm the reception of the next byte directly in the rx ring memory
+ * @note  if the ring is full the byte is received in a scratch slot and dropped
+ */
+static void uart_rx_arm(uart_port_t *port)
+{
+    circular_buff_region_t region[2];
+
+    if (circular_buff_reserve(port->rx.cb, region) > 0)
+    {
+        port->rx.slot = region[0].data;
+    }
+    else
+    {
+        port->rx.slot = &port->rx.byte;
+    }
+
+    HAL_UART_Receive_IT(&port->huart, port->rx.slot, 1);
+}
+#endif
+
+/**
+ * @brief Timestamp a chunk of bytes just published in the rx ring, producer side
+ * @note  If the queue is full the chunk is not timestamped, its bytes report the arrival time of
+ *        the next chunk timestamped.
+ */
+static void uart_rx_stamp(uart_port_t *port, uint32_t timestamp, size_t len)
+{
+#if UART_RX_TIMESTAMP_ENABLE
+    if (len == 0)
+    {
+        return;
+    }
+
+    port->rx.bytes_in += len;
+
+    uart_rx_stamp_t stamp = {.end = port->rx.bytes_in, .timestamp = timestamp};
+    uart_rx_stamp_queue_push(&port->rx.stamps, &stamp);
+#endif
+}
+
+/**
+ * @brief Account bytes consumed from the rx ring and release the timestamps of the chunks fully consumed, consumer side
+ */
+static void uart_rx_consumed(uart_port_t *port, size_t len)
+{
+#if UART_RX_TIMESTAMP_ENABLE
+    uart_rx_stamp_t *stamp;
+
+    port->rx.bytes_out += len;
+
+    while ((stamp = uart_rx_stamp_queue_peek(&port->rx.stamps)) != NULL &&
+           (int32_t)(stamp->end - port->rx.bytes_out) <= 0)
+    {
+        uart_rx_stamp_queue_drop(&port->rx.stamps);
+    }
+#endif
+}
+
+/**
+ * @brief Return the rx ring levels of the flow control of a port
+ */
+static void uart_rx_flow_levels(uart_port_t *port, size_t *high, size_t *low)
+{
+    bool in_band = (port->hw->flow_ctrl == UART_FLOW_CTRL_IN_BAND);
+
+    *high = in_band ? UART_RX_IN_BAND_HIGH_WATERMARK : UART_RX_HIGH_WATERMARK;
+    *low = in_band ? UART_RX_IN_BAND_LOW_WATERMARK : UART_RX_LOW_WATERMARK;
+}
+
+/**
+ * @brief Stop the host if the rx ring reached the high watermark, producer side
+ * @return bool true if the reception is paused and must not be armed again
+ * @note  With RTS/CTS the usart releases RTS by itself while a received byte is not read from the
+ *        data register, so the reception is paused by not reading it: the DMA requests are
+ *        disabled, or the next byte reception is not armed. With in-band flow control the
+ *        reception keeps running, the link layer sends the stop request, so the host is stopped
+ *        at a lower level (UART_RX_IN_BAND_HIGH_WATERMARK) to leave it time to react.
+ */
+static bool uart_rx_flow_stop(uart_port_t *port)
+{
+    size_t high, low;
+
+    if (port->hw->flow_ctrl == UART_FLOW_CTRL_NONE)
+    {
+        return false;
+    }
+
+    uart_rx_flow_levels(port, &high, &low);
+
+    if (!atomic_load(&port->rx.stopped))
+    {
+        if (circular_buff_get_data_len(port->rx.cb) < high)
+        {
+            return false;
+        }
+
+#if UART_RX_DMA_ENABLE
+        if (port->hw->flow_ctrl == UART_FLOW_CTRL_RTS_CTS)
+        {
+            CLEAR_BIT(port->huart.Instance->CR3, USART_CR3_DMAR);
+        }
+#endif
+        atomic_store(&port->rx.stopped, true);
+        uart_driver_dbg("comm driver info : rx flow stopped\r\n");
+    }
+
+    return port->hw->flow_ctrl == UART_FLOW_CTRL_RTS_CTS;
+}
+
+/**
+ * @brief Resume the host once the rx ring drained down to the low watermark, consumer side
+ */
+static void uart_rx_flow_resume(uart_port_t *port)
+{
+    size_t high, low;
+
+    uart_rx_flow_levels(port, &high, &low);
+
+    if (!atomic_load(&port->rx.stopped) || circular_buff_get_data_len(port->rx.cb) > low)
+    {
+        return;
+    }
+
+    atomic_store(&port->rx.stopped, false);
+
+    if (port->hw->flow_ctrl == UART_FLOW_CTRL_RTS_CTS)
+    {
+#if UART_RX_DMA_ENABLE
+        /*The byte held in the data register is the next one written by the DMA*/
+        SET_BIT(port->huart.Instance->CR3, USART_CR3_DMAR);
+#else
+        uart_rx_arm(port);
+#endif
+    }
+
+    uart_driver_dbg("comm driver info : rx flow resumed\r\n");
+}
+
+/**
+ * @brief Restart the reception if it was stopped, consumer side
+ * @note  The DMA can only restart at the beginning of the buffer, so a stopped reception is
+ *        restarted once the data received so far is consumed. If the DMA overwrote unread data
+ *        the ring content is dropped.
+ */
+static void uart_rx_service(uart_port_t *port)
+{
+#if UART_RX_DMA_ENABLE
+    if (uart_rx_dma_is_overrun(&port->rx.dma))
+    {
+        uart_driver_dbg("comm driver error:\t rx dma overrun\r\n");
+        HAL_UART_AbortReceive(&port->huart);
+        uart_rx_consumed(port, circular_buff_get_data_len(port->rx.cb));
+        circular_buff_flush(port->rx.cb);
+        atomic_store(&port->rx.restart, true);
+    }
+
+    if (atomic_load(&port->rx.restart) && circular_buff_empty(port->rx.cb))
+    {
+        atomic_store(&port->rx.restart, false);
+        circular_buff_reset(port->rx.cb);
+        uart_rx_dma_restart(&port->rx.dma);
+        uart_rx_arm(port);
+    }
+#endif
+
+    uart_rx_flow_resume(port);
+}
+
+/**
+ * @brief Init serial port, its buffers and start the reception
+ *
+ * @param port serial port to be initialized
+ * @param hw   hardware resources of the port
+ */
+static void uart_port_init(uart_port_t *port, const uart_port_hw_t *hw)
+{
+    port->hw = hw;
+
     /*Init Uart device*/
-    MX_USART2_UART_Init();
+    MX_USART_UART_Init(port);
+#if UART_RX_DMA_ENABLE || UART_TX_DMA_ENABLE
+    MX_DMA_Init(port);
+#endif
 
     /*Init Circular Buffer*/
-    uart_data.tx.cb = circular_buff_init(uart_data.tx.buffer, TX_DATA_BUFF_SIZE);
-    uart_data.rx.cb = circular_buff_init(uart_data.rx.buffer, RX_DATA_BUFF_SIZE);
+    port->tx.bb = bip_buff_init_static(&port->tx.ctrl, port->tx.buffer, TX_DATA_BUFF_SIZE);
+    port->tx.inflight = 0;
+    atomic_init(&port->tx.busy, false);
+    atomic_init(&port->tx.active, false);
+    port->rx.cb = circular_buff_init_static(&port->rx.ctrl, port->rx.buffer, RX_DATA_BUFF_SIZE);
+#if UART_RX_DMA_ENABLE
+    uart_rx_dma_init(&port->rx.dma, port->rx.cb);
+    atomic_init(&port->rx.restart, false);
+#endif
+    atomic_init(&port->rx.stopped, false);
+#if UART_RX_TIMESTAMP_ENABLE
+    uart_rx_stamp_queue_init(&port->rx.stamps);
+    port->rx.bytes_in = 0;
+    port->rx.bytes_out = 0;
+#endif
 
     /*Start Reception of data*/
-    HAL_UART_Receive_IT(&huart2, &uart_data.rx.byte, 1);
+    uart_rx_arm(port);
+}
+
+/**
+ * @brief Init host comm peripheral interface, every enabled serial port is initialized
+ *
+ * @return uint8_t
+ */
+uint8_t uart_init(void)
+{
+    for (size_t port_idx = 0; port_idx < UART_PORT_CNT; port_idx++)
+    {
+        if (uart_port_hw[port_idx].enabled)
+        {
+            uart_port_init(&uart_ports[port_idx], &uart_port_hw[port_idx]);
+            uart_driver_dbg("comm driver info : port %d initialized\r\n", port_idx);
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Get a serial port object
+ *
+ * @param id serial port
+ * @return uart_port_t* port object, NULL if the port is not enabled
+ */
+uart_port_t *uart_get_port(uart_port_id_t id)
+{
+    if (id >= UART_PORT_CNT || !uart_port_hw[id].enabled)
+    {
+        return NULL;
+    }
+
+    return &uart_ports[id];
+}
+
+size_t uart_get_rx_data_len(uart_port_t *port)
+{
+    uart_rx_service(port);
+    return circular_buff_get_data_len(port->rx.cb);
+}
+
+
+uint8_t uart_read_rx_data(uart_port_t *port, uint8_t *data, size_t len)
+{
+    if (!circular_buff_read(port->rx.cb, data, len))
+    {
+        return 0;
+    }
+
+    uart_rx_consumed(port, len);
+    uart_rx_flow_resume(port);
+    return 1;
+}
+
+
+uint8_t uart_fetch_rx_data(uart_port_t *port, uint8_t *data, size_t len)
+{
+    return circular_buff_fetch(port->rx.cb, data, len);
+}
+
+
+uint8_t uart_fetch_rx_data_at(uart_port_t *port, size_t offset, uint8_t *data, size_t len)
+{
+    return circular_buff_fetch_at(port->rx.cb, offset, data, len);
+}
+
+
+uint8_t uart_peek_rx_u32(uart_port_t *port, size_t offset, uint32_t *value)
+{
+    return circular_buff_peek_u32_le(port->rx.cb, offset, value);
+}
+
+
+size_t uart_peek_rx_data(uart_port_t *port, circular_buff_region_t region[2])
+{
+    uart_rx_service(port);
+    return circular_buff_peek(port->rx.cb, region);
+}
+
+
+uint8_t uart_commit_rx_data(uart_port_t *port, size_t len)
+{
+    circular_buff_commit_read(port->rx.cb, len);
+    uart_rx_consumed(port, len);
+    uart_rx_flow_resume(port);
+    return 1;
+}
+
+
+/**
+ * @brief Get the arrival time of a received byte
+ *
+ * @param port serial port
+ * @param offset offset of the byte from the oldest byte in the rx ring
+ * @param timestamp set to the arrival time of the chunk the byte was received in, see timestamp.h.
+ *                  With DMA reception a chunk ends on a half/full transfer or IDLE line event, so
+ *                  it is the arrival time of the last byte of the chunk.
+ * @return uint8_t return 1 if the byte is timestamped, 0 otherwise (not received yet, or timestamps disabled)
+ */
+uint8_t uart_get_rx_timestamp(uart_port_t *port, size_t offset, uint32_t *timestamp)
+{
+#if UART_RX_TIMESTAMP_ENABLE
+    uint32_t pos = port->rx.bytes_out + offset;
+    uart_rx_stamp_t *stamp;
+
+    for (size_t stamp_idx = 0; (stamp = uart_rx_stamp_queue_peek_at(&port->rx.stamps, stamp_idx)) != NULL; stamp_idx++)
+    {
+        if ((int32_t)(stamp->end - pos) > 0)
+        {
+            *timestamp = stamp->timestamp;
+            return 1;
+        }
+    }
+#endif
+    return 0;
+}
 
-    uart_driver_dbg("comm driver info : uart2 initialized\r\n");
 
+uint8_t uart_find_rx_data(uart_port_t *port, const uint8_t *pattern, size_t pattern_len, size_t *offset)
+{
+    uart_rx_service(port);
+    return circular_buff_find(port->rx.cb, pattern, pattern_len, offset);
+}
+
+
+uint8_t uart_get_rx_stats(uart_port_t *port, circular_buff_stats_t *stats)
+{
+    circular_buff_get_stats(port->rx.cb, stats);
     return 1;
 }
 
-uint8_t uart_get_rx_data_len(void)
+
+uint8_t uart_get_tx_stats(uart_port_t *port, circular_buff_stats_t *stats)
 {
-    return circular_buff_get_data_len(uart_data.rx.cb);
+    bip_buff_get_stats(port->tx.bb, stats);
+    return 1;
 }
 
 
-uint8_t uart_read_rx_data(uint8_t *data, uint8_t len)
+uint8_t uart_reset_stats(uart_port_t *port)
+{
+    circular_buff_reset_stats(port->rx.cb);
+    bip_buff_reset_stats(port->tx.bb);
+    return 1;
+}
+
+
+/**
+ * @brief Attach a broadcast tap to the rx stream, it reads the received bytes without consuming them
+ * @note  A CIRCULAR_BUFF_TAP_GATING tap that falls behind makes the receiver drop bytes, diagnostic
+ *        taps should use CIRCULAR_BUFF_TAP_LAPPED.
+ */
+uint8_t uart_attach_rx_tap(uart_port_t *port, circular_buff_tap_t *tap, circular_buff_tap_mode_t mode)
 {
-    return circular_buff_read(uart_data.rx.cb, data, len);
+    circular_buff_tap_attach(port->rx.cb, tap, mode);
+    return 1;
 }
 
 
-uint8_t uart_fetch_rx_data(uint8_t *data, uint8_t len)
+uint8_t uart_detach_rx_tap(circular_buff_tap_t *tap)
 {
-    return circular_buff_fetch(uart_data.rx.cb, data, len);
+    circular_buff_tap_detach(tap);
+    return 1;
 }
 
 
-uint8_t uart_clear_rx_data(void)
+uint8_t uart_clear_rx_data(uart_port_t *port)
 {
-    circular_buff_reset(uart_data.rx.cb);
+    /* Drop what is stored now, the amount dropped must be known to keep the timestamps in sync */
+    size_t len = circular_buff_get_data_len(port->rx.cb);
+
+    circular_buff_commit_read(port->rx.cb, len);
+    uart_rx_consumed(port, len);
+    uart_rx_flow_resume(port);
     return 1;
 }
 
-uint8_t uart_transmit(uint8_t *data, uint8_t len)
+uint8_t uart_transmit(uart_port_t *port, uint8_t *data, size_t len)
 {
-    return HAL_UART_Transmit(&huart2, data, len, HAL_MAX_DELAY);
+    if (len > UINT16_MAX)
+    {
+        return HAL_ERROR;
+    }
+
+    return HAL_UART_Transmit(&port->huart, data, len, HAL_MAX_DELAY);
 }
 
-uint8_t uart_transmit_it(uint8_t *data, uint8_t len)
+/**
+ * @brief Drive the RS-485 transceiver driver enable pin, no effect on a full duplex port
+ */
+static void uart_rs485_drive(uart_port_t *port, bool enable)
 {
-    /* Write data to circular buffer */
-    if (circular_buff_write(uart_data.tx.cb, data, len) == CIRCULAR_BUFF_OK)
+    if (port->hw->de_port != NULL)
     {
-        if (huart2.gState == HAL_UART_STATE_READY)
+        HAL_GPIO_WritePin(port->hw->de_port, port->hw->de_pin, enable ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    }
+}
+
+/**
+ * @brief Start the transmission of a block and flag it active if the HAL accepted it
+ * @note  Interrupts are masked so an error interrupt can not see the transmission running
+ *        before it is flagged active.
+ */
+static bool uart_tx_start(uart_port_t *port, uint8_t *block, size_t len)
+{
+    uint32_t primask = __get_PRIMASK();
+    bool started;
+
+    __disable_irq();
+#if UART_TX_DMA_ENABLE
+    started = (HAL_UART_Transmit_DMA(&port->huart, block, len) == HAL_OK);
+#else
+    started = (HAL_UART_Transmit_IT(&port->huart, block, len) == HAL_OK);
+#endif
+    atomic_store(&port->tx.active, started);
+    __set_PRIMASK(primask);
+
+    return started;
+}
+
+/**
+ * @brief Start the transmission of the next block of data pending in the tx bip buffer
+ * @note  Can be called from thread and interrupt context, the busy flag makes sure a single
+ *        transmission is started. The block is transmitted in place and released when the
+ *        transmission completes. If the buffer is empty the flag is released and checked
+ *        again, so a block written meanwhile is not left behind.
+ *        If the HAL can not start the transmission (e.g. HAL_BUSY, its lock is shared with the
+ *        reception) the block is kept, uart_tx_service() retries it from thread context.
+ */
+static void uart_tx_kick(uart_port_t *port)
+{
+    while (!atomic_exchange(&port->tx.busy, true))
+    {
+        uint8_t *block;
+        size_t data_len = bip_buff_peek(port->tx.bb, &block);
+
+        if (data_len)
         {
-            uint8_t byte;
-            circular_buff_get(uart_data.tx.cb, &byte);
-            HAL_UART_Transmit_IT(&huart2, &byte, 1);
+            data_len = (data_len > UINT16_MAX) ? UINT16_MAX : data_len;
+            port->tx.inflight = data_len;
+            uart_rs485_drive(port, true);
+
+            if (uart_tx_start(port, block, data_len))
+            {
+                return;
+            }
+
+            uart_driver_dbg("comm driver error:\t uart cannot start transmission, retried later\r\n");
+            uart_rs485_drive(port, false);
+            port->tx.inflight = 0;
+            atomic_store(&port->tx.busy, false);
+            return;
         }
-        else
+
+        atomic_store(&port->tx.busy, false);
+
+        if (bip_buff_get_data_len(port->tx.bb) == 0)
         {
-            uart_driver_dbg("comm driver warning:\t uart busy\r\n");
+            return;
         }
+    }
+}
+
+/**
+ * @brief Release the block transmitted and start the next one, interrupt context
+ * @note  Called on transmission complete (TC), the last stop bit is out so the RS-485 driver can
+ *        be released if nothing else is pending. Blocks written back to back keep it enabled.
+ */
+static void uart_tx_done(uart_port_t *port)
+{
+    atomic_store(&port->tx.active, false);
+    bip_buff_commit_read(port->tx.bb, port->tx.inflight);
+    port->tx.inflight = 0;
+    atomic_store(&port->tx.busy, false);
+    uart_tx_kick(port);
+
+    if (!atomic_load(&port->tx.busy))
+    {
+        uart_rs485_drive(port, false);
+    }
+}
+
+uint8_t uart_transmit_it(uart_port_t *port, uint8_t *data, size_t len)
+{
+    circular_buff_segment_t segment = {.data = data, .len = len};
+
+    return uart_transmit_itv(port, &segment, 1);
+}
+
+/**
+ * @brief Enqueue an array of data segments (e.g. a whole frame) for transmission
+ *
+ * @param port serial port used for the transmission
+ * @param segment array of segments to be transmitted in order
+ * @param segment_cnt number of segments in the array
+ * @return uint8_t return 1 if all the segments were enqueued, return 0 if none was enqueued
+ */
+uint8_t uart_transmit_itv(uart_port_t *port, const circular_buff_segment_t *segment, size_t segment_cnt)
+{
+    /* Write all segments as one contiguous block of the bip buffer */
+    if (bip_buff_writev(port->tx.bb, segment, segment_cnt) == CIRCULAR_BUFF_OK)
+    {
+        uart_tx_kick(port);
 
         return 1;
     }
 
-    uart_driver_dbg("comm driver error:\t circular buffer cannot write request\r\n");
+    uart_driver_dbg("comm driver error:\t bip buffer cannot write request\r\n");
 	return 0;
 }
 
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+/**
+ * @brief Start the transmission of the data pending if it is not running, thread context
+ * @note  To be called periodically, a block which transmission could not be started from
+ *        interrupt context is only retried here or on the next write.
+ */
+void uart_tx_service(uart_port_t *port)
+{
+    uart_tx_kick(port);
+}
+
+/**
+ * @brief Check if every byte written for transmission was already transmitted
+ */
+bool uart_is_tx_idle(uart_port_t *port)
 {
-  if(huart->Instance == USART2)
-  { 
-    /*check for pendings transfers */
-    static uint8_t data_chunk[MAX_DATA_CHUNK_SIZE];
-    uint16_t data_len = circular_buff_get_data_len(uart_data.tx.cb);
+    return (bip_buff_get_data_len(port->tx.bb) == 0) && !atomic_load(&port->tx.busy);
+}
+
+/**
+ * @brief Check if the port is a RS-485 half duplex port (shared bus)
+ */
+bool uart_is_rs485(uart_port_t *port)
+{
+    return port->hw->de_port != NULL;
+}
 
-    if(data_len)
+/**
+ * @brief Return the clock of the bus the usart is connected to
+ */
+static uint32_t uart_get_pclk(uart_port_t *port)
+{
+    if (port->hw->instance == USART1 || port->hw->instance == USART6)
+    {
+        return HAL_RCC_GetPCLK2Freq();
+    }
+
+    return HAL_RCC_GetPCLK1Freq();
+}
+
+/**
+ * @brief Check if a baudrate can be generated by the port
+ *
+ * @param port serial port
+ * @param baudrate requested baudrate
+ * @return uint8_t return 1 if the baudrate error is within UART_BAUDRATE_MAX_ERROR_PCT, 0 otherwise
+ */
+uint8_t uart_check_baudrate(uart_port_t *port, uint32_t baudrate)
+{
+    uint32_t pclk = uart_get_pclk(port);
+
+    /* Oversampling by 16, usart divider must be at least 1 */
+    if (baudrate == 0 || baudrate > (pclk / 16))
+    {
+        return 0;
+    }
+
+    /* BRR holds the usart divider in 1/16 units, so the baudrate generated is pclk / BRR */
+    uint32_t actual = pclk / UART_BRR_SAMPLING16(pclk, baudrate);
+    uint32_t error = (actual > baudrate) ? (actual - baudrate) : (baudrate - actual);
+
+    return (error * 100U) <= (baudrate * UART_BAUDRATE_MAX_ERROR_PCT);
+}
+
+/**
+ * @brief Change the baudrate of the port
+ *
+ * @param port serial port
+ * @param baudrate new baudrate
+ * @return uint8_t return 1 if the baudrate was changed, 0 if the baudrate is not supported or
+ *         there is data pending to be transmitted at the current baudrate.
+ * @note   The reception keeps running, bytes received during the switch are garbage and should
+ *         be discarded by the caller.
+ */
+uint8_t uart_set_baudrate(uart_port_t *port, uint32_t baudrate)
+{
+    if (!uart_check_baudrate(port, baudrate) || !uart_is_tx_idle(port))
     {
-        data_len = (data_len >= MAX_DATA_CHUNK_SIZE ) ? (MAX_DATA_CHUNK_SIZE - 1) : data_len;
-        circular_buff_read(uart_data.tx.cb, data_chunk, data_len);
-        HAL_UART_Transmit_IT(&huart2, data_chunk, data_len);
+        return 0;
     }
 
+    __HAL_UART_DISABLE(&port->huart);
+    port->huart.Instance->BRR = UART_BRR_SAMPLING16(uart_get_pclk(port), baudrate);
+    port->huart.Init.BaudRate = baudrate;
+    __HAL_UART_ENABLE(&port->huart);
+
+    uart_driver_dbg("comm driver info : baudrate %lu\r\n", baudrate);
+    return 1;
+}
+
+uart_flow_ctrl_t uart_get_flow_ctrl(uart_port_t *port)
+{
+    return port->hw->flow_ctrl;
+}
+
+/**
+ * @brief Check if the rx ring is above the flow control watermarks
+ *
+ * @param port serial port
+ * @return bool true from the time the ring reaches the high watermark until it drains down to the
+ *         low watermark. With in-band flow control the link layer polls it to tell the host to
+ *         stop or resume.
+ */
+bool uart_rx_flow_is_stopped(uart_port_t *port)
+{
+    return atomic_load(&port->rx.stopped);
+}
+
+uint32_t uart_get_baudrate(uart_port_t *port)
+{
+    return port->huart.Init.BaudRate;
+}
+
+/**
+ * @brief Return the time needed to transfer a number of bytes at the current baudrate
+ *
+ * @param port serial port
+ * @param len number of bytes
+ * @return uint32_t transfer time in ms, rounded up
+ */
+uint32_t uart_bytes_to_ms(uart_port_t *port, size_t len)
+{
+    uint32_t baudrate = port->huart.Init.BaudRate;
+
+    return (uint32_t)(((uint64_t)len * UART_BITS_PER_BYTE * 1000U + baudrate - 1) / baudrate);
+}
+
+void uart_irq_handler(uart_port_id_t id)
+{
+    HAL_UART_IRQHandler(&uart_ports[id].huart);
+}
+
+#if UART_RX_DMA_ENABLE
+void uart_rx_dma_irq_handler(uart_port_id_t id)
+{
+    HAL_DMA_IRQHandler(&uart_ports[id].hdma_rx);
+}
+#endif
+
+#if UART_TX_DMA_ENABLE
+void uart_tx_dma_irq_handler(uart_port_id_t id)
+{
+    HAL_DMA_IRQHandler(&uart_ports[id].hdma_tx);
+}
+#endif
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  uart_port_t *port = uart_port_from_handle(huart);
+
+  if(port != NULL)
+  {
+    /*release transmitted block and check for pendings transfers */
+    uart_tx_done(port);
+
     uart_driver_dbg("comm driver info:\t irq uart tx complete\r\n");
   }
 }
 
+#if UART_RX_DMA_ENABLE
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    uart_port_t *port = uart_port_from_handle(huart);
+
+    if(port != NULL)
+    {
+        /*Half transfer, transfer complete or IDLE line, Size is the DMA write position*/
+        uint32_t timestamp = timestamp_now();
+
+        uart_rx_stamp(port, timestamp, uart_rx_dma_publish(&port->rx.dma, Size));
+        uart_rx_flow_stop(port);
+    }
+}
+#else
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
-    if(huart->Instance == USART2)
+    uart_port_t *port = uart_port_from_handle(huart);
+
+    if(port != NULL)
     {
-        /*Set Uart Data reception for next byte*/
-        HAL_UART_Receive_IT(&huart2, &uart_data.rx.byte, 1);
+        uint32_t timestamp = timestamp_now();
 
-        if(circular_buff_write(uart_data.rx.cb, &uart_data.rx.byte, 1) !=  CIRCULAR_BUFF_OK)
+        /*Byte was received in place, publish it*/
+        if(port->rx.slot != &port->rx.byte)
+        {
+            uart_rx_stamp(port, timestamp, 1);
+            circular_buff_commit_write(port->rx.cb, 1);
+        }
+        else if(circular_buff_write(port->rx.cb, &port->rx.byte, 1) == CIRCULAR_BUFF_OK)
+        {
+            uart_rx_stamp(port, timestamp, 1);
+        }
+        else
         {
-            /*Reinit ring buffer*/
-            circular_buff_reset(uart_data.rx.cb);
+            /*Ring buffer still full, byte dropped and accounted in ring stats (only the consumer side is allowed to discard data)*/
+            uart_driver_dbg("comm driver error:\t rx circular buffer full\r\n");
+        }
+
+        /*Set Uart Data reception for next byte, unless the host must be stopped*/
+        if(!uart_rx_flow_stop(port))
+        {
+            uart_rx_arm(port);
         }
     }
 }
+#endif
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    uart_port_t *port = uart_port_from_handle(huart);
+
+    if(port == NULL)
+    {
+        return;
+    }
+
+    if(huart->RxState == HAL_UART_STATE_READY)
+    {
+        /*Blocking error (e.g. overrun) stopped the reception*/
+#if UART_RX_DMA_ENABLE
+        uart_rx_stamp(port, timestamp_now(), uart_rx_dma_publish(&port->rx.dma, uart_rx_dma_pos(port)));
+        atomic_store(&port->rx.restart, true);
+#else
+        uart_rx_arm(port);
+#endif
+        uart_driver_dbg("comm driver error:\t uart error 0x%lx\r\n", huart->ErrorCode);
+    }
+
+#if UART_TX_DMA_ENABLE
+    /*The rx and tx streams report dma errors alike, only a tx stream error aborts the transmission*/
+    if((huart->ErrorCode & HAL_UART_ERROR_DMA) && port->hdma_tx.ErrorCode != HAL_DMA_ERROR_NONE &&
+       atomic_load(&port->tx.active))
+    {
+        /*Transmission aborted, drop the block to not block the queue*/
+        uart_tx_done(port);
+        uart_driver_dbg("comm driver error:\t uart tx dma error 0x%lx\r\n", port->hdma_tx.ErrorCode);
+    }
+#endif
+}
 
 /* only for dbg*/
-uint8_t uart_write_rx_data(uint8_t *data, uint8_t len)
+uint8_t uart_write_rx_data(uart_port_t *port, uint8_t *data, size_t len)
 {
-	circular_buff_st_t status = circular_buff_write(uart_data.rx.cb, data, len);
+	/*Stop ongoing reception, its slot is placed where the data is going to be written*/
+	HAL_UART_AbortReceive(&port->huart);
+#if UART_RX_DMA_ENABLE
+	uart_rx_stamp(port, timestamp_now(), uart_rx_dma_publish(&port->rx.dma, uart_rx_dma_pos(port)));
+#endif
+
+	circular_buff_st_t status = circular_buff_write(port->rx.cb, data, len);
 	if(status != CIRCULAR_BUFF_OK)
 	{
 	    uart_driver_dbg("comm driver error:\t circular buffer cannot write request\r\n");
 	}
+	else
+	{
+	    uart_rx_stamp(port, timestamp_now(), len);
+	}
+
+#if UART_RX_DMA_ENABLE
+	/*DMA can only restart at the beginning of the buffer, it is resumed once the data is consumed*/
+	atomic_store(&port->rx.restart, true);
+#else
+	if(!uart_rx_flow_stop(port))
+	{
+	    uart_rx_arm(port);
+	}
+#endif
     return status;
 }
-
-
-
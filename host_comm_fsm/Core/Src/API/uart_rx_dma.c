@@ -0,0 +1,101 @@
+/**
+ * @file uart_rx_dma.c
+ * @brief  Publishing of bytes received by a circular DMA into a circular buffer
+ * @version 0.1
+ *
+ * @note   The circular buffer memory is the DMA buffer, so the physical position of the producer
+ *         index always matches the DMA write position and publishing is a single commit of the
+ *         bytes written since the last event. The half/full transfer events bound the distance
+ *         between two events to half of the buffer.
+ */
+
+#include "uart_rx_dma.h"
+
+/**
+ * @brief Initialize the DMA reception control block
+ *
+ * @param rx_dma DMA reception control block
+ * @param cb     circular buffer used as DMA memory, it must be empty with its producer index at
+ *               the beginning of the buffer (just initialized or reset)
+ */
+void uart_rx_dma_init(uart_rx_dma_t *rx_dma, c_buff_handle_t cb)
+{
+    assert(rx_dma && cb);
+
+    rx_dma->cb = cb;
+    rx_dma->overrun_cnt = 0;
+    atomic_init(&rx_dma->overrun, false);
+    uart_rx_dma_restart(rx_dma);
+}
+
+/**
+ * @brief Restart publishing after the DMA was restarted at the beginning of the buffer
+ *
+ * @param rx_dma DMA reception control block
+ * @note  The DMA must be stopped while the circular buffer is reset, producer index at the
+ *        beginning of the buffer, before the DMA is started again.
+ */
+void uart_rx_dma_restart(uart_rx_dma_t *rx_dma)
+{
+    assert(rx_dma && rx_dma->cb && circular_buff_empty(rx_dma->cb));
+
+    rx_dma->pos = 0;
+    atomic_store_explicit(&rx_dma->overrun, false, memory_order_release);
+}
+
+/**
+ * @brief Publish the bytes written by the DMA since the last call
+ *
+ * @param rx_dma  DMA reception control block
+ * @param dma_pos DMA write position in the buffer (buffer length - remaining transfer count),
+ *                equal to the buffer length on a full transfer event
+ * @return size_t number of bytes published
+ * @note   Producer side operation. If the new bytes do not fit in the free space the DMA has
+ *         already overwritten unread data, nothing else is published until the reception is
+ *         restarted with uart_rx_dma_restart().
+ */
+size_t uart_rx_dma_publish(uart_rx_dma_t *rx_dma, size_t dma_pos)
+{
+    assert(rx_dma && rx_dma->cb);
+
+    size_t length = circular_buff_capacity(rx_dma->cb);
+
+    if (atomic_load_explicit(&rx_dma->overrun, memory_order_relaxed))
+    {
+        return 0;
+    }
+
+    dma_pos = (dma_pos >= length) ? (dma_pos - length) : dma_pos;
+
+    size_t data_len = (dma_pos >= rx_dma->pos) ? (dma_pos - rx_dma->pos) : (dma_pos + length - rx_dma->pos);
+
+    if (data_len == 0)
+    {
+        return 0;
+    }
+
+    if (data_len > circular_buff_get_free_space(rx_dma->cb))
+    {
+        rx_dma->overrun_cnt++;
+        atomic_store_explicit(&rx_dma->overrun, true, memory_order_release);
+        return 0;
+    }
+
+    rx_dma->pos = dma_pos;
+    circular_buff_commit_write(rx_dma->cb, data_len);
+
+    return data_len;
+}
+
+/**
+ * @brief Check if an overrun stopped the publishing of received bytes
+ *
+ * @param rx_dma DMA reception control block
+ * @return bool true if the reception must be restarted
+ */
+bool uart_rx_dma_is_overrun(uart_rx_dma_t *rx_dma)
+{
+    assert(rx_dma);
+
+    return atomic_load_explicit(&rx_dma->overrun, memory_order_acquire);
+}
@@ -0,0 +1,196 @@
+/**
+ * @file frame_parser.c
+ * @brief  Streaming parser of the frame fields that follow the preamble
+ * @version 0.1
+ *
+ * @note   Each call parses at most up to the end of the current field, so the caller can check
+ *         the header (address, length) before any payload byte is accepted. Bytes are only
+ *         touched once: header and payload bytes are copied and accumulated in the crc together.
+ */
+
+#include "frame_parser.h"
+#include "string.h"
+#include "assert.h"
+
+/**
+ * @brief Shift the bytes parsed through the preamble window until a preamble start is found
+ *
+ * @param parser frame parser control block
+ * @param data   bytes parsed
+ * @param len    number of bytes parsed
+ * @note  The window starts with the preamble of the frame, so a preamble overlapping it is found too.
+ */
+static void parser_track_resync(frame_parser_t *parser, const uint8_t *data, size_t len)
+{
+    uint32_t window = parser->window;
+
+    for (size_t i = 0; (i < len) && !parser->resync_found; i++)
+    {
+        window = (window >> 8) | ((uint32_t)data[i] << 24);
+
+        if (window == PREAMBLE)
+        {
+            parser->resync_found = true;
+        }
+        else
+        {
+            parser->resync_len++;
+        }
+    }
+
+    parser->window = window;
+}
+
+/**
+ * @brief Initialize the parser
+ *
+ * @param parser frame parser control block
+ * @param packet packet the header and payload of every frame are written to
+ */
+void frame_parser_init(frame_parser_t *parser, packet_data_t *packet)
+{
+    assert(parser && packet);
+
+    parser->packet = packet;
+    frame_parser_start(parser);
+}
+
+/**
+ * @brief Start a new frame, the bytes that follow the preamble are expected next
+ *
+ * @param parser frame parser control block
+ */
+void frame_parser_start(frame_parser_t *parser)
+{
+    assert(parser);
+
+    parser->field = FRAME_PARSER_FIELD_HEADER;
+    parser->field_idx = 0;
+    parser->crc = 0;
+    parser->recv_crc.byte = 0;
+    parser->window = PREAMBLE;
+    parser->resync_len = 0;
+    parser->resync_found = false;
+}
+
+/**
+ * @brief Parse a chunk of received bytes
+ *
+ * @param parser   frame parser control block
+ * @param data     received bytes
+ * @param len      number of bytes received
+ * @param consumed set to the number of bytes parsed, see frame_parser_get_resync_len() to release them
+ * @return frame_parser_result_t FRAME_PARSER_MORE if the chunk ended inside a field, otherwise
+ *         the field completed, or the frame verdict. Bytes after a field boundary are not consumed.
+ * @note   Nothing is consumed once a verdict was given, until frame_parser_start().
+ */
+frame_parser_result_t frame_parser_feed(frame_parser_t *parser, const uint8_t *data, size_t len, size_t *consumed)
+{
+    assert(parser && parser->packet && (data || !len) && consumed);
+
+    frame_parser_result_t result = FRAME_PARSER_MORE;
+    size_t idx = 0;
+
+    while ((idx < len) && (result == FRAME_PARSER_MORE) && (parser->field != FRAME_PARSER_FIELD_DONE))
+    {
+        size_t chunk = len - idx;
+        size_t field_left;
+
+        switch (parser->field)
+        {
+        case FRAME_PARSER_FIELD_HEADER:
+            field_left = HEADER_SIZE_BYTES - parser->field_idx;
+            chunk = (chunk < field_left) ? chunk : field_left;
+            crc32_copy_accumulate((uint8_t *)&parser->packet->header + parser->field_idx, &data[idx], chunk, &parser->crc);
+            parser->field_idx += chunk;
+
+            if (parser->field_idx == HEADER_SIZE_BYTES)
+            {
+                parser->field_idx = 0;
+
+                if (parser->packet->header.payload_len > MAX_PAYLOAD_SIZE)
+                {
+                    parser->field = FRAME_PARSER_FIELD_DONE;
+                    result = FRAME_PARSER_HEADER_ERROR;
+                }
+                else
+                {
+                    parser->field = (parser->packet->header.payload_len > 0) ? FRAME_PARSER_FIELD_PAYLOAD
+                                                                             : FRAME_PARSER_FIELD_CRC;
+                    result = FRAME_PARSER_HEADER_DONE;
+                }
+            }
+            break;
+
+        case FRAME_PARSER_FIELD_PAYLOAD:
+            field_left = parser->packet->header.payload_len - parser->field_idx;
+            chunk = (chunk < field_left) ? chunk : field_left;
+            crc32_copy_accumulate(&parser->packet->payload.buffer[parser->field_idx], &data[idx], chunk, &parser->crc);
+            parser->field_idx += chunk;
+
+            if (parser->field_idx == parser->packet->header.payload_len)
+            {
+                parser->field_idx = 0;
+                parser->field = FRAME_PARSER_FIELD_CRC;
+                result = FRAME_PARSER_PAYLOAD_DONE;
+            }
+            break;
+
+        case FRAME_PARSER_FIELD_CRC:
+            field_left = CRC_SIZE_BYTES - parser->field_idx;
+            chunk = (chunk < field_left) ? chunk : field_left;
+            memcpy(&parser->recv_crc.bit[parser->field_idx], &data[idx], chunk);
+            parser->field_idx += chunk;
+
+            if (parser->field_idx == CRC_SIZE_BYTES)
+            {
+                parser->field_idx = 0;
+                parser->field = FRAME_PARSER_FIELD_POSTAMBLE;
+            }
+            break;
+
+        case FRAME_PARSER_FIELD_POSTAMBLE:
+            /* Checked byte per byte, a broken frame is rejected at its first wrong byte */
+            chunk = 1;
+
+            if (data[idx] != protocol_postamble.bit[parser->field_idx])
+            {
+                /* The wrong byte may start the next preamble, it is left to the caller */
+                chunk = 0;
+                parser->field = FRAME_PARSER_FIELD_DONE;
+                result = FRAME_PARSER_POSTAMBLE_ERROR;
+            }
+            else if (++parser->field_idx == POSTAMBLE_SIZE_BYTES)
+            {
+                parser->field = FRAME_PARSER_FIELD_DONE;
+                result = (parser->recv_crc.byte == parser->crc) ? FRAME_PARSER_FRAME_OK : FRAME_PARSER_CRC_ERROR;
+            }
+            break;
+
+        default:
+            chunk = 0;
+            break;
+        }
+
+        parser_track_resync(parser, &data[idx], chunk);
+        idx += chunk;
+    }
+
+    *consumed = idx;
+    return result;
+}
+
+/**
+ * @brief Get the number of bytes where no preamble can start
+ *
+ * @param parser frame parser control block
+ * @return size_t number of bytes, counted from the 2nd byte of the frame preamble, that can be
+ *         released if the frame is rejected. The preamble hunt restarts on the next byte.
+ * @note   It only grows while the frame is parsed, it stops at the first preamble found.
+ */
+size_t frame_parser_get_resync_len(const frame_parser_t *parser)
+{
+    assert(parser);
+
+    return parser->resync_len;
+}
@@ -0,0 +1,357 @@
+/**
+ * @file host_comm_port.c
+ * @author Bayron Cabrera (bayron.cabrera@titoma.com)
+ * @brief  Communication ports, one rx/tx state machine pair per enabled serial port
+ * @version 0.1
+ * 
+ */
+
+#include "host_comm_port.h"
+#include "string.h"
+
+/**@brief Enable/Disable debug messages */
+#define HOST_COMM_PORT_DEBUG 0
+#define HOST_COMM_PORT_TAG "host comm port : "
+
+/**@brief debug function for comm port operations  */
+#if HOST_COMM_PORT_DEBUG
+#define host_comm_port_dbg(format, ...) printf(HOST_COMM_PORT_TAG format, ##__VA_ARGS__)
+#else
+#define host_comm_port_dbg(format, ...) \
+    do                                    \
+    { /* Do nothing */                    \
+    } while (0)
+#endif
+
+/*@brief Communication port objects, indexed by serial port */
+static host_comm_port_t host_comm_ports[UART_PORT_CNT];
+
+/*@brief Bus address of the node on each port */
+static const uint8_t host_comm_node_addr[UART_PORT_CNT] =
+{
+    [UART_PORT_1] = HOST_COMM_PORT_1_NODE_ADDR,
+    [UART_PORT_2] = HOST_COMM_PORT_2_NODE_ADDR,
+    [UART_PORT_6] = HOST_COMM_PORT_6_NODE_ADDR,
+};
+
+
+/**
+ * @brief Handle a baudrate change request, answered at the current baudrate
+ */
+static void baudrate_on_set_request(host_comm_port_t *port, packet_data_t *packet)
+{
+    uint32_t current = uart_get_baudrate(port->uart);
+    uint32_t baudrate;
+
+    /* Payload length checked by the dispatch table */
+    memcpy(&baudrate, packet->payload.buffer, sizeof(baudrate));
+
+    if (port->baudrate.state == BAUDRATE_ST_IDLE && baudrate != current && uart_check_baudrate(port->uart, baudrate))
+    {
+        port->baudrate.requested = baudrate;
+        port->baudrate.fallback = current;
+        port->baudrate.state = BAUDRATE_ST_SWITCH_PENDING;
+        host_comm_port_dbg("baudrate request \t[ %lu accepted ]\r\n", baudrate);
+    }
+    else
+    {
+        /* Rejected, the link stays at the current baudrate */
+        host_comm_port_dbg("baudrate request \t[ %lu rejected ]\r\n", baudrate);
+        baudrate = current;
+    }
+
+    host_comm_tx_fsm_send_packet(&port->tx, TARGET_TO_HOST_RES_BAUDRATE, (uint8_t *)&baudrate, sizeof(baudrate), false);
+}
+
+/**
+ * @brief Handle a probe frame, a probe received after a switch confirms the new baudrate
+ */
+static void baudrate_on_probe(host_comm_port_t *port, packet_data_t *packet)
+{
+    if (port->baudrate.state == BAUDRATE_ST_PROBE_WAIT)
+    {
+        time_event_stop(&port->baudrate.probe_timeout);
+        port->baudrate.state = BAUDRATE_ST_IDLE;
+        host_comm_port_dbg("baudrate \t[ %lu confirmed ]\r\n", port->baudrate.requested);
+    }
+
+    host_comm_tx_fsm_send_packet(&port->tx, TARGET_TO_HOST_RES_BAUDRATE_PROBE, packet->payload.buffer,
+                                 packet->header.payload_len, false);
+}
+
+/**
+ * @brief Switch the baudrate at a frame boundary and fall back if it is not confirmed in time
+ */
+static void baudrate_update(host_comm_port_t *port)
+{
+    /* Frame boundary: nothing pending to transmit at the current baudrate and no frame being received */
+    bool boundary = host_comm_tx_fsm_is_idle(&port->tx) &&
+                    host_comm_rx_fsm_is_state_active(&port->rx, st_comm_rx_preamble_proc);
+
+    switch (port->baudrate.state)
+    {
+    case BAUDRATE_ST_SWITCH_PENDING:
+        if (boundary && uart_set_baudrate(port->uart, port->baudrate.requested))
+        {
+            /* Bytes received around the switch are garbage */
+            uart_clear_rx_data(port->uart);
+            time_event_start(&port->baudrate.probe_timeout, BAUDRATE_PROBE_TIMEOUT_MS);
+            port->baudrate.state = BAUDRATE_ST_PROBE_WAIT;
+        }
+        break;
+
+    case BAUDRATE_ST_PROBE_WAIT:
+        if (time_event_is_raised(&port->baudrate.probe_timeout) && boundary &&
+            uart_set_baudrate(port->uart, port->baudrate.fallback))
+        {
+            uart_clear_rx_data(port->uart);
+            time_event_stop(&port->baudrate.probe_timeout);
+            port->baudrate.state = BAUDRATE_ST_IDLE;
+            host_comm_port_dbg("baudrate \t[ probe timeout, fallback %lu ]\r\n", port->baudrate.fallback);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Handle a poll, the bus turn was already granted by the ACK of the frame
+ */
+static void poll_on_request(host_comm_port_t *port, packet_data_t *packet)
+{
+    (void)port;
+    (void)packet;
+}
+
+/**
+ * @brief Handle the answer of the host to a packet sent with ack expected
+ */
+static void tx_on_ack(host_comm_port_t *port, packet_data_t *packet)
+{
+    host_comm_tx_fsm_set_ext_event(&port->tx, (packet->header.type.cmd == HOST_TO_TARGET_RES_ACK)
+                                                  ? ev_ext_comm_tx_ack_received
+                                                  : ev_ext_comm_tx_nack_received);
+}
+
+/*@brief Command dispatch table, indexed by packet type, see host_comm_port_register_cmd() */
+static host_comm_cmd_t host_comm_cmd_table[UINT8_MAX + 1] =
+{
+    [HOST_TO_TARGET_CMD_SET_BAUDRATE]   = { baudrate_on_set_request, sizeof(uint32_t), sizeof(uint32_t), HOST_COMM_CMD_FLAG_NONE },
+    [HOST_TO_TARGET_CMD_BAUDRATE_PROBE] = { baudrate_on_probe, 0, MAX_PAYLOAD_SIZE, HOST_COMM_CMD_FLAG_NONE },
+    [HOST_TO_TARGET_CMD_POLL]           = { poll_on_request, 0, 0, HOST_COMM_CMD_FLAG_NONE },
+    [HOST_TO_TARGET_RES_ACK]            = { tx_on_ack, 0, 0, HOST_COMM_CMD_FLAG_NONE },
+    [HOST_TO_TARGET_RES_NACK]           = { tx_on_ack, 0, 0, HOST_COMM_CMD_FLAG_NONE },
+};
+
+/**
+ * @brief In-band flow control, tell the host to stop or resume when the rx buffer crosses its watermarks
+ */
+static void flow_ctrl_update(host_comm_port_t *port)
+{
+    bool stopped = uart_rx_flow_is_stopped(port->uart);
+
+    if (stopped == port->flow_off_sent)
+    {
+        return;
+    }
+
+    /* Retried on the next run if the frame does not fit in the uart */
+    if (host_comm_tx_fsm_send_event_now(&port->tx, stopped ? TARGET_TO_HOST_EVT_RX_FLOW_OFF : TARGET_TO_HOST_EVT_RX_FLOW_ON))
+    {
+        port->flow_off_sent = stopped;
+        host_comm_port_dbg("flow control \t[ %s ]\r\n", stopped ? "off" : "on");
+    }
+}
+
+/**
+ * @brief Dispatch a packet received by the rx fsm to the handler of its type and release it
+ * @note  The handler run time is measured with the timestamp cycle counter, see host_comm_port_t.cmd
+ */
+static void host_comm_port_process_packet(host_comm_port_t *port, host_comm_rx_packet_t *rx_packet)
+{
+    packet_data_t *packet = &rx_packet->packet;
+    const host_comm_cmd_t *cmd = &host_comm_cmd_table[packet->header.type.cmd];
+    bool broadcast = (rx_packet->addr_match == PROTOCOL_ADDR_MATCH_BROADCAST);
+
+    if ((cmd->handler != NULL) &&
+        (packet->header.payload_len >= cmd->min_len) && (packet->header.payload_len <= cmd->max_len) &&
+        (!broadcast || (cmd->flags & HOST_COMM_CMD_FLAG_BROADCAST)))
+    {
+        uint32_t start = timestamp_now();
+
+        cmd->handler(port, packet);
+
+        port->cmd.last_cycles = timestamp_elapsed(start);
+        if (port->cmd.last_cycles > port->cmd.max_cycles)
+        {
+            port->cmd.max_cycles = port->cmd.last_cycles;
+        }
+        port->cmd.handled_cnt++;
+
+        host_comm_port_dbg("packet 0x%.2X \t[ latency %lu us, handler %lu us ]\r\n", packet->header.type.cmd,
+                           timestamp_to_us(timestamp_elapsed(rx_packet->arrival_end)),
+                           timestamp_to_us(port->cmd.last_cycles));
+    }
+    else
+    {
+        port->cmd.rejected_cnt++;
+        host_comm_port_dbg("packet 0x%.2X \t[ rejected ]\r\n", packet->header.type.cmd);
+
+        /* Broadcast frames are never answered, all nodes would answer at once */
+        if (!broadcast)
+        {
+            host_comm_tx_fsm_send_packet(&port->tx, TARGET_TO_HOST_EVT_HANDLER_ERROR, &packet->header.type.cmd, 1, false);
+        }
+    }
+
+    host_comm_rx_fsm_release_packet(&port->rx, rx_packet);
+}
+
+/**
+ * @brief Parse the frames received by a port within the drain budget, then process the packets
+ * 
+ * @param port communication port
+ * @return uint32_t number of frames completed
+ * @note  The rx fsm parses into a pool of packets, so the frames completed per run are bounded by
+ *        HOST_COMM_RX_PACKET_POOL_SIZE as well.
+ */
+static uint32_t host_comm_port_drain_rx(host_comm_port_t *port)
+{
+    host_comm_rx_packet_t *rx_packet;
+    uint32_t frame_cnt;
+
+#if HOST_COMM_PORT_RX_DRAIN_ENABLE
+    size_t budget = HOST_COMM_PORT_DRAIN_MAX_BYTES;
+
+    frame_cnt = host_comm_rx_fsm_drain(&port->rx, &budget);
+#else
+    uint32_t packet_cnt = port->rx.iface.packet_cnt;
+
+    host_comm_rx_fsm_run(&port->rx);
+    frame_cnt = port->rx.iface.packet_cnt - packet_cnt;
+#endif
+
+    while ((rx_packet = host_comm_rx_fsm_get_packet(&port->rx)) != NULL)
+    {
+        host_comm_port_process_packet(port, rx_packet);
+    }
+
+    return frame_cnt;
+}
+
+/**
+ * @brief Init a communication port for every enabled serial port
+ * @note  uart_init() must be called before.
+ */
+void host_comm_port_init(void)
+{
+    for (size_t port_idx = 0; port_idx < UART_PORT_CNT; port_idx++)
+    {
+        host_comm_port_t *port = &host_comm_ports[port_idx];
+
+        port->uart = uart_get_port((uart_port_id_t)port_idx);
+
+        if (port->uart != NULL)
+        {
+            host_comm_tx_fsm_init(&port->tx, port->uart, host_comm_node_addr[port_idx]);
+            host_comm_rx_fsm_init(&port->rx, port->uart, &port->tx, host_comm_node_addr[port_idx]);
+
+            port->baudrate.state = BAUDRATE_ST_IDLE;
+            time_event_stop(&port->baudrate.probe_timeout);
+            port->flow_off_sent = false;
+            memset(&port->cmd, 0, sizeof(port->cmd));
+        }
+    }
+}
+
+/**
+ * @brief Get a communication port
+ * 
+ * @param id serial port
+ * @return host_comm_port_t* communication port, NULL if the serial port is not enabled
+ */
+host_comm_port_t *host_comm_port_get(uart_port_id_t id)
+{
+    if (id >= UART_PORT_CNT || host_comm_ports[id].uart == NULL)
+    {
+        return NULL;
+    }
+
+    return &host_comm_ports[id];
+}
+
+/**
+ * @brief Run the state machines of every communication port
+ * @return uint32_t number of frames received and processed in this run, all ports together
+ * @note  Packets received are processed before the rx fsm goes on with the next one.
+ */
+uint32_t host_comm_port_run(void)
+{
+    uint32_t frame_cnt = 0;
+
+    for (size_t port_idx = 0; port_idx < UART_PORT_CNT; port_idx++)
+    {
+        host_comm_port_t *port = &host_comm_ports[port_idx];
+
+        if (port->uart != NULL)
+        {
+            /* Not on a bus, a node must not transmit out of its turn */
+            if (uart_get_flow_ctrl(port->uart) == UART_FLOW_CTRL_IN_BAND && !uart_is_rs485(port->uart))
+            {
+                flow_ctrl_update(port);
+            }
+
+            frame_cnt += host_comm_port_drain_rx(port);
+
+            host_comm_tx_fsm_run(&port->tx);
+            uart_tx_service(port->uart);
+            baudrate_update(port);
+        }
+    }
+
+    return frame_cnt;
+}
+
+/**
+ * @brief Update the time events of every communication port, called every ms
+ */
+void host_comm_port_time_event_update(void)
+{
+    for (size_t port_idx = 0; port_idx < UART_PORT_CNT; port_idx++)
+    {
+        host_comm_port_t *port = &host_comm_ports[port_idx];
+
+        if (port->uart != NULL)
+        {
+            host_comm_tx_fsm_time_event_update(&port->tx);
+            host_comm_rx_fsm_time_event_update(&port->rx);
+            time_event_update(&port->baudrate.probe_timeout);
+        }
+    }
+}
+
+/**
+ * @brief Register the handler of a packet type, on every port
+ * 
+ * @param type    packet type
+ * @param handler handler of the type, NULL to stop handling it
+ * @param min_len min payload length accepted
+ * @param max_len max payload length accepted, up to MAX_PAYLOAD_SIZE
+ * @param flags   HOST_COMM_CMD_FLAG_x
+ * @return uint8_t 1 if registered, 0 if the payload bounds are not valid
+ * @note  To be called from the same context as host_comm_port_run(), a registered type replaces
+ *        the built-in handler if any.
+ */
+uint8_t host_comm_port_register_cmd(uint8_t type, host_comm_cmd_handler_t handler, uint16_t min_len, uint16_t max_len, uint8_t flags)
+{
+    if (min_len > max_len || max_len > MAX_PAYLOAD_SIZE)
+    {
+        return 0;
+    }
+
+    host_comm_cmd_table[type] = (host_comm_cmd_t){ handler, min_len, max_len, flags };
+
+    return 1;
+}
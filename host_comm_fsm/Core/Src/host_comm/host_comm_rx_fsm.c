@@ -15,9 +15,6 @@
 #endif
 
 
-/**@ Extern handle for server communication state machine */
-host_comm_rx_fsm_t host_comm_rx_handle;
-
 /**@ 'Preamble process' state related functions */
 static void enter_seq_preamble_proc(host_comm_rx_fsm_t *handle);
 static bool preamble_proc_on_react(host_comm_rx_fsm_t *handle, const bool try_transition);
@@ -49,6 +46,127 @@ static void enter_seq_packet_ready(host_comm_rx_fsm_t *handle);
 static void entry_action_packet_ready(host_comm_rx_fsm_t *handle);
 static bool packet_ready_on_react(host_comm_rx_fsm_t *handle, const bool try_transition);
 
+/**@ 'Skip frame' state related functions */
+static void enter_seq_skip_proc(host_comm_rx_fsm_t *handle);
+static void entry_action_skip_proc(host_comm_rx_fsm_t *handle);
+static void during_action_skip_proc(host_comm_rx_fsm_t *handle);
+static void exit_action_skip_proc(host_comm_rx_fsm_t *handle);
+static bool skip_proc_on_react(host_comm_rx_fsm_t *handle, const bool try_transition);
+
+/**
+ * @brief Return the arrival time of a byte in the rx buffer, now if it is not timestamped
+ */
+static uint32_t rx_arrival(host_comm_rx_fsm_t *handle, size_t offset)
+{
+	uint32_t timestamp;
+
+	if (!uart_get_rx_timestamp(handle->port, offset, &timestamp))
+	{
+		timestamp = timestamp_now();
+	}
+
+	return timestamp;
+}
+
+/**
+ * @brief Feed the received bytes to the frame parser, up to the end of the current field
+ * @note  Parsed bytes are released as soon as the parser tells no preamble can start on them, so
+ *        the frame does not pile up in the rx buffer. The bytes from the first preamble found
+ *        inside the frame on are held, they are hunted again if the frame is rejected.
+ */
+static frame_parser_result_t rx_parse(host_comm_rx_fsm_t *handle)
+{
+	circular_buff_region_t region[2];
+	frame_parser_result_t result = FRAME_PARSER_MORE;
+	size_t skip = handle->iface.parse_offset;
+	size_t parsed = 0;
+
+	uart_peek_rx_data(handle->port, region);
+
+	for (size_t reg_idx = 0; (reg_idx < 2) && (result == FRAME_PARSER_MORE); reg_idx++)
+	{
+		/* Bytes held in the buffer were already parsed */
+		size_t reg_skip = (skip < region[reg_idx].len) ? skip : region[reg_idx].len;
+		size_t consumed;
+
+		skip -= reg_skip;
+		result = frame_parser_feed(&handle->iface.parser, region[reg_idx].data + reg_skip,
+								   region[reg_idx].len - reg_skip, &consumed);
+		parsed += consumed;
+	}
+
+	if (parsed > 0)
+	{
+		size_t resync_len = frame_parser_get_resync_len(&handle->iface.parser);
+		size_t release = (resync_len > handle->iface.released) ? (resync_len - handle->iface.released) : 0;
+
+		handle->iface.parse_offset += parsed;
+		handle->iface.bytes_processed += parsed;
+		handle->iface.arrival_end = rx_arrival(handle, handle->iface.parse_offset - 1);
+
+		/* Holding the rest of the frame must not stop the host for good, the rescan is given up */
+		if (handle->iface.parse_offset >= UART_RX_HIGH_WATERMARK)
+		{
+			release = handle->iface.parse_offset;
+		}
+
+		if (release > 0)
+		{
+			uart_commit_rx_data(handle->port, release);
+			handle->iface.released += release;
+			handle->iface.parse_offset -= release;
+		}
+	}
+
+	return result;
+}
+
+/**
+ * @brief Release the bytes of the frame held in the rx buffer
+ *
+ * @param handle rx fsm handle
+ * @param accepted true to release the whole frame parsed, false to keep the bytes where a preamble
+ *                 may start, so the preamble hunt restarts one byte after the rejected preamble
+ */
+static void rx_frame_done(host_comm_rx_fsm_t *handle, bool accepted)
+{
+	if (accepted)
+	{
+		uart_commit_rx_data(handle->port, handle->iface.parse_offset);
+	}
+
+	handle->iface.parse_offset = 0;
+}
+
+/**
+ * @brief Start a field timeout counting from the arrival of the previous field
+ * @note  The fsm may get to the field late, the time elapsed since the arrival is deducted.
+ */
+static void rx_timeout_start(time_event_t *timeout, uint32_t time_ms, uint32_t arrival)
+{
+	uint32_t elapsed_ms = timestamp_to_us(timestamp_elapsed(arrival)) / 1000U;
+
+	time_event_start(timeout, (elapsed_ms < time_ms) ? (time_ms - elapsed_ms) : 1);
+}
+
+/**
+ * @brief Answer a received frame with ACK/NACK
+ * @note  On a bus only the node addressed answers, frames of other nodes, broadcast frames and
+ *        frames which address is unknown are not answered. The answer starts the bus turn of the node.
+ *        Responses of the host (ACK/NACK) are not answered either.
+ */
+static void rx_reply(host_comm_rx_fsm_t *handle, uint8_t res)
+{
+	if (handle->iface.addr_match != PROTOCOL_ADDR_MATCH_UNICAST ||
+		IS_HOST_TO_TARGET_RES(handle->iface.slot->packet.header.type.res))
+	{
+		return;
+	}
+
+	host_comm_tx_fsm_send_packet_no_payload(handle->tx, res, false);
+	host_comm_tx_fsm_grant_bus_turn(handle->tx);
+}
+
 /* Entry action for state machine */
 void host_comm_rx_fsm_enter(host_comm_rx_fsm_t *handle)
 {
@@ -74,30 +192,33 @@ static void enter_seq_preamble_proc(host_comm_rx_fsm_t *handle)
 
 static uint8_t during_action_preamble_proc(host_comm_rx_fsm_t *handle)
 {
-	if (uart_get_rx_data_len() >= PREAMBLE_SIZE_BYTES)
-	{
-		uint8_t preamble;
-
-		uart_read_rx_data((uint8_t *)&preamble, 1);
-		if (preamble != protocol_preamble.bit[0])
-			return 0;
+	size_t offset;
 
-		uart_read_rx_data((uint8_t *)&preamble, 1);
-		if (preamble != protocol_preamble.bit[1])
-			return 0;
+	if (uart_find_rx_data(handle->port, protocol_preamble.bit, PREAMBLE_SIZE_BYTES, &offset))
+	{
+		handle->iface.arrival_start = rx_arrival(handle, offset + PREAMBLE_SIZE_BYTES - 1);
+		handle->iface.arrival_end = handle->iface.arrival_start;
+		frame_parser_start(&handle->iface.parser);
 
-		uart_read_rx_data((uint8_t *)&preamble, 1);
-		if (preamble != protocol_preamble.bit[2])
-			return 0;
+		/* On a bus the frame is not answered until its header tells it is for this node */
+		handle->iface.addr_match = (handle->node_addr == PROTOCOL_ADDR_P2P) ? PROTOCOL_ADDR_MATCH_UNICAST
+																			  : PROTOCOL_ADDR_MATCH_NONE;
 
-		uart_read_rx_data((uint8_t *)&preamble, 1);
-		if (preamble != protocol_preamble.bit[3])
-			return 0;
+		/* Discard any garbage in front of the preamble and its first byte, the rest of the preamble
+		 * is held in case another preamble overlaps it */
+		uart_commit_rx_data(handle->port, offset + 1);
+		handle->iface.parse_offset = PREAMBLE_SIZE_BYTES - 1;
+		handle->iface.released = 0;
+		handle->iface.bytes_processed += offset + PREAMBLE_SIZE_BYTES;
 
 		host_comm_rx_dbg("ev_internal \t[ preamble_ok ]\r\n");
 		handle->event.internal = ev_int_preamble_ok;
 		return 1;
 	}
+
+	/* Discard bytes where no preamble can start, keep a possible partial preamble */
+	uart_commit_rx_data(handle->port, offset);
+	handle->iface.bytes_processed += offset;
 	return 0;
 }
 
@@ -137,7 +258,8 @@ static void enter_seq_header_proc(host_comm_rx_fsm_t *handle)
 
 static void entry_action_header_proc(host_comm_rx_fsm_t *handle)
 {
-	time_event_start(&handle->event.time.header_timeout, (HEADER_BYTES_TIMEOUT_MS));
+	uint32_t time_ms = HEADER_BYTES_TIMEOUT_MS + uart_bytes_to_ms(handle->port, HEADER_SIZE_BYTES);
+	rx_timeout_start(&handle->event.time.header_timeout, time_ms, handle->iface.arrival_start);
 }
 
 static void exit_action_header_proc(host_comm_rx_fsm_t *handle)
@@ -148,18 +270,29 @@ static void exit_action_header_proc(host_comm_rx_fsm_t *handle)
 
 static void during_action_header_proc(host_comm_rx_fsm_t *handle)
 {
-	if (uart_get_rx_data_len() >= HEADER_SIZE_BYTES)
+	frame_parser_result_t result = rx_parse(handle);
+
+	if (result == FRAME_PARSER_HEADER_DONE || result == FRAME_PARSER_HEADER_ERROR)
 	{
-		/* 1. Read Header from server buffer */
-		uart_read_rx_data((uint8_t *)&handle->iface.packet.header, HEADER_SIZE_BYTES);
+		/* Header is checked before any payload byte is parsed */
+		handle->iface.addr_match = protocol_check_addr(&handle->iface.slot->packet.header, handle->node_addr);
 
-		if (protocol_check_valid_header(&handle->iface.packet))
+		if (handle->iface.addr_match == PROTOCOL_ADDR_MATCH_NONE &&
+			handle->iface.slot->packet.header.payload_len <= MAX_PAYLOAD_SIZE)
+		{
+			/* Frame of another node on the bus, it is dropped as it arrives */
+			host_comm_rx_dbg("ev_internal \t[ header_skip ]\r\n");
+			handle->event.internal = ev_int_header_skip;
+		}
+		else if (protocol_check_valid_header(&handle->iface.slot->packet) &&
+			(handle->iface.slot->packet.header.payload_len <= MAX_PAYLOAD_SIZE))
 		{
 			host_comm_rx_dbg("ev_internal \t[ header_ok ]\r\n");
 			handle->event.internal = ev_int_header_ok;
 		}
 		else
 		{
+			/* The preamble hunt restarts one byte after the rejected preamble */
 			host_comm_rx_dbg("ev_internal \t[ header_error ]\r\n");
 			handle->event.internal = ev_int_header_error;
 		}
@@ -179,7 +312,7 @@ static bool header_proc_on_react(host_comm_rx_fsm_t *handle, const bool try_tran
 			exit_action_header_proc(handle);
 
 			/*Choice Enter sequence */
-			if (handle->iface.packet.header.payload_len > 0)
+			if (handle->iface.slot->packet.header.payload_len > 0)
 			{
 				host_comm_rx_dbg("guard \t[ payload len > 0 ]\r\n");
 				enter_seq_payload_proc(handle);
@@ -191,6 +324,18 @@ static bool header_proc_on_react(host_comm_rx_fsm_t *handle, const bool try_tran
 			}
 		}
 
+		else if (handle->event.internal == ev_int_header_skip)
+		{
+			/*Exit Action */
+			exit_action_header_proc(handle);
+
+			/*Transition Action, the frame is genuine, only not for this node*/
+			rx_frame_done(handle, true);
+
+			/*Enter sequence */
+			enter_seq_skip_proc(handle);
+		}
+
 		else if (time_event_is_raised(&handle->event.time.header_timeout) == true ||
 				 handle->event.internal == ev_int_header_error)
 		{
@@ -198,11 +343,12 @@ static bool header_proc_on_react(host_comm_rx_fsm_t *handle, const bool try_tran
 			/*Transition Action*/
 			if (time_event_is_raised(&handle->event.time.header_timeout) == true)
 			{
-				uart_clear_rx_data();
 				host_comm_rx_dbg("ev_internal \t[ header timeout ]\r\n");
 			}
 
-			host_comm_tx_fsm_send_packet_no_payload(&host_comm_tx_handle, TARGET_TO_HOST_RES_NACK, false);
+			rx_frame_done(handle, false);
+
+			rx_reply(handle, TARGET_TO_HOST_RES_NACK);
 
 			/*Exit Action*/
 			exit_action_header_proc(handle);
@@ -237,8 +383,8 @@ static void enter_seq_payload_proc(host_comm_rx_fsm_t *handle)
 
 static void entry_action_payload_proc(host_comm_rx_fsm_t *handle)
 {
-	uint16_t time_ms = handle->iface.packet.header.payload_len * 1;
-	time_event_start(&handle->event.time.payload_timeout, time_ms);
+	uint32_t time_ms = PAYLOAD_BYTES_TIMEOUT_MS + uart_bytes_to_ms(handle->port, handle->iface.slot->packet.header.payload_len);
+	rx_timeout_start(&handle->event.time.payload_timeout, time_ms, handle->iface.arrival_end);
 }
 
 static void exit_action_payload_proc(host_comm_rx_fsm_t *handle)
@@ -248,14 +394,11 @@ static void exit_action_payload_proc(host_comm_rx_fsm_t *handle)
 
 static void during_action_payload_proc(host_comm_rx_fsm_t *handle)
 {
-	uint8_t exp_data_len = handle->iface.packet.header.payload_len;
-
-	if (uart_get_rx_data_len() >= exp_data_len)
+	/* Payload is copied and accumulated in the crc as it arrives */
+	if (rx_parse(handle) == FRAME_PARSER_PAYLOAD_DONE)
 	{
 		host_comm_rx_dbg("ev_internal \t[ payload_ok ]\r\n");
 		handle->event.internal = ev_int_payload_ok;
-		uart_read_rx_data((uint8_t *)&handle->iface.packet.payload,
-								   handle->iface.packet.header.payload_len);
 	}
 }
 
@@ -282,8 +425,8 @@ static bool payload_proc_on_react(host_comm_rx_fsm_t *handle, const bool try_tra
 
 			/*Transition Action*/
 			host_comm_rx_dbg("ev_internal \t[ timeout payload ] \r\n");
-			uart_clear_rx_data();
-			host_comm_tx_fsm_send_packet_no_payload(&host_comm_tx_handle, TARGET_TO_HOST_RES_NACK, false);
+			rx_frame_done(handle, false);
+			rx_reply(handle, TARGET_TO_HOST_RES_NACK);
 
 			/*Enter Sequence*/
 			enter_seq_preamble_proc(handle);
@@ -312,7 +455,8 @@ static void enter_seq_crc_and_postamble_proc(host_comm_rx_fsm_t *handle)
 
 static void entry_action_crc_and_postamble_proc(host_comm_rx_fsm_t *handle)
 {
-	time_event_start(&handle->event.time.crc_and_postamble_timeout, POSTAMBLE_BYTES_TIMEOUT_MS);
+	uint32_t time_ms = POSTAMBLE_BYTES_TIMEOUT_MS + uart_bytes_to_ms(handle->port, CRC_SIZE_BYTES + POSTAMBLE_SIZE_BYTES);
+	rx_timeout_start(&handle->event.time.crc_and_postamble_timeout, time_ms, handle->iface.arrival_end);
 }
 
 static void exit_action_crc_and_postamble_proc(host_comm_rx_fsm_t *handle)
@@ -322,37 +466,28 @@ static void exit_action_crc_and_postamble_proc(host_comm_rx_fsm_t *handle)
 
 static void during_action_crc_and_postamble_proc(host_comm_rx_fsm_t *handle)
 {
-	uint8_t exp_data_len = CRC_SIZE_BYTES + POSTAMBLE_SIZE_BYTES;
-
-	if (uart_get_rx_data_len() >= exp_data_len)
+	/* The crc is already accumulated, the verdict comes with the last postamble byte */
+	switch (rx_parse(handle))
 	{
-		uint32_t recv_crc;
-		uint32_t postamble;
-
-		uart_read_rx_data((uint8_t*)&recv_crc, CRC_SIZE_BYTES);
-		uart_read_rx_data((uint8_t*)&postamble, POSTAMBLE_SIZE_BYTES);
+	case FRAME_PARSER_POSTAMBLE_ERROR:
+		host_comm_rx_dbg("ev_internal \t[ postamble error ] \r\n");
+		handle->event.internal = ev_int_postamble_error;
+		break;
 
-		size_t packet_len = HEADER_SIZE_BYTES + handle->iface.packet.header.payload_len;
-		uint32_t crc = 0;
+	case FRAME_PARSER_CRC_ERROR:
+		host_comm_rx_dbg("ev_internal \t[ crc error ]\r\n");
+		host_comm_rx_dbg("expected crc \t[0x%.8X] != recv [0x%.8X]\r\n", handle->iface.parser.crc,
+						 handle->iface.parser.recv_crc.byte);
+		handle->event.internal = ev_int_crc_error;
+		break;
 
-		crc32_accumulate((uint8_t *)&handle->iface.packet.header, packet_len, &crc);
+	case FRAME_PARSER_FRAME_OK:
+		host_comm_rx_dbg("ev_internal \t[ crc and postamble ok ]\r\n");
+		handle->event.internal = ev_int_crc_and_postamble_ok;
+		break;
 
-		if (crc != recv_crc)
-		{
-			host_comm_rx_dbg("ev_internal \t[ crc error ]\r\n");
-			host_comm_rx_dbg("expected crc \t[0x%.8X] != recv [0x%.8X]\r\n", crc, recv_crc);
-			handle->event.internal = ev_int_crc_error;
-		}
-		else
-		{
-			if (postamble != POSTAMBLE)
-			{
-				host_comm_rx_dbg("ev_internal \t[ postamble error ] \r\n");
-				handle->event.internal = ev_int_postamble_error;
-			}
-			host_comm_rx_dbg("ev_internal \t[ crc and postamble ok ]\r\n");
-			handle->event.internal = ev_int_crc_and_postamble_ok;
-		}
+	default:
+		break;
 	}
 }
 
@@ -369,7 +504,8 @@ static bool crc_and_postamble_proc_on_react(host_comm_rx_fsm_t *handle, const bo
 			exit_action_crc_and_postamble_proc(handle);
 
 			/*Transition Action*/
-			host_comm_tx_fsm_send_packet_no_payload(&host_comm_tx_handle, TARGET_TO_HOST_RES_ACK, false);
+			rx_frame_done(handle, true);
+			rx_reply(handle, TARGET_TO_HOST_RES_ACK);
 
 			/*Enter sequence */
 			enter_seq_packet_ready(handle);
@@ -386,10 +522,11 @@ static bool crc_and_postamble_proc_on_react(host_comm_rx_fsm_t *handle, const bo
 			if (time_event_is_raised(&handle->event.time.crc_and_postamble_timeout) == true)
 			{
 				host_comm_rx_dbg("ev_internal \t[ timeout crc and postamble] \r\n");
-				uart_clear_rx_data();
 			}
 
-			host_comm_tx_fsm_send_packet_no_payload(&host_comm_tx_handle, TARGET_TO_HOST_RES_NACK, false);
+			rx_frame_done(handle, false);
+
+			rx_reply(handle, TARGET_TO_HOST_RES_NACK);
 
 			/*Enter Sequence*/
 			enter_seq_preamble_proc(handle);
@@ -418,8 +555,27 @@ static void enter_seq_packet_ready(host_comm_rx_fsm_t *handle)
 
 static void entry_action_packet_ready(host_comm_rx_fsm_t *handle)
 {
-	/*Notify or enqueue data for other fsm process*/
+	/*Hand the packet over to the consumer, the ready queue has room for every packet of the pool*/
+	handle->iface.slot->arrival_end = handle->iface.arrival_end;
+	handle->iface.slot->addr_match = handle->iface.addr_match;
+	host_comm_rx_packet_queue_push(&handle->ready, &handle->iface.slot);
+	handle->iface.slot = NULL;
+	handle->iface.packet_cnt++;
+}
 
+/**
+ * @brief Take a free packet to parse the next frame into
+ * @return bool false if every packet is waiting for the consumer
+ */
+static bool rx_take_slot(host_comm_rx_fsm_t *handle)
+{
+	if (!host_comm_rx_packet_queue_pop(&handle->free, &handle->iface.slot))
+	{
+		return false;
+	}
+
+	frame_parser_init(&handle->iface.parser, &handle->iface.slot->packet);
+	return true;
 }
 
 static bool packet_ready_on_react(host_comm_rx_fsm_t *handle, const bool try_transition)
@@ -428,7 +584,8 @@ static bool packet_ready_on_react(host_comm_rx_fsm_t *handle, const bool try_tra
 
 	if (try_transition == true)
 	{
-		if (handle->event.external == ev_ext_comm_rx_packet_proccessed)
+		/*The preamble hunt goes on as soon as a packet is free, the rx buffer holds the data meanwhile*/
+		if (rx_take_slot(handle))
 			enter_seq_preamble_proc(handle);
 
 		else
@@ -438,6 +595,75 @@ static bool packet_ready_on_react(host_comm_rx_fsm_t *handle, const bool try_tra
 	return did_transition;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**@ 'Skip frame' state related functions */
+
+static void enter_seq_skip_proc(host_comm_rx_fsm_t *handle)
+{
+	host_comm_rx_dbg("enter seq \t[ skip_frame_st ]\r\n");
+	host_comm_rx_fsm_set_next_state(handle, st_comm_rx_skip_proc);
+	entry_action_skip_proc(handle);
+}
+
+static void entry_action_skip_proc(host_comm_rx_fsm_t *handle)
+{
+	/* Header already parsed, the rest of the frame is dropped */
+	handle->iface.skip_len = handle->iface.slot->packet.header.payload_len + CRC_SIZE_BYTES + POSTAMBLE_SIZE_BYTES;
+
+	uint32_t time_ms = PAYLOAD_BYTES_TIMEOUT_MS + uart_bytes_to_ms(handle->port, handle->iface.skip_len);
+	rx_timeout_start(&handle->event.time.skip_timeout, time_ms, handle->iface.arrival_end);
+}
+
+static void exit_action_skip_proc(host_comm_rx_fsm_t *handle)
+{
+	time_event_stop(&handle->event.time.skip_timeout);
+}
+
+static void during_action_skip_proc(host_comm_rx_fsm_t *handle)
+{
+	size_t data_len = uart_get_rx_data_len(handle->port);
+
+	/* Bytes are released as soon as they arrive, the frame never piles up in the buffer */
+	data_len = (data_len < handle->iface.skip_len) ? data_len : handle->iface.skip_len;
+	uart_commit_rx_data(handle->port, data_len);
+	handle->iface.skip_len -= data_len;
+	handle->iface.bytes_processed += data_len;
+
+	if (handle->iface.skip_len == 0)
+	{
+		host_comm_rx_dbg("ev_internal \t[ skip_done ]\r\n");
+		handle->event.internal = ev_int_skip_done;
+	}
+}
+
+static bool skip_proc_on_react(host_comm_rx_fsm_t *handle, const bool try_transition)
+{
+	bool did_transition = try_transition;
+
+	if (try_transition == true)
+	{
+		if (handle->event.internal == ev_int_skip_done ||
+			time_event_is_raised(&handle->event.time.skip_timeout) == true)
+		{
+			/*Exit Action*/
+			exit_action_skip_proc(handle);
+
+			/*Enter Sequence, a truncated frame is given up and the preamble hunt goes on*/
+			enter_seq_preamble_proc(handle);
+		}
+		else
+		{
+			did_transition = false;
+		}
+	}
+	if ((did_transition) == (false))
+	{
+		/*during action*/
+		during_action_skip_proc(handle);
+	}
+	return did_transition;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 static void clear_time_events(host_comm_rx_fsm_t *handle)
@@ -446,12 +672,32 @@ static void clear_time_events(host_comm_rx_fsm_t *handle)
 	time_event_stop(&handle->event.time.crc_and_postamble_timeout);
 	time_event_stop(&handle->event.time.header_timeout);
 	time_event_stop(&handle->event.time.payload_timeout);
+	time_event_stop(&handle->event.time.skip_timeout);
 }
 
-void host_comm_rx_fsm_init(host_comm_rx_fsm_t *handle)
+void host_comm_rx_fsm_init(host_comm_rx_fsm_t *handle, uart_port_t *port, host_comm_tx_fsm_t *tx, uint8_t node_addr)
 {
 	/*Init Interface*/
-	memset((uint8_t *)&handle->iface.packet, 0, sizeof(packet_data_t));
+	handle->port = port;
+	handle->tx = tx;
+	handle->node_addr = node_addr;
+	handle->iface.parse_offset = 0;
+	handle->iface.bytes_processed = 0;
+	handle->iface.packet_cnt = 0;
+
+	/*Every packet of the pool is free*/
+	host_comm_rx_packet_queue_init(&handle->free);
+	host_comm_rx_packet_queue_init(&handle->ready);
+
+	for (size_t pkt_idx = 0; pkt_idx < HOST_COMM_RX_PACKET_POOL_SIZE; pkt_idx++)
+	{
+		host_comm_rx_packet_t *packet = &handle->pool[pkt_idx];
+
+		memset((uint8_t *)packet, 0, sizeof(host_comm_rx_packet_t));
+		host_comm_rx_packet_queue_push(&handle->free, &packet);
+	}
+
+	rx_take_slot(handle);
 
 	/*Clear events*/
 	clear_time_events(handle);
@@ -486,12 +732,71 @@ void host_comm_rx_fsm_run(host_comm_rx_fsm_t *handle)
 	case st_comm_rx_payload_proc:           payload_proc_on_react(handle, true);           break;
 	case st_comm_rx_crc_and_postamble_proc: crc_and_postamble_proc_on_react(handle, true); break;
 	case st_comm_rx_packet_ready:           packet_ready_on_react(handle, true);           break;
+	case st_comm_rx_skip_proc:              skip_proc_on_react(handle, true);              break;
 
 	default:
 		break;
 	}
 }
 
+/**
+ * @brief React until no further progress is possible or the byte budget is spent
+ * 
+ * @param handle rx fsm handle
+ * @param budget bytes that may still be hunted, parsed or skipped, decremented by the bytes processed
+ * @return uint32_t number of packets completed, see host_comm_rx_fsm_get_packet()
+ * @note  host_comm_rx_fsm_run() performs a single reaction, so a frame takes several calls. Draining
+ *        parses all the frames already received in one call, the budget bounds the time spent
+ *        when the host keeps sending. It stops when every packet of the pool waits for the consumer.
+ */
+uint32_t host_comm_rx_fsm_drain(host_comm_rx_fsm_t *handle, size_t *budget)
+{
+	uint32_t packet_cnt = handle->iface.packet_cnt;
+
+	while (*budget > 0)
+	{
+		host_comm_rx_states_t state = handle->state;
+		size_t processed = handle->iface.bytes_processed;
+
+		host_comm_rx_fsm_run(handle);
+
+		processed = handle->iface.bytes_processed - processed;
+		*budget -= (processed < *budget) ? processed : *budget;
+
+		/* No transition, no event pending and no byte processed: wait for more data or a time event */
+		if (handle->state == state && processed == 0 && handle->event.internal == ev_int_comm_rx_invalid)
+		{
+			break;
+		}
+	}
+
+	return handle->iface.packet_cnt - packet_cnt;
+}
+
+/**
+ * @brief Take the oldest packet received, the consumer owns it until it is released
+ * 
+ * @param handle rx fsm handle
+ * @return host_comm_rx_packet_t* packet received, NULL if there is none
+ */
+host_comm_rx_packet_t *host_comm_rx_fsm_get_packet(host_comm_rx_fsm_t *handle)
+{
+	host_comm_rx_packet_t *packet;
+
+	return host_comm_rx_packet_queue_pop(&handle->ready, &packet) ? packet : NULL;
+}
+
+/**
+ * @brief Give a packet taken with host_comm_rx_fsm_get_packet() back to the rx fsm
+ * 
+ * @param handle rx fsm handle
+ * @param packet packet processed, it must not be used afterwards
+ */
+void host_comm_rx_fsm_release_packet(host_comm_rx_fsm_t *handle, host_comm_rx_packet_t *packet)
+{
+	host_comm_rx_packet_queue_push(&handle->free, &packet);
+}
+
 bool host_comm_rx_fsm_is_state_active(const host_comm_rx_fsm_t *handle, host_comm_rx_states_t state)
 {
 	bool result = (handle->state == state) ? true : false;
@@ -12,12 +12,14 @@
 #include "host_comm_tx_fsm.h"
 #include "string.h"
 
-/*@brief Tx comm finite state machine object */
-host_comm_tx_fsm_t host_comm_tx_handle;
+/* A frame is written to the uart bip buffer as a single block, only about half of it is granted */
+_Static_assert(MAX_FRAME_SIZE <= (TX_DATA_BUFF_SIZE / 2), "uart tx buffer too small for MAX_PAYLOAD_SIZE");
 
 
 /**@brief Enable/Disable debug messages */
+#ifndef HOST_TX_FSM_DEBUG
 #define HOST_TX_FSM_DEBUG 1
+#endif
 #define HOST_TX_FSM_TAG "host tx comm: "
 
 /**@brief uart debug function for server comm operations  */
@@ -60,10 +62,13 @@ static void host_comm_tx_fsm_set_next_state(host_comm_tx_fsm_t *handle, host_com
     clear_events(handle);
 }
 
-void host_comm_tx_fsm_init(host_comm_tx_fsm_t* handle)
+void host_comm_tx_fsm_init(host_comm_tx_fsm_t* handle, uart_port_t *port, uint8_t node_addr)
 {
     /*Init interface*/
-    host_comm_tx_queue_init();
+    handle->port = port;
+    handle->node_addr = node_addr;
+    handle->bus_turn = false;
+    host_comm_tx_queue_init(&handle->iface.queue);
     memset((uint8_t*)&handle->iface.request.packet, 0, sizeof(packet_data_t));
 
     /*Clear events */
@@ -85,7 +90,12 @@ static void enter_seq_poll_pending_transfers(host_comm_tx_fsm_t *handle)
 
 static void during_action_poll_pending_transfers(host_comm_tx_fsm_t *handle)
 {
-    if(host_comm_tx_queue_get_pending_transfers())
+    if(!host_comm_tx_queue_get_pending_transfers(&handle->iface.queue))
+    {
+        /* Everything queued was sent, the node gives the bus back */
+        handle->bus_turn = false;
+    }
+    else if(handle->node_addr == PROTOCOL_ADDR_P2P || handle->bus_turn)
     {
         handle->event.internal = ev_int_comm_tx_pending_packet;
         host_comm_tx_dbg("int event \t[ pending_packet ]\n");
@@ -96,7 +106,7 @@ static void during_action_poll_pending_transfers(host_comm_tx_fsm_t *handle)
 static void exit_action_poll_pending_transfers(host_comm_tx_fsm_t *handle)
 {
     /*Read packet to transfer */
-    host_comm_tx_queue_read_request(&handle->iface.request);
+    host_comm_tx_queue_read_request(&handle->iface.queue, &handle->iface.request);
 }
 
 
@@ -137,7 +147,9 @@ static void entry_action_transmit_packet(host_comm_tx_fsm_t *handle)
 {
     if(handle->iface.request.ack_expected == true)
     {
-        time_event_start(&handle->event.time.ack_timeout, MAX_ACK_TIMEOUT_MS);
+        /* Wait for the packet to go out and its ACK to come back at the current baudrate */
+        size_t exchange_len = 2 * FRAME_OVERHEAD_BYTES + handle->iface.request.packet.header.payload_len;
+        time_event_start(&handle->event.time.ack_timeout, MAX_ACK_TIMEOUT_MS + uart_bytes_to_ms(handle->port, exchange_len));
         host_comm_tx_dbg("time event \t[ ack resp time start ]\n");
     }
     else
@@ -202,61 +214,37 @@ static bool transmit_packet_on_react(host_comm_tx_fsm_t *handle, const bool try_
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void crc32_accumulate(uint32_t *buff, size_t len, uint32_t *crc_value)
-{
-    int i = 0;
-    uint32_t crc = *crc_value ^ buff[i];
-    for (i = 0; i < len - 1; i++)
-        crc ^= buff[i + 1];
-
-    *crc_value = crc;
-}
-
 /**
- * @brief 
- * 
- * @param host_comm 
- * @param packet 
- * @return uint8_t 
+ * @brief Build a frame around a packet and enqueue it in the uart at once
  */
-static uint8_t tx_send_packet(host_comm_tx_fsm_t *handle)
+static uint8_t tx_write_frame(host_comm_tx_fsm_t *handle, packet_data_t *packet)
 {
    /* packet index to write bytes  */
     uint32_t crc = 0;
 
-    packet_data_t *packet = &handle->iface.request.packet;
-
-    /* Transmit preamble */
-    if (!uart_transmit_it((uint8_t *)&protocol_preamble.bit, PREAMBLE_SIZE_BYTES))
-        return 0;
+    /* On a bus every frame carries the address of the node that sends it */
+    packet->header.addr = handle->node_addr;
 
-    /* Start CRC calculation*/
+    /* Calculate CRC over header and payload */
     crc32_accumulate((uint8_t *)&packet->header, HEADER_SIZE_BYTES, &crc);
+    crc32_accumulate(packet->payload.buffer, packet->header.payload_len, &crc);
 
-    /* Transmit Header */
-    if (!uart_transmit_it((uint8_t *)&packet->header, HEADER_SIZE_BYTES))
-        return 0;
-
-    /* If Payload  */
-    if (packet->header.payload_len)
+    /* Enqueue the whole frame at once, either every field is transmitted or none */
+    circular_buff_segment_t frame[] =
     {
-        /*update CRC*/
-        crc32_accumulate((uint8_t *)&packet->payload, packet->header.payload_len, &crc);
-
-        /*Transmit payload*/
-        if (!uart_transmit_it((uint8_t *)&packet->payload, packet->header.payload_len))
-            return 0;
-    }
-
-    /*Transmit CRC*/
-    if (!uart_transmit_it((uint8_t *)&crc, CRC_SIZE_BYTES))
-        return 0;
+        {.data = protocol_preamble.bit,          .len = PREAMBLE_SIZE_BYTES},
+        {.data = (uint8_t *)&packet->header,     .len = HEADER_SIZE_BYTES},
+        {.data = packet->payload.buffer,         .len = packet->header.payload_len},
+        {.data = (uint8_t *)&crc,                .len = CRC_SIZE_BYTES},
+        {.data = protocol_postamble.bit,         .len = POSTAMBLE_SIZE_BYTES},
+    };
 
-    /*Transmit Postamble*/
-    if (!uart_transmit_it((uint8_t *)&protocol_postamble.bit, POSTAMBLE_SIZE_BYTES))
-        return 0;
+    return uart_transmit_itv(handle->port, frame, sizeof(frame) / sizeof(frame[0]));
+}
 
-    return 1;
+static uint8_t tx_send_packet(host_comm_tx_fsm_t *handle)
+{
+    return tx_write_frame(handle, &handle->iface.request.packet);
 }
 
 
@@ -266,23 +254,24 @@ uint8_t host_comm_tx_fsm_write_dbg_msg(host_comm_tx_fsm_t *handle, char *dbg_msg
 	/* Check frame identifier */
 	if (dbg_msg != NULL)
 	{
-		/*form header*/
-		tx_request_t request;
-        request.ack_expected = ack_expected;
-        request.src = TX_SRC_FW_USER;
-		request.packet.header.dir = TARGET_TO_HOST_DIR;
-		request.packet.header.type.evt = TARGET_TO_HOST_EVT_PRINT_DBG_MSG;
-		request.packet.header.payload_len = strlen(dbg_msg);
-
-		/*copy dbg message to payload*/
-        if((request.packet.header.payload_len > 0) && (request.packet.header.payload_len < MAX_PAYLOAD_SIZE))
-		    memcpy((uint8_t*)&request.packet.payload, dbg_msg, request.packet.header.payload_len);
-        else
+		size_t msg_len = strlen(dbg_msg);
+
+        if ((msg_len == 0) || (msg_len > MAX_PAYLOAD_SIZE))
             return 0;
 
-		/*Write Data*/
-        //print_buff_hex((uint8_t*)&request.packet, HEADER_SIZE_BYTES + request.packet.header.payload_len);
-        return host_comm_tx_queue_write_request(&request);
+		/*form header, the message is copied straight from the caller into the queue*/
+		packet_header_t header =
+        {
+		    .dir = TARGET_TO_HOST_DIR,
+		    .type.evt = TARGET_TO_HOST_EVT_PRINT_DBG_MSG,
+		    .payload_len = msg_len,
+        };
+
+		/*Write Data, messages without ACK are lossy and drop the oldest ones instead of failing */
+        if (ack_expected)
+            return host_comm_tx_queue_write_packet(&handle->iface.queue, TX_SRC_FW_USER, true, &header, (const uint8_t *)dbg_msg);
+        else
+            return host_comm_tx_queue_write_lossy_packet(&handle->iface.queue, &header, (const uint8_t *)dbg_msg);
 	}
 
 	return 0;
@@ -291,17 +280,84 @@ uint8_t host_comm_tx_fsm_write_dbg_msg(host_comm_tx_fsm_t *handle, char *dbg_msg
 uint8_t host_comm_tx_fsm_send_packet_no_payload(host_comm_tx_fsm_t *handle, uint8_t type, bool ack_expected)
 {
     /*form header*/
-    tx_request_t request = 
+    packet_header_t header =
     {
-        .ack_expected = ack_expected,
-        .src = TX_SRC_RX_FSM,
-        .packet.header.dir = TARGET_TO_HOST_DIR,
-        .packet.header.type.res = type,
-        .packet.header.payload_len = 0,
+        .dir = TARGET_TO_HOST_DIR,
+        .type.res = type,
+        .payload_len = 0,
     };
 
     /*Write Data*/
-    return host_comm_tx_queue_write_request(&request);
+    return host_comm_tx_queue_write_packet(&handle->iface.queue, TX_SRC_RX_FSM, ack_expected, &header, NULL);
+}
+
+/**
+ * @brief Queue a packet with payload
+ * 
+ * @param handle tx fsm handle
+ * @param type response/event type of the packet
+ * @param payload payload data, copied into the tx queue
+ * @param len payload length
+ * @param ack_expected ACK response expected ?
+ * @return uint8_t return 1 if the packet was queued
+ */
+uint8_t host_comm_tx_fsm_send_packet(host_comm_tx_fsm_t *handle, uint8_t type, const uint8_t *payload, uint16_t len, bool ack_expected)
+{
+    if (len > MAX_PAYLOAD_SIZE)
+        return 0;
+
+    /*form header*/
+    packet_header_t header =
+    {
+        .dir = TARGET_TO_HOST_DIR,
+        .type.res = type,
+        .payload_len = len,
+    };
+
+    /*Write Data, the payload is copied straight into the queue*/
+    return host_comm_tx_queue_write_packet(&handle->iface.queue, TX_SRC_RX_FSM, ack_expected, &header, payload);
+}
+
+/**
+ * @brief Check if the tx fsm has nothing left to transmit (no request pending and line idle)
+ */
+bool host_comm_tx_fsm_is_idle(host_comm_tx_fsm_t *handle)
+{
+    return (handle->state == st_comm_tx_poll_pending_transfer) &&
+           (host_comm_tx_queue_get_pending_transfers(&handle->iface.queue) == 0) &&
+           uart_is_tx_idle(handle->port);
+}
+
+/**
+ * @brief Transmit an event without payload ahead of the requests queued, no ack expected
+ * 
+ * @param handle tx fsm handle
+ * @param type event type
+ * @return uint8_t return 1 if the frame was enqueued in the uart, 0 otherwise
+ * @note   Used for link control (e.g. flow control), it must not wait behind packets waiting for an ack.
+ */
+uint8_t host_comm_tx_fsm_send_event_now(host_comm_tx_fsm_t *handle, uint8_t type)
+{
+    packet_data_t packet =
+    {
+        .header.dir = TARGET_TO_HOST_DIR,
+        .header.type.evt = type,
+        .header.payload_len = 0,
+    };
+
+    return tx_write_frame(handle, &packet);
+}
+
+/**
+ * @brief Give the bus to the node, the packets queued are sent until the queue is empty
+ * 
+ * @param handle tx fsm handle
+ * @note   On a bus a node only transmits when the host addresses it, packets queued meanwhile
+ *         (e.g. answers to broadcast frames) wait for its next turn. No effect on a point to point link.
+ */
+void host_comm_tx_fsm_grant_bus_turn(host_comm_tx_fsm_t *handle)
+{
+    handle->bus_turn = true;
 }
 
 void host_comm_tx_fsm_time_event_update(host_comm_tx_fsm_t *handle)
@@ -11,7 +11,9 @@
 #include "host_comm_tx_queue.h"
 
 /*Enable/Disable Debug messages*/
+#ifndef HOST_COMM_TX_DEBUG
 #define HOST_COMM_TX_DEBUG 1
+#endif
 #define HOST_COMM_TX_TAG "tx queue: "
 
 /**@brief uart debug function for Tx comm operations  */
@@ -25,61 +27,141 @@
 #endif
 
 
-typedef struct
-{ 
-    size_t packet_cnt;                   /*!< counter that stores the number of pending transmission packets in the Tx queue*/       
-    c_buff_handle_t  cb;                 /*!< circular buffer that stores the packet data yo be transmit  */
-    uint8_t buffer[TX_QUEUE_BUFF_SIZE];  /*!< buffer to store the data to be transmitted */     
-}host_comm_tx_queue_t;
-
-static host_comm_tx_queue_t tx_queue;
-
+void host_comm_tx_queue_init(host_comm_tx_queue_t *tx_queue)
+{
+    tx_desc_queue_init(&tx_queue->desc);
+    tx_queue->cb = circular_buff_init_static(&tx_queue->ctrl, tx_queue->buffer, TX_QUEUE_BUFF_SIZE);
+    tx_queue->lossy_cb = circular_buff_init_static(&tx_queue->lossy_ctrl, tx_queue->lossy_buffer, TX_QUEUE_LOSSY_BUFF_SIZE);
+}
 
-void host_comm_tx_queue_init(void)
+/**
+ * @brief Get the number of pending transmission requests
+ * @note  Lossy requests are counted as a single pending transfer until all of them are read.
+ */
+size_t host_comm_tx_queue_get_pending_transfers(host_comm_tx_queue_t *tx_queue)
 {
-    tx_queue.cb = circular_buff_init(tx_queue.buffer, TX_QUEUE_BUFF_SIZE);
-    tx_queue.packet_cnt = 0;
+    return tx_desc_queue_count(&tx_queue->desc) + (circular_buff_empty(tx_queue->lossy_cb) ? 0 : 1);
 }
 
-size_t host_comm_tx_queue_get_pending_transfers(void)
+uint8_t host_comm_tx_queue_write_request(host_comm_tx_queue_t *tx_queue, tx_request_t *tx_request)
 {
-    return tx_queue.packet_cnt;
+    return host_comm_tx_queue_write_packet(tx_queue, tx_request->src, tx_request->ack_expected,
+                                           &tx_request->packet.header, tx_request->packet.payload.buffer);
 }
 
-uint8_t host_comm_tx_queue_write_request(tx_request_t *tx_request)
+/**
+ * @brief Write a transmission request from a header and a payload held by the caller
+ * 
+ * @param tx_queue     transmission queue of the port
+ * @param src          process that requests the transmission
+ * @param ack_expected ACK response expected ?
+ * @param header       packet header, header->payload_len bytes are copied from payload
+ * @param payload      payload data, may be NULL when header->payload_len is 0
+ * @return uint8_t return 1 if the request was queued, return 0 if there is no room for it
+ * @note  The payload is copied straight into the queue, so large payloads never need a
+ *        packet_data_t on the caller stack.
+ */
+uint8_t host_comm_tx_queue_write_packet(host_comm_tx_queue_t *tx_queue, tx_request_source_t src, bool ack_expected,
+                                        const packet_header_t *header, const uint8_t *payload)
 {
-    /* Temporal variable to check free space needed to write packet in tx queue */
-    uint8_t packet_data_len = HEADER_SIZE_BYTES + tx_request->packet.header.payload_len;
+    tx_request_desc_t desc =
+    {
+        .src          = src,
+        .ack_expected = ack_expected,
+        .header       = *header,
+    };
 
-    if (circular_buff_get_free_space(tx_queue.cb) > packet_data_len + 1) //include byte for req src 
+    circular_buff_segment_t segment =
     {
-        circular_buff_put(tx_queue.cb, (uint8_t)tx_request->src);
-        circular_buff_put(tx_queue.cb, (uint8_t)tx_request->ack_expected);
-        circular_buff_write(tx_queue.cb, (uint8_t *)&tx_request->packet, packet_data_len);
-        tx_queue.packet_cnt++;
+        .data = (uint8_t *)payload,
+        .len  = header->payload_len,
+    };
 
-        hdx_comm_dbg_message("pending packet counter [%d]\r\n", tx_queue.packet_cnt);
-        hdx_comm_dbg_message("free space in queue [%d] bytes\r\n", circular_buff_get_free_space(tx_queue.cb));
+    if (header->payload_len > MAX_PAYLOAD_SIZE)
+    {
+        return 0;
+    }
 
-        return 1;
+    if (tx_desc_queue_full(&tx_queue->desc))
+    {
+        hdx_comm_dbg_message("not enough request slots in tx queue ");
+        return 0;
     }
-    else
+
+    /* payload goes first so the descriptor is only visible once its data is complete */
+    if ((segment.len > 0) && (circular_buff_writev(tx_queue->cb, &segment, 1) != CIRCULAR_BUFF_OK))
     {
         hdx_comm_dbg_message("not enough space in tx queue ");
         return 0;
     }
+
+    tx_desc_queue_push(&tx_queue->desc, &desc);
+
+    hdx_comm_dbg_message("pending packet counter [%u]\r\n", (unsigned)tx_desc_queue_count(&tx_queue->desc));
+    hdx_comm_dbg_message("free space in queue [%u] bytes\r\n", (unsigned)circular_buff_get_free_space(tx_queue->cb));
+
+    return 1;
 }
 
+/**
+ * @brief Write a transmission request that may be dropped later if the queue runs out of space
+ * 
+ * @param tx_queue   transmission queue of the port
+ * @param tx_request request to be queued, ack_expected is ignored since lossy requests are never acknowledged
+ * @return uint8_t return 1 if the request was queued, return 0 if it is larger than the lossy buffer.
+ * @note  The oldest whole lossy requests are overwritten to make room, so the caller never waits
+ *        for the transmitter. Dropped requests are reported by host_comm_tx_queue_get_lossy_stats().
+ */
+uint8_t host_comm_tx_queue_write_lossy_request(host_comm_tx_queue_t *tx_queue, tx_request_t *tx_request)
+{
+    return host_comm_tx_queue_write_lossy_packet(tx_queue, &tx_request->packet.header, tx_request->packet.payload.buffer);
+}
 
-uint8_t host_comm_tx_queue_read_request(tx_request_t *tx_request)
+/**
+ * @brief Write a lossy transmission request from a header and a payload held by the caller
+ * 
+ * @param tx_queue transmission queue of the port
+ * @param header   packet header, header->payload_len bytes are copied from payload
+ * @param payload  payload data, may be NULL when header->payload_len is 0
+ * @return uint8_t return 1 if the request was queued, return 0 if it is larger than the lossy buffer.
+ */
+uint8_t host_comm_tx_queue_write_lossy_packet(host_comm_tx_queue_t *tx_queue, const packet_header_t *header, const uint8_t *payload)
 {
-    if (tx_queue.packet_cnt > 0)
+    circular_buff_segment_t record[] =
     {
-        circular_buff_get(tx_queue.cb, (uint8_t *)&tx_request->src);
-        circular_buff_get(tx_queue.cb, (uint8_t *)&tx_request->ack_expected);
-        circular_buff_read(tx_queue.cb, (uint8_t *)&tx_request->packet.header, HEADER_SIZE_BYTES);
-        circular_buff_read(tx_queue.cb, (uint8_t *)&tx_request->packet.payload, tx_request->packet.header.payload_len);
-        tx_queue.packet_cnt--;
+        {.data = (uint8_t *)header,   .len = sizeof(packet_header_t)},
+        {.data = (uint8_t *)payload,  .len = header->payload_len},
+    };
+
+    if (header->payload_len > MAX_PAYLOAD_SIZE)
+    {
+        return 0;
+    }
+
+    return (circular_buff_overwrite_record(tx_queue->lossy_cb, record, sizeof(record) / sizeof(record[0])) == CIRCULAR_BUFF_OK);
+}
+
+/**
+ * @brief Read the next transmission request, requests with a descriptor go before lossy requests
+ */
+uint8_t host_comm_tx_queue_read_request(host_comm_tx_queue_t *tx_queue, tx_request_t *tx_request)
+{
+    tx_request_desc_t desc;
+    size_t record_len;
+
+    if (tx_desc_queue_pop(&tx_queue->desc, &desc))
+    {
+        tx_request->src = desc.src;
+        tx_request->ack_expected = desc.ack_expected;
+        tx_request->packet.header = desc.header;
+        circular_buff_read(tx_queue->cb, tx_request->packet.payload.buffer, desc.header.payload_len);
+
+        return 1;
+    }
+    else if (circular_buff_read_record(tx_queue->lossy_cb, (uint8_t *)&tx_request->packet, sizeof(packet_data_t), &record_len))
+    {
+        tx_request->src = TX_SRC_FW_USER;
+        tx_request->ack_expected = false;
 
         return 1;
     }
@@ -90,15 +172,40 @@ uint8_t host_comm_tx_queue_read_request(tx_request_t *tx_request)
     }
 }
 
-uint8_t host_comm_tx_queue_fetch_request(tx_request_t *tx_request)
+uint8_t host_comm_tx_queue_fetch_request(host_comm_tx_queue_t *tx_queue, tx_request_t *tx_request)
 {
-    if (tx_queue.packet_cnt > 0)
+    tx_request_desc_t *desc = tx_desc_queue_peek(&tx_queue->desc);
+    size_t record_len;
+
+    if (desc != NULL)
     {
-        circular_buff_fetch(tx_queue.cb, (uint8_t *)&tx_request->src, 1);
-        circular_buff_fetch(tx_queue.cb, (uint8_t *)&tx_request->ack_expected, 1);
-        circular_buff_fetch(tx_queue.cb, (uint8_t *)&tx_request->packet.header, HEADER_SIZE_BYTES);
-        circular_buff_fetch(tx_queue.cb, (uint8_t *)&tx_request->packet.payload, tx_request->packet.header.payload_len);
+        tx_request->src = desc->src;
+        tx_request->ack_expected = desc->ack_expected;
+        tx_request->packet.header = desc->header;
+        circular_buff_fetch(tx_queue->cb, tx_request->packet.payload.buffer, desc->header.payload_len);
+        return 1;
+    }
+    else if (circular_buff_fetch_record(tx_queue->lossy_cb, (uint8_t *)&tx_request->packet, sizeof(packet_data_t), &record_len))
+    {
+        tx_request->src = TX_SRC_FW_USER;
+        tx_request->ack_expected = false;
         return 1;
     }
     return 0;
 }
+
+void host_comm_tx_queue_get_stats(host_comm_tx_queue_t *tx_queue, circular_buff_stats_t *stats)
+{
+    circular_buff_get_stats(tx_queue->cb, stats);
+}
+
+void host_comm_tx_queue_get_lossy_stats(host_comm_tx_queue_t *tx_queue, circular_buff_stats_t *stats)
+{
+    circular_buff_get_stats(tx_queue->lossy_cb, stats);
+}
+
+void host_comm_tx_queue_reset_stats(host_comm_tx_queue_t *tx_queue)
+{
+    circular_buff_reset_stats(tx_queue->cb);
+    circular_buff_reset_stats(tx_queue->lossy_cb);
+}
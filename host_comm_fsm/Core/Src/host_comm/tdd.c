@@ -16,13 +16,13 @@ void rx_comm_test_0(void)
     printf(" ********************************** \r\n");
 
     /* Print packet size */
-    uint16_t frame_size_1 = PREAMBLE_SIZE_BYTES + HEADER_SIZE_BYTES +
-                            MAX_PAYLOAD_SIZE + CRC_SIZE_BYTES + POSTAMBLE_SIZE_BYTES;
+    size_t frame_size_1 = PREAMBLE_SIZE_BYTES + HEADER_SIZE_BYTES +
+                          MAX_PAYLOAD_SIZE + CRC_SIZE_BYTES + POSTAMBLE_SIZE_BYTES;
 
-    uint16_t frame_size_2 = PREAMBLE_SIZE_BYTES + sizeof(packet_data_t) + CRC_SIZE_BYTES + POSTAMBLE_SIZE_BYTES;
+    size_t frame_size_2 = PREAMBLE_SIZE_BYTES + sizeof(packet_data_t) + CRC_SIZE_BYTES + POSTAMBLE_SIZE_BYTES;
 
-    printf("packet frame size [sum of its components ] -> [%d]\r\n", frame_size_1);
-    printf("packet frame size [struct ] -> [%d]\r\n", frame_size_2);
+    printf("packet frame size [sum of its components ] -> [%u]\r\n", (unsigned)frame_size_1);
+    printf("packet frame size [struct ] -> [%u]\r\n", (unsigned)frame_size_2);
 
     /*Simulate packet struct in host*/
     uint32_t preamble_src = PREAMBLE;
@@ -38,8 +38,8 @@ void rx_comm_test_0(void)
         };
 
     /*create temporal buffer and store packet */
-    uint8_t frame[100];
-    uint8_t frame_idx = 0;
+    uint8_t frame[MAX_FRAME_SIZE];
+    size_t frame_idx = 0;
     memcpy(frame, (uint8_t *)&preamble_src, PREAMBLE_SIZE_BYTES);
     frame_idx = PREAMBLE_SIZE_BYTES;
     memcpy(frame + frame_idx, (uint8_t *)&host_cmd.header, HEADER_SIZE_BYTES);
@@ -51,7 +51,7 @@ void rx_comm_test_0(void)
     memcpy(frame + frame_idx, (uint8_t *)&postamble_src, POSTAMBLE_SIZE_BYTES);
     frame_idx += POSTAMBLE_SIZE_BYTES;
 
-    printf("frame : len [%d]\t ", frame_idx);
+    printf("frame : len [%u]\t ", (unsigned)frame_idx);
     print_buff_hex(frame, frame_idx);
 
     uint16_t host_cmd_size = PREAMBLE_SIZE_BYTES + HEADER_SIZE_BYTES +
@@ -118,34 +118,134 @@ void rx_comm_test_1(void)
      */
 
 
-   uint8_t buff3[] = {0x55, 0xAA, 0x55, 0xAA, 0x03, TARGET_TO_HOST_DIR, 0x05, 0x00, 0x64, 0x65, 0x6D,
-                     0x6F, 0x30, 0x57, 0xDE, 0x68, 0x6F, 0x55, 0xBB, 0x55, 0xBB};
-   uart_write_rx_data(buff3, 21); /*<! Header error expected */
+   /* Header : type, dir, payload len (LE), addr, reserved. CRC-32 (IEEE) of header and payload, little endian */
+   uint8_t buff3[] = {0x55, 0xAA, 0x55, 0xAA, 0x03, TARGET_TO_HOST_DIR, 0x05, 0x00, 0x00, 0x00, 0x64, 0x65,
+                     0x6D, 0x6F, 0x30, 0xB1, 0xC1, 0x71, 0xE2, 0x55, 0xBB, 0x55, 0xBB};
+   uart_write_rx_data(uart_get_port(UART_HOST_PORT), buff3, sizeof(buff3)); /*<! Header error expected */
 
-   uint8_t buff1[] = {0x55, 0xAA, 0x55, 0xAA, 0x03, HOST_TO_TARGET_DIR, 0x05, 0x00, 0x64, 0x65, 0x6D,
-                     0x6F, 0x30, 0xDD, 0xCC, 0xBB, 0xAA, 0x55, 0xBB, 0x55, 0xBB};
+   uint8_t buff1[] = {0x55, 0xAA, 0x55, 0xAA, 0x03, HOST_TO_TARGET_DIR, 0x05, 0x00, 0x00, 0x00, 0x64, 0x65,
+                     0x6D, 0x6F, 0x30, 0xDD, 0xCC, 0xBB, 0xAA, 0x55, 0xBB, 0x55, 0xBB};
 
-   uart_write_rx_data(buff1, 21); /*<! CRC error expected */
+   uart_write_rx_data(uart_get_port(UART_HOST_PORT), buff1, sizeof(buff1)); /*<! CRC error expected */
 
-  uint8_t buff2[] = {0x55, 0xAA, 0x55, 0xAA, 0x03, HOST_TO_TARGET_DIR, 0x05, 0x00, 0x64, 0x65, 0x6D,
-                    0x6F, 0x30, 0x57, 0xDE, 0x68, 0x6F, 0x55, 0xBB, 0x55, 0xBB};
+  uint8_t buff2[] = {0x55, 0xAA, 0x55, 0xAA, 0x03, HOST_TO_TARGET_DIR, 0x05, 0x00, 0x00, 0x00, 0x64, 0x65,
+                    0x6D, 0x6F, 0x30, 0x67, 0x2B, 0x1D, 0x2A, 0x55, 0xBB, 0x55, 0xBB};
 
-  uart_write_rx_data(buff2, 21); /*<! Packet ready expected */
+  uart_write_rx_data(uart_get_port(UART_HOST_PORT), buff2, sizeof(buff2)); /*<! Packet ready expected */
 
   
-  uint8_t buff4[] = {0x32, 0xAA, 0x12, 0x54, 0x23, 0xFF, 0x01, 0x30, 0x64, 0x65, 0x6D,
-                    0x6F, 0x30, 0x57, 0xDE, 0x15, 0x6F, 0x55, 0x20, 0x55, 0xBB};
+  uint8_t buff4[] = {0x32, 0xAA, 0x12, 0x54, 0x23, 0xFF, 0x01, 0x30, 0x00, 0x00, 0x64, 0x65,
+                    0x6D, 0x6F, 0x30, 0x57, 0xDE, 0x15, 0x6F, 0x55, 0x20, 0x55, 0xBB};
 
-  uart_write_rx_data(buff4, 21); /*<! Noise, Nothing expected*/
+  uart_write_rx_data(uart_get_port(UART_HOST_PORT), buff4, sizeof(buff4)); /*<! Noise, Nothing expected*/
 
 }
 
 void tx_comm_test_0(void)
 {
     /*Send Debug message with ACK response expected */
-    host_comm_tx_fsm_write_dbg_msg(&host_comm_tx_handle, "This is a debug message #1, ACK expected\r\n", true);
+    host_comm_tx_fsm_write_dbg_msg(&host_comm_port_get(UART_HOST_PORT)->tx, "This is a debug message #1, ACK expected\r\n", true);
 
     /*Send Debug message with no ACK response expected */
-    host_comm_tx_fsm_write_dbg_msg(&host_comm_tx_handle, "This is a debug message #2, no ACK expected\r\n", false);
+    host_comm_tx_fsm_write_dbg_msg(&host_comm_port_get(UART_HOST_PORT)->tx, "This is a debug message #2, no ACK expected\r\n", false);
 
 }
+
+/**
+ * @brief Feed a frame to the parser in chunks, return the verdict
+ * @note  The last postamble byte is fed alone, its cycles are the end of frame to verdict latency.
+ */
+static frame_parser_result_t bench_parse_frame(frame_parser_t *parser, const uint8_t *frame, size_t frame_len,
+                                               size_t chunk_len, uint32_t *verdict_cycles)
+{
+    frame_parser_result_t result = FRAME_PARSER_MORE;
+    size_t idx = PREAMBLE_SIZE_BYTES;
+    size_t consumed;
+
+    frame_parser_start(parser);
+
+    while (idx < frame_len - 1)
+    {
+        size_t len = frame_len - 1 - idx;
+
+        len = (len < chunk_len) ? len : chunk_len;
+        result = frame_parser_feed(parser, &frame[idx], len, &consumed);
+        idx += consumed;
+
+        if (result != FRAME_PARSER_MORE && result != FRAME_PARSER_HEADER_DONE && result != FRAME_PARSER_PAYLOAD_DONE)
+        {
+            return result;
+        }
+    }
+
+    uint32_t start = timestamp_now();
+    result = frame_parser_feed(parser, &frame[idx], 1, &consumed);
+    *verdict_cycles = timestamp_elapsed(start);
+
+    return result;
+}
+
+void rx_comm_bench_0(void)
+{
+    /*
+    * Throughput of the streaming frame parser and latency from the last postamble byte to the verdict
+    */
+    static packet_data_t packet;
+    static uint8_t frame[MAX_FRAME_SIZE];
+    const size_t chunk_lens[] = {1, 16, 64, MAX_FRAME_SIZE};
+    const uint32_t frame_cnt = 100;
+    frame_parser_t parser;
+    size_t frame_len = 0;
+    uint32_t crc = 0;
+
+    packet_header_t header =
+    {
+        .type.cmd = HOST_TO_TARGET_CMD_GET_FW_VERSION,
+        .addr = PROTOCOL_ADDR_P2P,
+        .dir = HOST_TO_TARGET_DIR,
+        .payload_len = MAX_PAYLOAD_SIZE,
+    };
+
+    /* Max size frame, built as the host does */
+    memcpy(&frame[frame_len], protocol_preamble.bit, PREAMBLE_SIZE_BYTES);
+    frame_len += PREAMBLE_SIZE_BYTES;
+    memcpy(&frame[frame_len], (uint8_t *)&header, HEADER_SIZE_BYTES);
+    frame_len += HEADER_SIZE_BYTES;
+    for (size_t i = 0; i < MAX_PAYLOAD_SIZE; i++)
+    {
+        frame[frame_len++] = (uint8_t)i;
+    }
+    crc32_accumulate(&frame[PREAMBLE_SIZE_BYTES], HEADER_SIZE_BYTES + MAX_PAYLOAD_SIZE, &crc);
+    memcpy(&frame[frame_len], (uint8_t *)&crc, CRC_SIZE_BYTES);
+    frame_len += CRC_SIZE_BYTES;
+    memcpy(&frame[frame_len], protocol_postamble.bit, POSTAMBLE_SIZE_BYTES);
+    frame_len += POSTAMBLE_SIZE_BYTES;
+
+    frame_parser_init(&parser, &packet);
+
+    printf("TDD Bench #0 -> [frame parser, %u bytes frame]\r\n", (unsigned)frame_len);
+
+    for (size_t chunk_idx = 0; chunk_idx < sizeof(chunk_lens) / sizeof(chunk_lens[0]); chunk_idx++)
+    {
+        frame_parser_result_t result = FRAME_PARSER_MORE;
+        uint32_t verdict_cycles = 0;
+        uint32_t verdict_max = 0;
+
+        uint32_t start = timestamp_now();
+
+        for (uint32_t frame_idx = 0; frame_idx < frame_cnt; frame_idx++)
+        {
+            result = bench_parse_frame(&parser, frame, frame_len, chunk_lens[chunk_idx], &verdict_cycles);
+            verdict_max = (verdict_cycles > verdict_max) ? verdict_cycles : verdict_max;
+        }
+
+        uint32_t cycles = timestamp_elapsed(start);
+        uint32_t ns_per_byte = (uint32_t)(((uint64_t)cycles * 1000000000U) / SystemCoreClock / (frame_cnt * (frame_len - PREAMBLE_SIZE_BYTES)));
+        uint32_t verdict_ns = (uint32_t)(((uint64_t)verdict_max * 1000000000U) / SystemCoreClock);
+
+        printf(" **** chunk [%4u] : %s, %u ns/byte, verdict latency %u ns (%u cycles)\r\n", (unsigned)chunk_lens[chunk_idx],
+               (result == FRAME_PARSER_FRAME_OK) ? "ok" : "error", (unsigned)ns_per_byte, (unsigned)verdict_ns,
+               (unsigned)verdict_max);
+    }
+}
+
@@ -7,15 +7,19 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 #include "peripherals_init.h"
-#include "host_comm_tx_fsm.h"
-#include "host_comm_rx_fsm.h"
+#include "host_comm_port.h"
 #include "stdio.h"
 #include "tdd.h"
 
 #include "uart_driver.h"
 
 #define HEARTBEAT_PERIOD_MS (200)
+#define FW_VERSION          "0.1.0"
 void heartbeat_handler(void);
+void app_cmd_register(void);
+
+/*@brief The host took over the LED with a LED command, the heartbeat stops */
+static bool led_host_ctrl = false;
 
 
 void print_startup_message(void)
@@ -24,6 +28,7 @@ void print_startup_message(void)
 	printf("Brief:\t Communication Protocol FSM\r\n");
 	printf("Author:\t Bayron Cabrera \r\n");
 	printf("Board:\t Nucleo F411RE \r\n");
+	printf("Version: %s\r\n", FW_VERSION);
 	printf("Date:\t %s\r\n", __DATE__);
 	printf("**************************************\r\n");
 }
@@ -41,18 +46,22 @@ int main(void)
   peripherals_init();
   print_startup_message();
 
-  /* init host tx fsm*/
-  host_comm_tx_fsm_init(&host_comm_tx_handle);
-  host_comm_rx_fsm_init(&host_comm_rx_handle);
+  /* init host rx/tx fsm of every port*/
+  host_comm_port_init();
+  app_cmd_register();
 
   /* run tdd #0*/
   tx_comm_test_0();
 
+#if TDD_BENCH_ENABLE
+  /* frame parser figures on the target, the host figures come from tests/bench_frame_parser.c */
+  rx_comm_bench_0();
+#endif
+
   /* Infinite loop */
   while (1)
   {
-    host_comm_rx_fsm_run(&host_comm_rx_handle);
-    host_comm_tx_fsm_run(&host_comm_tx_handle);
+    host_comm_port_run();
     heartbeat_handler();
   }
 }
@@ -60,13 +69,45 @@ int main(void)
 void heartbeat_handler(void)
 {
   static uint32_t last_tick = 0;
-  if (HAL_GetTick() - last_tick > HEARTBEAT_PERIOD_MS)
+  if (!led_host_ctrl && HAL_GetTick() - last_tick > HEARTBEAT_PERIOD_MS)
   {
     last_tick = HAL_GetTick();
     HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin);
   }
 }
 
+/**
+  * @brief  Turn the LED on/off as the host commands, answered with the LED state
+  */
+static void app_cmd_led(host_comm_port_t *port, packet_data_t *packet)
+{
+  bool on = (packet->header.type.cmd == HOST_TO_TARGET_CMD_TURN_ON_LED);
+
+  led_host_ctrl = true;
+  HAL_GPIO_WritePin(LD2_GPIO_Port, LD2_Pin, on ? GPIO_PIN_SET : GPIO_PIN_RESET);
+  host_comm_tx_fsm_send_packet_no_payload(&port->tx, on ? TARGET_TO_HOST_RES_LED_ON : TARGET_TO_HOST_RES_LED_OFF, false);
+}
+
+/**
+  * @brief  Answer the firmware version string, without null terminator
+  */
+static void app_cmd_get_fw_version(host_comm_port_t *port, packet_data_t *packet)
+{
+  (void)packet;
+  host_comm_tx_fsm_send_packet(&port->tx, TARGET_TO_HOST_RES_FW_VERSION, (const uint8_t *)FW_VERSION,
+                               sizeof(FW_VERSION) - 1, false);
+}
+
+/**
+  * @brief  Register the application commands on every communication port
+  */
+void app_cmd_register(void)
+{
+  host_comm_port_register_cmd(HOST_TO_TARGET_CMD_TURN_ON_LED, app_cmd_led, 0, 0, HOST_COMM_CMD_FLAG_NONE);
+  host_comm_port_register_cmd(HOST_TO_TARGET_CMD_TURN_OFF_LED, app_cmd_led, 0, 0, HOST_COMM_CMD_FLAG_NONE);
+  host_comm_port_register_cmd(HOST_TO_TARGET_CMD_GET_FW_VERSION, app_cmd_get_fw_version, 0, 0, HOST_COMM_CMD_FLAG_NONE);
+}
+
 
 
 /**
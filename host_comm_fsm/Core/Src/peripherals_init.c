@@ -1,6 +1,7 @@
 #include "peripherals_init.h"
 
 #include "uart_driver.h"
+#include "timestamp.h"
 
 static void MX_GPIO_Init(void);
 extern void Error_Handler(void);
@@ -100,6 +101,9 @@ void peripherals_init(void)
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
 
+  /* Init cycle counter, received data is timestamped with it */
+  timestamp_init();
+
   /* Init Uart */
   uart_init();
 
@@ -48,11 +48,44 @@ void HAL_MspInit(void)
 * This function configures the hardware resources used in this example
 * @param huart: UART handle pointer
 * @retval None
+* @note  DMA streams are owned by uart_driver.c, they are initialized and linked there
 */
 void HAL_UART_MspInit(UART_HandleTypeDef* huart)
 {
   GPIO_InitTypeDef GPIO_InitStruct = {0};
-  if(huart->Instance==USART2)
+  if(huart->Instance==USART1)
+  {
+
+    /* Peripheral clock enable */
+    __HAL_RCC_USART1_CLK_ENABLE();
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    /**USART1 GPIO Configuration
+    PA9     ------> USART1_TX
+    PA10    ------> USART1_RX
+    */
+    GPIO_InitStruct.Pin = USART1_TX_Pin|USART1_RX_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    GPIO_InitStruct.Alternate = GPIO_AF7_USART1;
+    HAL_GPIO_Init(USART1_TX_GPIO_Port, &GPIO_InitStruct);
+
+    if(huart->Init.HwFlowCtl == UART_HWCONTROL_RTS_CTS)
+    {
+      /**USART1 flow control GPIO Configuration
+      PA11    ------> USART1_CTS
+      PA12    ------> USART1_RTS
+      */
+      GPIO_InitStruct.Pin = USART1_CTS_Pin|USART1_RTS_Pin;
+      HAL_GPIO_Init(USART1_CTS_GPIO_Port, &GPIO_InitStruct);
+    }
+
+    /* USART1 interrupt Init */
+    HAL_NVIC_SetPriority(USART1_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(USART1_IRQn);
+  }
+  else if(huart->Instance==USART2)
   {
 
     /* Peripheral clock enable */
@@ -70,10 +103,42 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
     GPIO_InitStruct.Alternate = GPIO_AF7_USART2;
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
+    if(huart->Init.HwFlowCtl == UART_HWCONTROL_RTS_CTS)
+    {
+      /**USART2 flow control GPIO Configuration
+      PA0     ------> USART2_CTS
+      PA1     ------> USART2_RTS
+      */
+      GPIO_InitStruct.Pin = USART2_CTS_Pin|USART2_RTS_Pin;
+      HAL_GPIO_Init(USART2_CTS_GPIO_Port, &GPIO_InitStruct);
+    }
+
     /* USART2 interrupt Init */
     HAL_NVIC_SetPriority(USART2_IRQn, 0, 0);
     HAL_NVIC_EnableIRQ(USART2_IRQn);
   }
+  else if(huart->Instance==USART6)
+  {
+
+    /* Peripheral clock enable */
+    __HAL_RCC_USART6_CLK_ENABLE();
+
+    __HAL_RCC_GPIOC_CLK_ENABLE();
+    /**USART6 GPIO Configuration
+    PC6     ------> USART6_TX
+    PC7     ------> USART6_RX
+    */
+    GPIO_InitStruct.Pin = USART6_TX_Pin|USART6_RX_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    GPIO_InitStruct.Alternate = GPIO_AF8_USART6;
+    HAL_GPIO_Init(USART6_TX_GPIO_Port, &GPIO_InitStruct);
+
+    /* USART6 interrupt Init */
+    HAL_NVIC_SetPriority(USART6_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(USART6_IRQn);
+  }
 }
 
 /**
@@ -84,7 +149,26 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
 */
 void HAL_UART_MspDeInit(UART_HandleTypeDef* huart)
 {
-  if(huart->Instance==USART2)
+  if(huart->Instance==USART1)
+  {
+    /* Peripheral clock disable */
+    __HAL_RCC_USART1_CLK_DISABLE();
+
+    /**USART1 GPIO Configuration
+    PA9     ------> USART1_TX
+    PA10    ------> USART1_RX
+    */
+    HAL_GPIO_DeInit(USART1_TX_GPIO_Port, USART1_TX_Pin|USART1_RX_Pin);
+
+    if(huart->Init.HwFlowCtl == UART_HWCONTROL_RTS_CTS)
+    {
+      HAL_GPIO_DeInit(USART1_CTS_GPIO_Port, USART1_CTS_Pin|USART1_RTS_Pin);
+    }
+
+    /* USART1 interrupt DeInit */
+    HAL_NVIC_DisableIRQ(USART1_IRQn);
+  }
+  else if(huart->Instance==USART2)
   {
     /* Peripheral clock disable */
     __HAL_RCC_USART2_CLK_DISABLE();
@@ -95,9 +179,38 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* huart)
     */
     HAL_GPIO_DeInit(GPIOA, USART_TX_Pin|USART_RX_Pin);
 
+    if(huart->Init.HwFlowCtl == UART_HWCONTROL_RTS_CTS)
+    {
+      HAL_GPIO_DeInit(USART2_CTS_GPIO_Port, USART2_CTS_Pin|USART2_RTS_Pin);
+    }
+
     /* USART2 interrupt DeInit */
     HAL_NVIC_DisableIRQ(USART2_IRQn);
   }
+  else if(huart->Instance==USART6)
+  {
+    /* Peripheral clock disable */
+    __HAL_RCC_USART6_CLK_DISABLE();
+
+    /**USART6 GPIO Configuration
+    PC6     ------> USART6_TX
+    PC7     ------> USART6_RX
+    */
+    HAL_GPIO_DeInit(USART6_TX_GPIO_Port, USART6_TX_Pin|USART6_RX_Pin);
+
+    /* USART6 interrupt DeInit */
+    HAL_NVIC_DisableIRQ(USART6_IRQn);
+  }
+
+  /* USART DMA DeInit */
+  if(huart->hdmarx != NULL)
+  {
+    HAL_DMA_DeInit(huart->hdmarx);
+  }
+  if(huart->hdmatx != NULL)
+  {
+    HAL_DMA_DeInit(huart->hdmatx);
+  }
 }
 
 /**
@@ -8,6 +8,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 #include "stm32f4xx_it.h"
+#include "uart_driver.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* Private typedef -----------------------------------------------------------*/
@@ -17,8 +18,6 @@
 /* Private function prototypes -----------------------------------------------*/
 /* External variables --------------------------------------------------------*/
 
-extern UART_HandleTypeDef huart2;
-
 
 /******************************************************************************/
 /*           Cortex-M4 Processor Interruption and Exception Handlers          */
@@ -113,13 +112,81 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32f4xx.s).                    */
 /******************************************************************************/
 
+/**
+  * @brief This function handles USART1 global interrupt.
+  */
+void USART1_IRQHandler(void)
+{
+  uart_irq_handler(UART_PORT_1);
+}
+
 /**
   * @brief This function handles USART2 global interrupt.
   */
 void USART2_IRQHandler(void)
 {
-  HAL_UART_IRQHandler(&huart2);
+  uart_irq_handler(UART_PORT_2);
+}
+
+/**
+  * @brief This function handles USART6 global interrupt.
+  */
+void USART6_IRQHandler(void)
+{
+  uart_irq_handler(UART_PORT_6);
+}
+
+#if UART_RX_DMA_ENABLE
+/**
+  * @brief This function handles DMA2 stream2 global interrupt (USART1_RX).
+  */
+void DMA2_Stream2_IRQHandler(void)
+{
+  uart_rx_dma_irq_handler(UART_PORT_1);
+}
+
+/**
+  * @brief This function handles DMA1 stream5 global interrupt (USART2_RX).
+  */
+void DMA1_Stream5_IRQHandler(void)
+{
+  uart_rx_dma_irq_handler(UART_PORT_2);
+}
+
+/**
+  * @brief This function handles DMA2 stream1 global interrupt (USART6_RX).
+  */
+void DMA2_Stream1_IRQHandler(void)
+{
+  uart_rx_dma_irq_handler(UART_PORT_6);
+}
+#endif
+
+#if UART_TX_DMA_ENABLE
+/**
+  * @brief This function handles DMA2 stream7 global interrupt (USART1_TX).
+  */
+void DMA2_Stream7_IRQHandler(void)
+{
+  uart_tx_dma_irq_handler(UART_PORT_1);
+}
+
+/**
+  * @brief This function handles DMA1 stream6 global interrupt (USART2_TX).
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+  uart_tx_dma_irq_handler(UART_PORT_2);
+}
+
+/**
+  * @brief This function handles DMA2 stream6 global interrupt (USART6_TX).
+  */
+void DMA2_Stream6_IRQHandler(void)
+{
+  uart_tx_dma_irq_handler(UART_PORT_6);
 }
+#endif
 
 
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,181 @@
+/**
+ * @file bench_circular_buffer.c
+ * @brief  Host benchmark of the circular buffer, built once per index mode (CIRCULAR_BUFF_POW2_MODE)
+ * @version 0.1
+ *
+ * @note   Figures are host figures, they compare modes and chunk sizes, not target timings.
+ *         Cycles are TSC cycles on x86 hosts, other hosts only report ns.
+ */
+
+#include "test.h"
+#include "circular_buffer.h"
+#include "pthread.h"
+#include "sched.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include "x86intrin.h"
+#endif
+
+#if CIRCULAR_BUFF_POW2_MODE
+#define BENCH_BUFF_SIZE     (2048)
+#else
+#define BENCH_BUFF_SIZE     (2000)
+#endif
+#define BENCH_BYTES         (64u * 1024u * 1024u)
+#define BENCH_COPY_BYTES    (16u * 1024u * 1024u)
+
+/**
+ * @brief Return a cycle count, 0 if the host has no cycle counter available
+ */
+static inline uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Throughput benchmark context, a producer thread and a consumer thread
+ */
+typedef struct
+{
+    c_buff_handle_t cb;
+    size_t chunk;           /* bytes per write and per read */
+}bench_ctx_t;
+
+static void *bench_producer(void *arg)
+{
+    bench_ctx_t *ctx = arg;
+    uint8_t chunk[BENCH_BUFF_SIZE] = {0};
+
+    for (size_t sent = 0; sent < BENCH_BYTES;)
+    {
+        if (circular_buff_write(ctx->cb, chunk, ctx->chunk) == CIRCULAR_BUFF_OK)
+        {
+            sent += ctx->chunk;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void *bench_consumer(void *arg)
+{
+    bench_ctx_t *ctx = arg;
+    uint8_t chunk[BENCH_BUFF_SIZE];
+
+    for (size_t received = 0; received < BENCH_BYTES;)
+    {
+        if (circular_buff_read(ctx->cb, chunk, ctx->chunk))
+        {
+            received += ctx->chunk;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Stream BENCH_BYTES from a producer thread to a consumer thread
+ */
+static void bench_spsc_throughput(size_t chunk)
+{
+    static uint8_t buffer[BENCH_BUFF_SIZE];
+    circular_buff_t ctrl;
+    bench_ctx_t ctx = {.chunk = chunk};
+    pthread_t producer, consumer;
+
+    ctx.cb = circular_buff_init_static(&ctrl, buffer, BENCH_BUFF_SIZE);
+
+    uint64_t start = test_time_ns();
+
+    pthread_create(&consumer, NULL, bench_consumer, &ctx);
+    pthread_create(&producer, NULL, bench_producer, &ctx);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    uint64_t elapsed = test_time_ns() - start;
+
+    printf("spsc throughput, chunk %4zu B : %8.1f MB/s\n", chunk, (double)BENCH_BYTES * 1000.0 / (double)elapsed);
+}
+
+/**
+ * @brief Move BENCH_COPY_BYTES through the buffer in transfers of a given size, byte per byte
+ *        with put/get (the path before the bulk copy) and with the two-segment write/read
+ */
+static void bench_bulk_copy(size_t transfer)
+{
+    static uint8_t buffer[BENCH_BUFF_SIZE];
+    static uint8_t data[BENCH_BUFF_SIZE];
+    circular_buff_t ctrl;
+    c_buff_handle_t cb = circular_buff_init_static(&ctrl, buffer, BENCH_BUFF_SIZE);
+    size_t rounds = BENCH_COPY_BYTES / transfer;
+    size_t errors = 0;
+
+    /* Odd start so the transfers keep crossing the end of the buffer */
+    circular_buff_write(cb, data, 7);
+    circular_buff_read(cb, data, 7);
+
+    uint64_t start_ns = test_time_ns();
+    uint64_t start_cycles = bench_cycles();
+
+    for (size_t round = 0; round < rounds; round++)
+    {
+        for (size_t i = 0; i < transfer; i++)
+        {
+            errors += !circular_buff_put(cb, data[i]);
+        }
+
+        for (size_t i = 0; i < transfer; i++)
+        {
+            errors += !circular_buff_get(cb, &data[i]);
+        }
+    }
+
+    uint64_t byte_ns = test_time_ns() - start_ns;
+    uint64_t byte_cycles = bench_cycles() - start_cycles;
+
+    start_ns = test_time_ns();
+    start_cycles = bench_cycles();
+
+    for (size_t round = 0; round < rounds; round++)
+    {
+        errors += (circular_buff_write(cb, data, transfer) != CIRCULAR_BUFF_OK);
+        errors += !circular_buff_read(cb, data, transfer);
+    }
+
+    uint64_t bulk_ns = test_time_ns() - start_ns;
+    uint64_t bulk_cycles = bench_cycles() - start_cycles;
+    double bytes = (double)rounds * (double)transfer;
+
+    printf("copy %4zu B, put/get : %7.3f B/ns %7.3f B/cycle | write/read : %7.3f B/ns %7.3f B/cycle%s\n", transfer,
+           bytes / (double)byte_ns, byte_cycles ? bytes / (double)byte_cycles : 0.0,
+           bytes / (double)bulk_ns, bulk_cycles ? bytes / (double)bulk_cycles : 0.0,
+           errors ? " (transfer errors)" : "");
+}
+
+int main(void)
+{
+    printf("circular buffer, %s index mode, %d B buffer\n",
+           CIRCULAR_BUFF_POW2_MODE ? "power-of-two" : "modulo", BENCH_BUFF_SIZE);
+
+    bench_bulk_copy(1);
+    bench_bulk_copy(16);
+    bench_bulk_copy(256);
+    bench_bulk_copy(1024);
+
+    bench_spsc_throughput(1);
+    bench_spsc_throughput(16);
+    bench_spsc_throughput(256);
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file bench_frame_parser.c
+ * @brief  Host benchmark of the streaming frame parser, built with the default MAX_PAYLOAD_SIZE
+ *         and with a jumbo frame configuration
+ * @version 0.1
+ *
+ * @note   Figures are host figures. rx_comm_bench_0() in tdd.c measures the same on the target.
+ *         The verdict latency is the cost of feeding the last postamble byte. It is compared with
+ *         a crc over the whole header and payload, which is what a parser that waits for the
+ *         whole frame has to run once the last byte is in. Cycles are TSC cycles on x86 hosts,
+ *         other hosts only report ns.
+ */
+
+#include "test.h"
+#include "test_frame.h"
+#include "frame_parser.h"
+#include "stdlib.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include "x86intrin.h"
+#endif
+
+#define BENCH_BYTES         (64u * 1024u * 1024u)
+#define BENCH_VERDICTS      (20000u)
+
+/**
+ * @brief Return a cycle count, 0 if the host has no cycle counter available
+ */
+static inline uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static int bench_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Feed a frame without its preamble and last byte to the parser, in chunks
+ */
+static frame_parser_result_t bench_feed(frame_parser_t *parser, const uint8_t *frame, size_t frame_len, size_t chunk)
+{
+    frame_parser_result_t result = FRAME_PARSER_MORE;
+    size_t idx = PREAMBLE_SIZE_BYTES;
+    size_t consumed;
+
+    frame_parser_start(parser);
+
+    while (idx < frame_len - 1)
+    {
+        size_t len = frame_len - 1 - idx;
+
+        len = (len < chunk) ? len : chunk;
+        result = frame_parser_feed(parser, &frame[idx], len, &consumed);
+        idx += consumed;
+
+        if ((result != FRAME_PARSER_MORE) && (result != FRAME_PARSER_HEADER_DONE) && (result != FRAME_PARSER_PAYLOAD_DONE))
+        {
+            break;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Parse frames of a given payload length in chunks of a given size, report ns/byte
+ */
+static void bench_throughput(const uint8_t *frame, size_t frame_len, size_t chunk)
+{
+    static packet_data_t packet;
+    frame_parser_t parser;
+    size_t frames = BENCH_BYTES / frame_len;
+    size_t errors = 0;
+    size_t consumed;
+
+    frame_parser_init(&parser, &packet);
+
+    uint64_t start_ns = test_time_ns();
+    uint64_t start_cycles = bench_cycles();
+
+    for (size_t i = 0; i < frames; i++)
+    {
+        bench_feed(&parser, frame, frame_len, chunk);
+        errors += (frame_parser_feed(&parser, &frame[frame_len - 1], 1, &consumed) != FRAME_PARSER_FRAME_OK);
+    }
+
+    uint64_t elapsed_ns = test_time_ns() - start_ns;
+    uint64_t elapsed_cycles = bench_cycles() - start_cycles;
+    double bytes = (double)frames * (double)(frame_len - PREAMBLE_SIZE_BYTES);
+
+    printf("frame %5zu B, chunk %5zu B : %6.3f ns/byte %6.3f cycles/byte%s\n", frame_len, chunk,
+           (double)elapsed_ns / bytes, (double)elapsed_cycles / bytes, errors ? " (parse errors)" : "");
+}
+
+/**
+ * @brief End of frame to verdict latency of the streaming parser, and of a crc run over the
+ *        whole frame once it is complete
+ */
+static void bench_verdict_latency(const uint8_t *frame, size_t frame_len)
+{
+    static packet_data_t packet;
+    static uint64_t parser_ns[BENCH_VERDICTS];
+    static uint64_t crc_ns[BENCH_VERDICTS];
+    frame_parser_t parser;
+    size_t errors = 0;
+    size_t consumed;
+
+    frame_parser_init(&parser, &packet);
+
+    for (size_t i = 0; i < BENCH_VERDICTS; i++)
+    {
+        uint32_t crc = 0;
+
+        bench_feed(&parser, frame, frame_len, frame_len);
+
+        uint64_t start = test_time_ns();
+        errors += (frame_parser_feed(&parser, &frame[frame_len - 1], 1, &consumed) != FRAME_PARSER_FRAME_OK);
+        parser_ns[i] = test_time_ns() - start;
+
+        start = test_time_ns();
+        crc32_accumulate(&frame[PREAMBLE_SIZE_BYTES], frame_len - FRAME_OVERHEAD_BYTES + HEADER_SIZE_BYTES, &crc);
+        __asm__ volatile("" : : "r"(crc) : "memory");
+        crc_ns[i] = test_time_ns() - start;
+    }
+
+    /* Medians, the clock read overhead is included in both */
+    qsort(parser_ns, BENCH_VERDICTS, sizeof(parser_ns[0]), bench_cmp_u64);
+    qsort(crc_ns, BENCH_VERDICTS, sizeof(crc_ns[0]), bench_cmp_u64);
+
+    printf("frame %5zu B, verdict latency : streaming %5llu ns | crc of the whole frame %7llu ns%s\n", frame_len,
+           (unsigned long long)parser_ns[BENCH_VERDICTS / 2], (unsigned long long)crc_ns[BENCH_VERDICTS / 2],
+           errors ? " (parse errors)" : "");
+}
+
+int main(void)
+{
+    static uint8_t frame[MAX_FRAME_SIZE];
+    static uint8_t payload[MAX_PAYLOAD_SIZE];
+    const size_t payload_lens[] = {0, 16, MAX_PAYLOAD_SIZE};
+    const size_t chunks[] = {1, 16, 64, 256, MAX_FRAME_SIZE};
+
+    for (size_t i = 0; i < MAX_PAYLOAD_SIZE; i++)
+    {
+        payload[i] = (uint8_t)i;
+    }
+
+    printf("frame parser, MAX_PAYLOAD_SIZE %d\n", MAX_PAYLOAD_SIZE);
+
+    for (size_t p = 0; p < sizeof(payload_lens) / sizeof(payload_lens[0]); p++)
+    {
+        packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_GET_FW_VERSION, PROTOCOL_ADDR_P2P, payload_lens[p]);
+        size_t frame_len = test_frame_build(frame, &header, payload);
+
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+        {
+            if ((c == 0) || (chunks[c - 1] < frame_len))
+            {
+                bench_throughput(frame, frame_len, chunks[c]);
+            }
+        }
+
+        bench_verdict_latency(frame, frame_len);
+    }
+
+    return 0;
+}
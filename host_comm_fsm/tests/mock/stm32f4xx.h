@@ -0,0 +1,36 @@
+/**
+ * @file stm32f4xx.h
+ * @brief  Host stand-in of the device header, only the DWT cycle counter used by timestamp.h
+ * @version 0.1
+ *
+ * @note   The cycle counter does not run on its own, tests move it forward with DWT->CYCCNT.
+ */
+
+#ifndef _MOCK_STM32F4XX_H
+#define _MOCK_STM32F4XX_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+}DWT_Type;
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+}CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+extern DWT_Type mock_dwt;
+extern CoreDebug_Type mock_core_debug;
+extern uint32_t SystemCoreClock;
+
+#define DWT         (&mock_dwt)
+#define CoreDebug   (&mock_core_debug)
+
+#endif
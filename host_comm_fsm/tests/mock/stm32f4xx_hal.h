@@ -0,0 +1,15 @@
+/**
+ * @file stm32f4xx_hal.h
+ * @brief  Host stand-in of the HAL header, the host_comm sources use no HAL call directly
+ * @version 0.1
+ */
+
+#ifndef _MOCK_STM32F4XX_HAL_H
+#define _MOCK_STM32F4XX_HAL_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+#endif
@@ -0,0 +1,183 @@
+/**
+ * @file uart_mock.c
+ * @brief  Host stand-in of the serial ports, see uart_mock.h
+ * @version 0.1
+ */
+
+#include "uart_mock.h"
+#include "string.h"
+
+/*@brief Device registers of timestamp.h, the cycle counter is moved by the tests */
+DWT_Type mock_dwt;
+CoreDebug_Type mock_core_debug;
+uint32_t SystemCoreClock = 84000000;
+
+struct uart_port_t
+{
+    circular_buff_t rx_ctrl;
+    c_buff_handle_t rx_cb;
+    uint8_t rx_data[RX_DATA_BUFF_SIZE];
+    uint8_t tx_data[TX_DATA_BUFF_SIZE];
+    size_t tx_len;                  /* bytes transmitted and not taken by the test yet */
+    uint32_t baudrate;
+    bool rs485;
+};
+
+static uart_port_t uart_ports[UART_PORT_CNT];
+
+uint8_t uart_init(void)
+{
+    for (size_t port_idx = 0; port_idx < UART_PORT_CNT; port_idx++)
+    {
+        uart_port_t *port = &uart_ports[port_idx];
+
+        port->rx_cb = circular_buff_init_static(&port->rx_ctrl, port->rx_data, RX_DATA_BUFF_SIZE);
+        port->tx_len = 0;
+        port->baudrate = UART_MOCK_BAUDRATE;
+        port->rs485 = false;
+    }
+
+    return 1;
+}
+
+uart_port_t *uart_get_port(uart_port_id_t id)
+{
+    return (id < UART_PORT_CNT) ? &uart_ports[id] : NULL;
+}
+
+void uart_mock_set_rs485(uart_port_t *port, bool rs485)
+{
+    port->rs485 = rs485;
+}
+
+size_t uart_mock_rx_write(uart_port_t *port, const uint8_t *data, size_t len)
+{
+    size_t free_len = RX_DATA_BUFF_SIZE - circular_buff_get_data_len(port->rx_cb);
+
+    len = (len < free_len) ? len : free_len;
+    circular_buff_write(port->rx_cb, (uint8_t *)data, len);
+    return len;
+}
+
+size_t uart_mock_tx_read(uart_port_t *port, uint8_t *data, size_t size)
+{
+    size_t len = (port->tx_len < size) ? port->tx_len : size;
+
+    memcpy(data, port->tx_data, len);
+    memmove(port->tx_data, &port->tx_data[len], port->tx_len - len);
+    port->tx_len -= len;
+    return len;
+}
+
+size_t uart_get_rx_data_len(uart_port_t *port)
+{
+    return circular_buff_get_data_len(port->rx_cb);
+}
+
+size_t uart_peek_rx_data(uart_port_t *port, circular_buff_region_t region[2])
+{
+    return circular_buff_peek(port->rx_cb, region);
+}
+
+uint8_t uart_commit_rx_data(uart_port_t *port, size_t len)
+{
+    circular_buff_commit_read(port->rx_cb, len);
+    return 1;
+}
+
+uint8_t uart_get_rx_timestamp(uart_port_t *port, size_t offset, uint32_t *timestamp)
+{
+    (void)port;
+    (void)offset;
+    (void)timestamp;
+    return 0;
+}
+
+uint8_t uart_find_rx_data(uart_port_t *port, const uint8_t *pattern, size_t pattern_len, size_t *offset)
+{
+    return circular_buff_find(port->rx_cb, pattern, pattern_len, offset);
+}
+
+uint8_t uart_clear_rx_data(uart_port_t *port)
+{
+    circular_buff_commit_read(port->rx_cb, circular_buff_get_data_len(port->rx_cb));
+    return 1;
+}
+
+uint8_t uart_transmit_itv(uart_port_t *port, const circular_buff_segment_t *segment, size_t segment_cnt)
+{
+    size_t len = 0;
+
+    for (size_t seg_idx = 0; seg_idx < segment_cnt; seg_idx++)
+    {
+        len += segment[seg_idx].len;
+    }
+
+    /* All or nothing, as the bip buffer of the driver */
+    if (len > TX_DATA_BUFF_SIZE - port->tx_len)
+    {
+        return 0;
+    }
+
+    for (size_t seg_idx = 0; seg_idx < segment_cnt; seg_idx++)
+    {
+        memcpy(&port->tx_data[port->tx_len], segment[seg_idx].data, segment[seg_idx].len);
+        port->tx_len += segment[seg_idx].len;
+    }
+
+    return 1;
+}
+
+void uart_tx_service(uart_port_t *port)
+{
+    (void)port;
+}
+
+uint8_t uart_check_baudrate(uart_port_t *port, uint32_t baudrate)
+{
+    (void)port;
+    return (baudrate >= 1200) && (baudrate <= 6000000);
+}
+
+uint8_t uart_set_baudrate(uart_port_t *port, uint32_t baudrate)
+{
+    if (!uart_check_baudrate(port, baudrate) || !uart_is_tx_idle(port))
+    {
+        return 0;
+    }
+
+    port->baudrate = baudrate;
+    return 1;
+}
+
+uint32_t uart_get_baudrate(uart_port_t *port)
+{
+    return port->baudrate;
+}
+
+uint32_t uart_bytes_to_ms(uart_port_t *port, size_t len)
+{
+    return (uint32_t)(((uint64_t)len * UART_BITS_PER_BYTE * 1000U + port->baudrate - 1) / port->baudrate);
+}
+
+bool uart_is_tx_idle(uart_port_t *port)
+{
+    return port->tx_len == 0;
+}
+
+bool uart_is_rs485(uart_port_t *port)
+{
+    return port->rs485;
+}
+
+uart_flow_ctrl_t uart_get_flow_ctrl(uart_port_t *port)
+{
+    (void)port;
+    return UART_FLOW_CTRL_NONE;
+}
+
+bool uart_rx_flow_is_stopped(uart_port_t *port)
+{
+    (void)port;
+    return false;
+}
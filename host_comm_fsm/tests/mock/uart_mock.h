@@ -0,0 +1,28 @@
+/**
+ * @file uart_mock.h
+ * @brief  Host stand-in of the serial ports, the line is driven by the test
+ * @version 0.1
+ *
+ * @note   Received bytes are written straight into the rx ring of the port, transmitted bytes are
+ *         kept until the test takes them. The tx line is idle as soon as the bytes are taken.
+ *         The API of uart_driver.h is implemented as far as the host_comm sources use it.
+ */
+
+#ifndef _UART_MOCK_H
+#define _UART_MOCK_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "uart_driver.h"
+
+#define UART_MOCK_BAUDRATE      (115200)
+
+/** Set up a port as RS-485 (shared bus) or full duplex, to be called after uart_init() */
+void uart_mock_set_rs485(uart_port_t *port, bool rs485);
+
+/** Bytes received on the line, the bytes that do not fit in the rx ring are dropped */
+size_t uart_mock_rx_write(uart_port_t *port, const uint8_t *data, size_t len);
+
+/** Take the bytes transmitted so far, up to size bytes */
+size_t uart_mock_tx_read(uart_port_t *port, uint8_t *data, size_t size);
+
+#endif
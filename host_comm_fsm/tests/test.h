@@ -0,0 +1,70 @@
+/**
+ * @file test.h
+ * @brief  Minimal check macros of the host tests
+ * @version 0.1
+ *
+ * @note   Every test program is a single translation unit: checks count the failures, the
+ *         program returns non zero if any check failed so make stops.
+ */
+
+#ifndef _TEST_H
+#define _TEST_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdio.h"
+#include "stdint.h"
+#include "stdbool.h"
+#include "time.h"
+
+/*@brief Number of checks failed in the test program */
+static int test_failures __attribute__((unused));
+
+/**@brief Check a condition, report it and go on if it does not hold */
+#define TEST_CHECK(cond)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(cond))                                                            \
+        {                                                                       \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);     \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+/**@brief Run a test function and report its result */
+#define TEST_RUN(test)                                                          \
+    do                                                                          \
+    {                                                                           \
+        int failures = test_failures;                                           \
+        test();                                                                 \
+        printf("%-48s %s\n", #test, (failures == test_failures) ? "ok" : "FAILED"); \
+    } while (0)
+
+/**@brief Exit status of the test program */
+#define TEST_RESULT() ((test_failures == 0) ? 0 : 1)
+
+/**
+ * @brief Return a monotonic time in ns, for the benchmarks
+ */
+static inline uint64_t test_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Pseudo random generator (xorshift32), tests are reproducible from their seed
+ */
+static inline uint32_t test_rand(uint32_t *seed)
+{
+    uint32_t x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+#endif
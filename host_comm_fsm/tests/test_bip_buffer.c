@@ -0,0 +1,320 @@
+/**
+ * @file test_bip_buffer.c
+ * @brief  Host tests of the bip buffer wrap rules
+ * @version 0.1
+ *
+ * @note   Blocks carry a byte stream (0, 1, 2, ...) so data is checked in order whatever the
+ *         block boundaries seen by the reader.
+ */
+
+#include "test.h"
+#include "bip_buffer.h"
+#include "pthread.h"
+#include "sched.h"
+#include "string.h"
+
+#define TEST_BUFF_SIZE      (16)
+#define STRESS_BUFF_SIZE    (61)
+#define STRESS_BYTES        (4u * 1024u * 1024u)
+#define STRESS_MAX_BLOCK    (24)
+
+/**
+ * @brief Reserve a block, fill it with the next bytes of the stream and commit it
+ * @return uint8_t* start of the block, NULL if it was not reserved
+ */
+static uint8_t *block_write(bip_buff_handle_t bip, size_t len, uint8_t *stream)
+{
+    uint8_t *block = bip_buff_reserve(bip, len);
+
+    if (block != NULL)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            block[i] = (*stream)++;
+        }
+
+        bip_buff_commit_write(bip, len);
+    }
+
+    return block;
+}
+
+/**
+ * @brief Peek the next block, check its position and content and consume it
+ */
+static bool block_read(bip_buff_handle_t bip, const uint8_t *expected_ptr, size_t expected_len, uint8_t *stream)
+{
+    uint8_t *data;
+    size_t len = bip_buff_peek(bip, &data);
+    bool ok = (len == expected_len) && (data == expected_ptr);
+
+    for (size_t i = 0; ok && (i < len); i++)
+    {
+        ok = (data[i] == (*stream)++);
+    }
+
+    bip_buff_commit_read(bip, len);
+    return ok;
+}
+
+static void test_contiguous(void)
+{
+    static uint8_t buffer[TEST_BUFF_SIZE];
+    bip_buff_t ctrl;
+    bip_buff_handle_t bip = bip_buff_init_static(&ctrl, buffer, TEST_BUFF_SIZE);
+    uint8_t in = 0, out = 0;
+    uint8_t *data;
+
+    TEST_CHECK(bip_buff_peek(bip, &data) == 0);
+    TEST_CHECK(block_write(bip, 4, &in) == &buffer[0]);
+    TEST_CHECK(block_write(bip, 5, &in) == &buffer[4]);
+    TEST_CHECK(bip_buff_get_data_len(bip) == 9);
+
+    /* Only the committed part of a reservation is published */
+    TEST_CHECK(bip_buff_reserve(bip, 6) == &buffer[9]);
+    buffer[9] = in++;
+    buffer[10] = in++;
+    bip_buff_commit_write(bip, 2);
+    TEST_CHECK(bip_buff_get_data_len(bip) == 11);
+
+    /* Partial read, the rest of the block stays in place */
+    TEST_CHECK(bip_buff_peek(bip, &data) == 11 && data == &buffer[0]);
+    bip_buff_commit_read(bip, 3);
+    out = 3;
+    TEST_CHECK(block_read(bip, &buffer[3], 8, &out));
+    TEST_CHECK(bip_buff_get_data_len(bip) == 0);
+}
+
+static void test_full(void)
+{
+    static uint8_t buffer[TEST_BUFF_SIZE];
+    bip_buff_t ctrl;
+    bip_buff_handle_t bip = bip_buff_init_static(&ctrl, buffer, TEST_BUFF_SIZE);
+    uint8_t in = 0, out = 0;
+
+    /* Empty at the beginning: the whole buffer is reservable */
+    TEST_CHECK(block_write(bip, TEST_BUFF_SIZE, &in) == &buffer[0]);
+    TEST_CHECK(bip_buff_reserve(bip, 1) == NULL);
+    TEST_CHECK(block_read(bip, &buffer[0], TEST_BUFF_SIZE, &out));
+
+    /* Empty at the end: a wrapped block must stay behind the read index, one byte is lost */
+    TEST_CHECK(bip_buff_reserve(bip, TEST_BUFF_SIZE) == NULL);
+    TEST_CHECK(block_write(bip, TEST_BUFF_SIZE - 1, &in) == &buffer[0]);
+    TEST_CHECK(block_read(bip, &buffer[0], TEST_BUFF_SIZE - 1, &out));
+}
+
+static void test_wrap(void)
+{
+    static uint8_t buffer[TEST_BUFF_SIZE];
+    bip_buff_t ctrl;
+    bip_buff_handle_t bip = bip_buff_init_static(&ctrl, buffer, TEST_BUFF_SIZE);
+    uint8_t in = 0, out = 0;
+
+    /* write = 12, read = 6 */
+    block_write(bip, 12, &in);
+    bip_buff_commit_read(bip, 6);
+    out = 6;
+
+    /* Fits exactly at the end: no wrap */
+    TEST_CHECK(block_write(bip, 4, &in) == &buffer[12]);
+
+    /* End full, the block restarts at the beginning and 'last' marks the end of the older data */
+    TEST_CHECK(block_write(bip, 5, &in) == &buffer[0]);
+    TEST_CHECK(atomic_load(&ctrl.last) == TEST_BUFF_SIZE);
+    TEST_CHECK(bip_buff_get_data_len(bip) == 15);
+
+    /* The write index stays strictly behind the read index: 1 byte free but not reservable */
+    TEST_CHECK(bip_buff_reserve(bip, 1) == NULL);
+
+    /* The reader goes up to 'last', then continues from the beginning */
+    TEST_CHECK(block_read(bip, &buffer[6], 10, &out));
+    TEST_CHECK(block_read(bip, &buffer[0], 5, &out));
+    TEST_CHECK(bip_buff_get_data_len(bip) == 0);
+}
+
+static void test_wrap_skips_tail(void)
+{
+    static uint8_t buffer[TEST_BUFF_SIZE];
+    bip_buff_t ctrl;
+    bip_buff_handle_t bip = bip_buff_init_static(&ctrl, buffer, TEST_BUFF_SIZE);
+    uint8_t in = 0, out = 0;
+
+    /* write = 10, read = 8 : 6 bytes free at the end, 8 at the beginning */
+    block_write(bip, 10, &in);
+    bip_buff_commit_read(bip, 8);
+    out = 8;
+
+    /* Larger than the end, not behind the read index once wrapped */
+    TEST_CHECK(bip_buff_reserve(bip, 8) == NULL);
+
+    /* Larger than the end: wraps, the unused tail [10, 16) is skipped by the reader */
+    TEST_CHECK(block_write(bip, 7, &in) == &buffer[0]);
+    TEST_CHECK(atomic_load(&ctrl.last) == 10);
+    TEST_CHECK(bip_buff_get_data_len(bip) == 9);
+    TEST_CHECK(block_read(bip, &buffer[8], 2, &out));
+    TEST_CHECK(block_read(bip, &buffer[0], 7, &out));
+    TEST_CHECK(bip_buff_get_data_len(bip) == 0);
+}
+
+static void test_wrap_empty(void)
+{
+    static uint8_t buffer[TEST_BUFF_SIZE];
+    bip_buff_t ctrl;
+    bip_buff_handle_t bip = bip_buff_init_static(&ctrl, buffer, TEST_BUFF_SIZE);
+    uint8_t in = 0, out = 0;
+
+    /* Empty with write = read = 12 : a block larger than the end wraps, 'last' equals read */
+    block_write(bip, 12, &in);
+    TEST_CHECK(block_read(bip, &buffer[0], 12, &out));
+
+    TEST_CHECK(block_write(bip, 8, &in) == &buffer[0]);
+    TEST_CHECK(bip_buff_get_data_len(bip) == 8);
+    TEST_CHECK(block_read(bip, &buffer[0], 8, &out));
+}
+
+static void test_writev(void)
+{
+    static uint8_t buffer[TEST_BUFF_SIZE];
+    bip_buff_t ctrl;
+    bip_buff_handle_t bip = bip_buff_init_static(&ctrl, buffer, TEST_BUFF_SIZE);
+    const uint8_t head[3] = {10, 11, 12};
+    const uint8_t body[4] = {13, 14, 15, 16};
+    const uint8_t tail[1] = {17};
+    circular_buff_segment_t segment[3] = {{head, sizeof(head)}, {body, sizeof(body)}, {tail, sizeof(tail)}};
+    circular_buff_stats_t stats;
+    uint8_t in = 0, out = 0;
+    uint8_t *data;
+
+    /* write = 10, read = 8 : 2 bytes stored, 6 free at the end, 7 usable at the beginning */
+    block_write(bip, 10, &in);
+    bip_buff_commit_read(bip, 8);
+    out = 8;
+    bip_buff_reset_stats(bip);
+
+    /* 8 bytes: 14 free in total but no contiguous block, nothing is written */
+    TEST_CHECK(bip_buff_writev(bip, segment, 3) == CIRCUILAR_BUFF_NOT_ENOUGH_SPACE);
+    TEST_CHECK(bip_buff_get_data_len(bip) == 2);
+#if CIRCULAR_BUFF_STATS_ENABLE
+    bip_buff_get_stats(bip, &stats);
+    TEST_CHECK(stats.overflow_cnt == 1 && stats.bytes_dropped == 8 && stats.bytes_in == 0);
+#endif
+
+    /* 7 bytes: wraps, the segments are concatenated in one block */
+    TEST_CHECK(bip_buff_writev(bip, segment, 2) == CIRCULAR_BUFF_OK);
+    TEST_CHECK(block_read(bip, &buffer[8], 2, &out));
+    TEST_CHECK(bip_buff_peek(bip, &data) == 7 && data == &buffer[0]);
+    TEST_CHECK(memcmp(data, head, sizeof(head)) == 0 && memcmp(&data[3], body, sizeof(body)) == 0);
+    bip_buff_commit_read(bip, 7);
+
+#if CIRCULAR_BUFF_STATS_ENABLE
+    bip_buff_get_stats(bip, &stats);
+    TEST_CHECK(stats.bytes_in == 7 && stats.bytes_out == 9 && stats.high_water == 9);
+#endif
+}
+
+/**
+ * @brief Stress context, the producer writes blocks of random length, the consumer
+ *        reads random parts of the blocks returned by peek
+ */
+typedef struct
+{
+    bip_buff_handle_t bip;
+    uint8_t *buffer;
+    size_t errors;
+}stress_ctx_t;
+
+static void *stress_producer(void *arg)
+{
+    stress_ctx_t *ctx = arg;
+    uint32_t seed = 0x1234567u;
+    uint8_t stream = 0;
+    size_t len = 0;
+
+    for (size_t sent = 0; sent < STRESS_BYTES;)
+    {
+        /* A rejected block is retried with the same length */
+        len = (len != 0) ? len : 1 + test_rand(&seed) % STRESS_MAX_BLOCK;
+        len = (len > STRESS_BYTES - sent) ? STRESS_BYTES - sent : len;
+
+        if (block_write(ctx->bip, len, &stream) != NULL)
+        {
+            sent += len;
+            len = 0;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void *stress_consumer(void *arg)
+{
+    stress_ctx_t *ctx = arg;
+    uint32_t seed = 0x7654321u;
+    uint8_t stream = 0;
+    uint8_t *data;
+
+    for (size_t received = 0; received < STRESS_BYTES;)
+    {
+        size_t len = bip_buff_peek(ctx->bip, &data);
+
+        if (len == 0)
+        {
+            sched_yield();
+            continue;
+        }
+
+        /* Every block lies in the buffer, and is consumed partly to move the read index around */
+        ctx->errors += (data < ctx->buffer) || (data + len > ctx->buffer + STRESS_BUFF_SIZE);
+        len = 1 + test_rand(&seed) % len;
+
+        for (size_t i = 0; i < len; i++)
+        {
+            ctx->errors += (data[i] != stream++);
+        }
+
+        bip_buff_commit_read(ctx->bip, len);
+        received += len;
+    }
+
+    return NULL;
+}
+
+static void test_spsc_stress(void)
+{
+    static uint8_t buffer[STRESS_BUFF_SIZE];
+    bip_buff_t ctrl;
+    stress_ctx_t ctx = {.bip = bip_buff_init_static(&ctrl, buffer, STRESS_BUFF_SIZE), .buffer = buffer};
+    pthread_t producer, consumer;
+
+    pthread_create(&consumer, NULL, stress_consumer, &ctx);
+    pthread_create(&producer, NULL, stress_producer, &ctx);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    TEST_CHECK(ctx.errors == 0);
+    TEST_CHECK(bip_buff_get_data_len(ctx.bip) == 0);
+#if CIRCULAR_BUFF_STATS_ENABLE
+    circular_buff_stats_t stats;
+
+    bip_buff_get_stats(ctx.bip, &stats);
+    TEST_CHECK(stats.bytes_in == STRESS_BYTES && stats.bytes_out == STRESS_BYTES);
+    TEST_CHECK(stats.high_water <= STRESS_BUFF_SIZE);
+#endif
+}
+
+int main(void)
+{
+    TEST_RUN(test_contiguous);
+    TEST_RUN(test_full);
+    TEST_RUN(test_wrap);
+    TEST_RUN(test_wrap_skips_tail);
+    TEST_RUN(test_wrap_empty);
+    TEST_RUN(test_writev);
+    TEST_RUN(test_spsc_stress);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,362 @@
+/**
+ * @file test_bus.c
+ * @brief  Host tests of the bus address filtering, three nodes of a simulated RS-485 bus
+ * @version 0.1
+ *
+ * @note   Every node is a rx/tx fsm pair on its own mock port, see mock/uart_mock.h. What the host
+ *         or a node transmits is received by every other party of the bus, the transceiver of a
+ *         node does not hear its own frames.
+ */
+
+#include "test.h"
+#include "test_frame.h"
+#include "uart_mock.h"
+#include "host_comm_rx_fsm.h"
+
+#define BUS_NODE_CNT        (3)
+#define BUS_HOST_BUFF_SIZE  (4096)
+
+/**@brief Node of the bus, its packets are counted by address match */
+typedef struct
+{
+    uart_port_t *port;
+    host_comm_tx_fsm_t tx;
+    host_comm_rx_fsm_t rx;
+    uint8_t addr;
+    uint32_t unicast_cnt;
+    uint32_t broadcast_cnt;
+    packet_data_t last;         /* last packet received */
+}bus_node_t;
+
+static bus_node_t bus_nodes[BUS_NODE_CNT];
+
+/*@brief Bytes transmitted by the nodes, as the host receives them */
+static uint8_t bus_host_data[BUS_HOST_BUFF_SIZE];
+static size_t bus_host_len;
+
+static void bus_init(void)
+{
+    const uart_port_id_t ids[BUS_NODE_CNT] = {UART_PORT_1, UART_PORT_2, UART_PORT_6};
+
+    uart_init();
+    bus_host_len = 0;
+
+    for (size_t node_idx = 0; node_idx < BUS_NODE_CNT; node_idx++)
+    {
+        bus_node_t *node = &bus_nodes[node_idx];
+
+        memset(node, 0, sizeof(*node));
+        node->port = uart_get_port(ids[node_idx]);
+        node->addr = (uint8_t)(node_idx + 1);
+        uart_mock_set_rs485(node->port, true);
+        host_comm_tx_fsm_init(&node->tx, node->port, node->addr);
+        host_comm_rx_fsm_init(&node->rx, node->port, &node->tx, node->addr);
+    }
+}
+
+/**
+ * @brief Put bytes on the bus, every node but the sender receives them
+ * @param src node sending, NULL for the host
+ */
+static void bus_write(const bus_node_t *src, const uint8_t *data, size_t len)
+{
+    for (size_t node_idx = 0; node_idx < BUS_NODE_CNT; node_idx++)
+    {
+        if (&bus_nodes[node_idx] != src)
+        {
+            TEST_CHECK(uart_mock_rx_write(bus_nodes[node_idx].port, data, len) == len);
+        }
+    }
+
+    if (src != NULL)
+    {
+        TEST_CHECK(bus_host_len + len <= BUS_HOST_BUFF_SIZE);
+        memcpy(&bus_host_data[bus_host_len], data, len);
+        bus_host_len += len;
+    }
+}
+
+/**
+ * @brief Run every node until the bus is quiet: frames parsed, packets consumed, answers sent
+ */
+static void bus_run(void)
+{
+    bool busy = true;
+
+    while (busy)
+    {
+        busy = false;
+
+        for (size_t node_idx = 0; node_idx < BUS_NODE_CNT; node_idx++)
+        {
+            bus_node_t *node = &bus_nodes[node_idx];
+            host_comm_rx_packet_t *rx_packet;
+            uint8_t data[TX_DATA_BUFF_SIZE];
+            size_t budget = SIZE_MAX;
+            size_t len;
+
+            /* A full packet pool stops the drain, go on once the packets are consumed */
+            busy |= (host_comm_rx_fsm_drain(&node->rx, &budget) > 0);
+
+            while ((rx_packet = host_comm_rx_fsm_get_packet(&node->rx)) != NULL)
+            {
+                node->unicast_cnt += (rx_packet->addr_match == PROTOCOL_ADDR_MATCH_UNICAST);
+                node->broadcast_cnt += (rx_packet->addr_match == PROTOCOL_ADDR_MATCH_BROADCAST);
+                node->last = rx_packet->packet;
+                host_comm_rx_fsm_release_packet(&node->rx, rx_packet);
+            }
+
+            host_comm_tx_fsm_run(&node->tx);
+            host_comm_tx_fsm_run(&node->tx);
+
+            if ((len = uart_mock_tx_read(node->port, data, sizeof(data))) > 0)
+            {
+                bus_write(node, data, len);
+                busy = true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Take the frames the host received, all of them must be ACKs
+ * @return uint32_t number of ACKs
+ */
+static uint32_t bus_host_take_acks(void)
+{
+    uint32_t acks = 0;
+
+    for (size_t idx = 0; idx < bus_host_len;)
+    {
+        packet_header_t answer;
+        size_t len = test_frame_decode(&bus_host_data[idx], bus_host_len - idx, &answer, NULL);
+
+        TEST_CHECK(len > 0 && answer.type.res == TARGET_TO_HOST_RES_ACK);
+        idx += (len > 0) ? len : bus_host_len;
+        acks++;
+    }
+
+    bus_host_len = 0;
+    return acks;
+}
+
+/**
+ * @brief Check a node received nothing and left its rx ring empty, waiting for a preamble
+ */
+static void bus_check_idle(const bus_node_t *node)
+{
+    TEST_CHECK(node->unicast_cnt == 0 && node->broadcast_cnt == 0);
+    TEST_CHECK(host_comm_rx_fsm_is_state_active(&node->rx, st_comm_rx_preamble_proc));
+    TEST_CHECK(uart_get_rx_data_len(node->port) == 0);
+}
+
+static void test_check_addr(void)
+{
+    packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_GET_FW_VERSION, 0x02, 0);
+
+    /* Point to point link, the address is not checked */
+    TEST_CHECK(protocol_check_addr(&header, PROTOCOL_ADDR_P2P) == PROTOCOL_ADDR_MATCH_UNICAST);
+    header.addr = PROTOCOL_ADDR_BROADCAST;
+    TEST_CHECK(protocol_check_addr(&header, PROTOCOL_ADDR_P2P) == PROTOCOL_ADDR_MATCH_UNICAST);
+
+    /* Bus */
+    header.addr = 0x02;
+    TEST_CHECK(protocol_check_addr(&header, 0x02) == PROTOCOL_ADDR_MATCH_UNICAST);
+    TEST_CHECK(protocol_check_addr(&header, 0x01) == PROTOCOL_ADDR_MATCH_NONE);
+    TEST_CHECK(protocol_check_addr(&header, 0x03) == PROTOCOL_ADDR_MATCH_NONE);
+    header.addr = PROTOCOL_ADDR_BROADCAST;
+    TEST_CHECK(protocol_check_addr(&header, 0x01) == PROTOCOL_ADDR_MATCH_BROADCAST);
+    TEST_CHECK(protocol_check_addr(&header, 0x02) == PROTOCOL_ADDR_MATCH_BROADCAST);
+
+    /* Frames sent by a node are never for another node, whatever their address */
+    header.dir = TARGET_TO_HOST;
+    TEST_CHECK(protocol_check_addr(&header, 0x01) == PROTOCOL_ADDR_MATCH_NONE);
+    header.addr = 0x01;
+    TEST_CHECK(protocol_check_addr(&header, 0x01) == PROTOCOL_ADDR_MATCH_NONE);
+}
+
+static void test_bus_unicast(void)
+{
+    uint8_t frame[MAX_FRAME_SIZE];
+    const uint8_t payload[] = {0xA5, 0x5A, 0x01};
+    packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_GET_FW_VERSION, 2, sizeof(payload));
+    packet_header_t answer;
+
+    bus_init();
+    bus_write(NULL, frame, test_frame_build(frame, &header, payload));
+    bus_run();
+
+    /* Only the node addressed takes the packet */
+    TEST_CHECK(bus_nodes[1].unicast_cnt == 1 && bus_nodes[1].broadcast_cnt == 0);
+    TEST_CHECK(bus_nodes[1].last.header.payload_len == sizeof(payload));
+    TEST_CHECK(memcmp(bus_nodes[1].last.payload.buffer, payload, sizeof(payload)) == 0);
+
+    /* It answers with a single ACK carrying its address, the other nodes drop both frames */
+    TEST_CHECK(test_frame_decode(bus_host_data, bus_host_len, &answer, NULL) == bus_host_len);
+    TEST_CHECK(answer.type.res == TARGET_TO_HOST_RES_ACK && answer.dir == TARGET_TO_HOST && answer.addr == 2);
+    bus_check_idle(&bus_nodes[0]);
+    bus_check_idle(&bus_nodes[2]);
+}
+
+static void test_bus_broadcast(void)
+{
+    uint8_t frame[MAX_FRAME_SIZE];
+    const uint8_t payload[] = {0x10, 0x20};
+    packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_TURN_ON_LED, PROTOCOL_ADDR_BROADCAST, sizeof(payload));
+
+    bus_init();
+    bus_write(NULL, frame, test_frame_build(frame, &header, payload));
+    bus_run();
+
+    /* Every node takes it, none answers */
+    for (size_t node_idx = 0; node_idx < BUS_NODE_CNT; node_idx++)
+    {
+        TEST_CHECK(bus_nodes[node_idx].broadcast_cnt == 1 && bus_nodes[node_idx].unicast_cnt == 0);
+        TEST_CHECK(memcmp(bus_nodes[node_idx].last.payload.buffer, payload, sizeof(payload)) == 0);
+    }
+
+    TEST_CHECK(bus_host_len == 0);
+}
+
+static void test_bus_foreign(void)
+{
+    uint8_t frame[MAX_FRAME_SIZE];
+    packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_GET_FW_VERSION, 0x7E, 0);
+
+    /* Address of no node on the bus: dropped by all, no answer */
+    bus_init();
+    bus_write(NULL, frame, test_frame_build(frame, &header, NULL));
+    bus_run();
+
+    for (size_t node_idx = 0; node_idx < BUS_NODE_CNT; node_idx++)
+    {
+        bus_check_idle(&bus_nodes[node_idx]);
+    }
+
+    TEST_CHECK(bus_host_len == 0);
+}
+
+/**
+ * @brief Feed a foreign frame byte by byte, the skip length counts down to the frame end
+ */
+static void test_skip_len(void)
+{
+    static uint8_t payload[MAX_PAYLOAD_SIZE];
+    uint8_t frame[MAX_FRAME_SIZE];
+    uint8_t next[FRAME_OVERHEAD_BYTES];
+    const uint16_t payload_lens[] = {0, 1, 200, MAX_PAYLOAD_SIZE};
+    bus_node_t *node = &bus_nodes[0];
+
+    bus_init();
+
+    /* A whole frame for node 1 inside the payload, skipped with the rest of it */
+    packet_header_t inner = test_frame_header(HOST_TO_TARGET_CMD_GET_FW_VERSION, 1, 0);
+    size_t inner_len = test_frame_build(payload, &inner, NULL);
+
+    for (size_t i = inner_len; i < MAX_PAYLOAD_SIZE; i++)
+    {
+        payload[i] = (uint8_t)(i * 13);
+    }
+
+    for (size_t len_idx = 0; len_idx < sizeof(payload_lens) / sizeof(payload_lens[0]); len_idx++)
+    {
+        packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_GET_FW_VERSION, 2, payload_lens[len_idx]);
+        size_t frame_len = test_frame_build(frame, &header, payload);
+        size_t header_end = PREAMBLE_SIZE_BYTES + HEADER_SIZE_BYTES;
+        uint32_t unicast_cnt = node->unicast_cnt;
+
+        for (size_t idx = 0; idx < frame_len; idx++)
+        {
+            size_t budget = SIZE_MAX;
+
+            uart_mock_rx_write(node->port, &frame[idx], 1);
+            host_comm_rx_fsm_drain(&node->rx, &budget);
+
+            if ((idx + 1 >= header_end) && (idx + 1 < frame_len))
+            {
+                /* Header parsed: every byte left is dropped as it arrives */
+                TEST_CHECK(host_comm_rx_fsm_is_state_active(&node->rx, st_comm_rx_skip_proc));
+                TEST_CHECK(node->rx.iface.skip_len == frame_len - idx - 1);
+                TEST_CHECK(uart_get_rx_data_len(node->port) == 0);
+            }
+        }
+
+        TEST_CHECK(host_comm_rx_fsm_is_state_active(&node->rx, st_comm_rx_preamble_proc));
+        TEST_CHECK(uart_get_rx_data_len(node->port) == 0);
+
+        /* The frame right behind it is received */
+        header = test_frame_header(HOST_TO_TARGET_CMD_POLL, 1, 0);
+        uart_mock_rx_write(node->port, next, test_frame_build(next, &header, NULL));
+        bus_run();
+        TEST_CHECK(node->unicast_cnt == unicast_cnt + 1);
+        TEST_CHECK(node->last.header.type.cmd == HOST_TO_TARGET_CMD_POLL);
+        bus_host_len = 0;
+    }
+}
+
+/**
+ * @brief Random traffic for every node, in chunks that wrap around the rx rings
+ */
+static void test_bus_random(void)
+{
+    static uint8_t payload[MAX_PAYLOAD_SIZE];
+    uint8_t frame[MAX_FRAME_SIZE];
+    uint32_t unicast_sent[BUS_NODE_CNT] = {0};
+    uint32_t broadcast_sent = 0;
+    uint32_t acks = 0;
+    uint32_t seed = 0x1234567;
+
+    bus_init();
+
+    for (size_t i = 0; i < 2000; i++)
+    {
+        uint32_t pick = test_rand(&seed) % (BUS_NODE_CNT + 2);
+        uint8_t addr = (pick < BUS_NODE_CNT) ? (uint8_t)(pick + 1) : (pick == BUS_NODE_CNT) ? PROTOCOL_ADDR_BROADCAST : 0x40;
+        uint16_t payload_len = test_rand(&seed) % (RX_DATA_BUFF_SIZE / 2 - FRAME_OVERHEAD_BYTES);
+
+        for (size_t j = 0; j < payload_len; j++)
+        {
+            payload[j] = (uint8_t)test_rand(&seed);
+        }
+
+        packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_BAUDRATE_PROBE, addr, payload_len);
+        size_t frame_len = test_frame_build(frame, &header, payload);
+
+        /* Chunks as the DMA delivers them, the nodes run in between */
+        for (size_t idx = 0; idx < frame_len;)
+        {
+            size_t chunk = 1 + test_rand(&seed) % 64;
+
+            chunk = (chunk < frame_len - idx) ? chunk : (frame_len - idx);
+            bus_write(NULL, &frame[idx], chunk);
+            idx += chunk;
+            bus_run();
+        }
+
+        /* One ACK per unicast frame, from the node addressed */
+        acks += bus_host_take_acks();
+        unicast_sent[pick] += (pick < BUS_NODE_CNT);
+        broadcast_sent += (pick == BUS_NODE_CNT);
+    }
+
+    for (size_t node_idx = 0; node_idx < BUS_NODE_CNT; node_idx++)
+    {
+        TEST_CHECK(bus_nodes[node_idx].unicast_cnt == unicast_sent[node_idx]);
+        TEST_CHECK(bus_nodes[node_idx].broadcast_cnt == broadcast_sent);
+        TEST_CHECK(uart_get_rx_data_len(bus_nodes[node_idx].port) == 0);
+    }
+
+    TEST_CHECK(acks == unicast_sent[0] + unicast_sent[1] + unicast_sent[2]);
+}
+
+int main(void)
+{
+    TEST_RUN(test_check_addr);
+    TEST_RUN(test_bus_unicast);
+    TEST_RUN(test_bus_broadcast);
+    TEST_RUN(test_bus_foreign);
+    TEST_RUN(test_skip_len);
+    TEST_RUN(test_bus_random);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,558 @@
+/**
+ * @file test_circular_buffer.c
+ * @brief  Host tests of the circular buffer, built once per index mode (CIRCULAR_BUFF_POW2_MODE)
+ * @version 0.1
+ */
+
+#include "test.h"
+#include "circular_buffer.h"
+#include "pthread.h"
+#include "sched.h"
+#include "string.h"
+
+/**@brief Small buffer so the stress test wraps around all the time, not a power of two in modulo mode */
+#if CIRCULAR_BUFF_POW2_MODE
+#define STRESS_BUFF_SIZE    (64)
+#else
+#define STRESS_BUFF_SIZE    (61)
+#endif
+#define STRESS_BYTES        (4u * 1024u * 1024u)
+#define STRESS_RECORDS      (1024u * 1024u)
+#define RECORD_MAX_DATA     (40)
+
+/**
+ * @brief Single producer single consumer stress context
+ */
+typedef struct
+{
+    c_buff_handle_t cb;
+    uint32_t seed;
+    size_t errors;          /* bytes out of sequence, or buffer levels out of bounds */
+}stress_ctx_t;
+
+/**
+ * @brief Producer thread, writes a byte sequence in chunks of random length, alternating the
+ *        copy and the zero-copy (reserve/commit) API
+ */
+static void *stress_producer(void *arg)
+{
+    stress_ctx_t *ctx = arg;
+    uint8_t chunk[STRESS_BUFF_SIZE];
+    uint32_t seed = ctx->seed;
+    uint8_t seq = 0;
+    size_t sent = 0;
+
+    while (sent < STRESS_BYTES)
+    {
+        size_t len = 1 + test_rand(&seed) % (STRESS_BUFF_SIZE / 2);
+
+        len = (len > STRESS_BYTES - sent) ? (STRESS_BYTES - sent) : len;
+
+        if (circular_buff_get_data_len(ctx->cb) > circular_buff_capacity(ctx->cb))
+        {
+            ctx->errors++;
+        }
+
+        if (test_rand(&seed) & 1)
+        {
+            for (size_t i = 0; i < len; i++)
+            {
+                chunk[i] = (uint8_t)(seq + i);
+            }
+
+            if (circular_buff_write(ctx->cb, chunk, len) != CIRCULAR_BUFF_OK)
+            {
+                sched_yield();
+                continue;
+            }
+        }
+        else
+        {
+            circular_buff_region_t region[2];
+            size_t free_len = circular_buff_reserve(ctx->cb, region);
+
+            len = (len > free_len) ? free_len : len;
+
+            for (size_t i = 0; i < len; i++)
+            {
+                size_t r = (i < region[0].len) ? 0 : 1;
+                size_t pos = (r == 0) ? i : (i - region[0].len);
+
+                region[r].data[pos] = (uint8_t)(seq + i);
+            }
+
+            if (len == 0)
+            {
+                sched_yield();
+                continue;
+            }
+
+            circular_buff_commit_write(ctx->cb, len);
+        }
+
+        seq = (uint8_t)(seq + len);
+        sent += len;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Consumer thread, reads the byte sequence in chunks of random length, alternating the
+ *        copy and the zero-copy (peek/commit) API, and checks its order
+ */
+static void *stress_consumer(void *arg)
+{
+    stress_ctx_t *ctx = arg;
+    uint8_t chunk[STRESS_BUFF_SIZE];
+    uint32_t seed = ctx->seed ^ 0x5A5A5A5A;
+    uint8_t seq = 0;
+    size_t received = 0;
+
+    while (received < STRESS_BYTES)
+    {
+        size_t len = 1 + test_rand(&seed) % (STRESS_BUFF_SIZE / 2);
+
+        len = (len > STRESS_BYTES - received) ? (STRESS_BYTES - received) : len;
+
+        if (test_rand(&seed) & 1)
+        {
+            if (!circular_buff_read(ctx->cb, chunk, len))
+            {
+                sched_yield();
+                continue;
+            }
+        }
+        else
+        {
+            circular_buff_region_t region[2];
+            size_t data_len = circular_buff_peek(ctx->cb, region);
+
+            len = (len > data_len) ? data_len : len;
+
+            if (len == 0)
+            {
+                sched_yield();
+                continue;
+            }
+
+            for (size_t i = 0; i < len; i++)
+            {
+                chunk[i] = (i < region[0].len) ? region[0].data[i] : region[1].data[i - region[0].len];
+            }
+
+            circular_buff_commit_read(ctx->cb, len);
+        }
+
+        for (size_t i = 0; i < len; i++)
+        {
+            ctx->errors += (chunk[i] != (uint8_t)(seq + i));
+        }
+
+        seq = (uint8_t)(seq + len);
+        received += len;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Stream STRESS_BYTES through a buffer which indexes start at start_idx
+ */
+static size_t stress_run(size_t start_idx, uint32_t seed)
+{
+    static uint8_t buffer[STRESS_BUFF_SIZE];
+    circular_buff_t ctrl;
+    stress_ctx_t ctx = {.seed = seed};
+    pthread_t producer, consumer;
+
+    ctx.cb = circular_buff_init_static(&ctrl, buffer, STRESS_BUFF_SIZE);
+
+    /* White box: move both free running indexes close to their wraparound point */
+    atomic_store(&ctrl.head, start_idx);
+    atomic_store(&ctrl.tail, start_idx);
+
+    pthread_create(&consumer, NULL, stress_consumer, &ctx);
+    pthread_create(&producer, NULL, stress_producer, &ctx);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    TEST_CHECK(circular_buff_empty(ctx.cb));
+
+    return ctx.errors;
+}
+
+static void test_spsc_stress(void)
+{
+    TEST_CHECK(stress_run(0, 0x12345678) == 0);
+}
+
+static void test_spsc_stress_index_wrap(void)
+{
+    circular_buff_t ctrl;
+    uint8_t buffer[STRESS_BUFF_SIZE];
+
+    /* The wraparound limit depends on the mode, take it from an initialized buffer */
+    circular_buff_init_static(&ctrl, buffer, STRESS_BUFF_SIZE);
+#if CIRCULAR_BUFF_POW2_MODE
+    size_t start_idx = SIZE_MAX - 3 * STRESS_BUFF_SIZE;
+#else
+    size_t start_idx = ctrl.limit - 3 * STRESS_BUFF_SIZE;
+#endif
+
+    TEST_CHECK(stress_run(start_idx, 0x9E3779B9) == 0);
+}
+
+/**
+ * @brief Check fetch_at and the little-endian peeks at every offset of a buffer holding
+ *        data_len bytes of the sequence 0, 1, 2, ...
+ */
+static void fetch_at_check(c_buff_handle_t cb, size_t data_len)
+{
+    uint8_t data[STRESS_BUFF_SIZE];
+    uint16_t u16;
+    uint32_t u32;
+
+    for (size_t offset = 0; offset <= data_len; offset++)
+    {
+        size_t len = data_len - offset;
+
+        memset(data, 0xEE, sizeof(data));
+        TEST_CHECK(circular_buff_fetch_at(cb, offset, data, len));
+
+        for (size_t i = 0; i < len; i++)
+        {
+            TEST_CHECK(data[i] == (uint8_t)(offset + i));
+        }
+
+        /* One byte past the data, nothing is copied */
+        memset(data, 0xEE, sizeof(data));
+        TEST_CHECK(!circular_buff_fetch_at(cb, offset, data, len + 1));
+        TEST_CHECK(data[0] == 0xEE);
+
+        u16 = 0xEEEE;
+        TEST_CHECK(circular_buff_peek_u16_le(cb, offset, &u16) == (len >= sizeof(u16)));
+        TEST_CHECK((len < sizeof(u16)) ? (u16 == 0xEEEE) : (u16 == (uint16_t)((uint8_t)offset | ((uint8_t)(offset + 1) << 8))));
+
+        u32 = 0xEEEEEEEE;
+        TEST_CHECK(circular_buff_peek_u32_le(cb, offset, &u32) == (len >= sizeof(u32)));
+        TEST_CHECK((len < sizeof(u32)) ? (u32 == 0xEEEEEEEE) :
+                   (u32 == ((uint32_t)(uint8_t)offset | ((uint32_t)(uint8_t)(offset + 1) << 8) |
+                            ((uint32_t)(uint8_t)(offset + 2) << 16) | ((uint32_t)(uint8_t)(offset + 3) << 24))));
+    }
+
+    /* Offsets past the data, no overflow of offset + length */
+    TEST_CHECK(!circular_buff_fetch_at(cb, data_len + 1, data, 0));
+    TEST_CHECK(!circular_buff_fetch_at(cb, SIZE_MAX, data, 1));
+    TEST_CHECK(!circular_buff_fetch_at(cb, 1, data, SIZE_MAX));
+    TEST_CHECK(!circular_buff_peek_u32_le(cb, SIZE_MAX - 1, &u32));
+
+    /* Nothing is consumed */
+    TEST_CHECK(circular_buff_get_data_len(cb) == data_len);
+}
+
+static void test_fetch_at(void)
+{
+    uint8_t buffer[STRESS_BUFF_SIZE];
+    uint8_t data[STRESS_BUFF_SIZE];
+    uint8_t byte = 0;
+    circular_buff_t ctrl;
+    c_buff_handle_t cb = circular_buff_init_static(&ctrl, buffer, STRESS_BUFF_SIZE);
+
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)i;
+    }
+
+    /* Start at every position so the values straddle the end of the buffer at every byte */
+    for (size_t start = 0; start < STRESS_BUFF_SIZE; start++)
+    {
+        TEST_CHECK(circular_buff_write(cb, data, STRESS_BUFF_SIZE) == CIRCULAR_BUFF_OK);
+        fetch_at_check(cb, STRESS_BUFF_SIZE);
+        circular_buff_commit_read(cb, STRESS_BUFF_SIZE);
+
+        TEST_CHECK(circular_buff_write(cb, data, 7) == CIRCULAR_BUFF_OK);
+        fetch_at_check(cb, 7);
+        circular_buff_commit_read(cb, 7);
+
+        fetch_at_check(cb, 0);
+
+        /* Shift the start by one byte */
+        circular_buff_put(cb, byte);
+        circular_buff_get(cb, &byte);
+    }
+}
+
+static void test_fetch_at_index_wrap(void)
+{
+    uint8_t buffer[STRESS_BUFF_SIZE];
+    uint8_t data[STRESS_BUFF_SIZE];
+    circular_buff_t ctrl;
+    c_buff_handle_t cb = circular_buff_init_static(&ctrl, buffer, STRESS_BUFF_SIZE);
+
+    /* White box: the oldest byte sits just below the wraparound point of the free running indexes */
+#if CIRCULAR_BUFF_POW2_MODE
+    size_t start_idx = SIZE_MAX - 5;
+#else
+    size_t start_idx = ctrl.limit - 5;
+#endif
+
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)i;
+    }
+
+    atomic_store(&ctrl.head, start_idx);
+    atomic_store(&ctrl.tail, start_idx);
+
+    TEST_CHECK(circular_buff_write(cb, data, STRESS_BUFF_SIZE) == CIRCULAR_BUFF_OK);
+    fetch_at_check(cb, STRESS_BUFF_SIZE);
+}
+
+/**
+ * @brief Fill a record of a given sequence number, its content depends on the sequence and length
+ */
+static void record_fill(uint8_t *data, uint32_t seq, size_t len)
+{
+    memcpy(data, &seq, sizeof(seq));
+
+    for (size_t i = sizeof(seq); i < len; i++)
+    {
+        data[i] = (uint8_t)(seq * 31u + i);
+    }
+}
+
+/**
+ * @brief Check a record filled by record_fill(), return its sequence number
+ */
+static bool record_check(const uint8_t *data, size_t len, uint32_t *seq)
+{
+    if (len < sizeof(*seq))
+    {
+        return false;
+    }
+
+    memcpy(seq, data, sizeof(*seq));
+
+    for (size_t i = sizeof(*seq); i < len; i++)
+    {
+        if (data[i] != (uint8_t)(*seq * 31u + i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void test_record_roundtrip(void)
+{
+    uint8_t buffer[STRESS_BUFF_SIZE];
+    circular_buff_t ctrl;
+    c_buff_handle_t cb = circular_buff_init_static(&ctrl, buffer, STRESS_BUFF_SIZE);
+    uint8_t hdr[3] = {1, 2, 3}, body[20], data[32];
+    circular_buff_segment_t segment[2] = {{hdr, sizeof(hdr)}, {body, sizeof(body)}};
+    size_t data_len;
+
+    for (size_t i = 0; i < sizeof(body); i++)
+    {
+        body[i] = (uint8_t)(0x80 + i);
+    }
+
+    /* Enough rounds for the records to straddle the end of the buffer at every offset */
+    for (size_t round = 0; round < 3 * STRESS_BUFF_SIZE; round++)
+    {
+        TEST_CHECK(circular_buff_write_record(cb, segment, 2) == CIRCULAR_BUFF_OK);
+        TEST_CHECK(circular_buff_write_record(cb, NULL, 0) == CIRCULAR_BUFF_OK);
+        TEST_CHECK(circular_buff_get_data_len(cb) == 2 * CIRCULAR_BUFF_RECORD_HDR_SIZE + sizeof(hdr) + sizeof(body));
+
+        /* Fetched, then read: the segments come back concatenated */
+        TEST_CHECK(circular_buff_fetch_record(cb, data, sizeof(data), &data_len) && data_len == sizeof(hdr) + sizeof(body));
+        TEST_CHECK(circular_buff_read_record(cb, data, sizeof(data), &data_len) && data_len == sizeof(hdr) + sizeof(body));
+        TEST_CHECK(memcmp(data, hdr, sizeof(hdr)) == 0 && memcmp(&data[sizeof(hdr)], body, sizeof(body)) == 0);
+
+        /* Empty record */
+        TEST_CHECK(circular_buff_read_record(cb, data, sizeof(data), &data_len) && data_len == 0);
+        TEST_CHECK(!circular_buff_read_record(cb, data, sizeof(data), &data_len) && data_len == 0);
+
+        /* Shift the start by one byte */
+        circular_buff_put(cb, 0);
+        circular_buff_get(cb, data);
+    }
+}
+
+static void test_record_bounds(void)
+{
+    uint8_t buffer[STRESS_BUFF_SIZE];
+    circular_buff_t ctrl;
+    c_buff_handle_t cb = circular_buff_init_static(&ctrl, buffer, STRESS_BUFF_SIZE);
+    uint8_t data[STRESS_BUFF_SIZE] = {0};
+    circular_buff_segment_t segment = {data, STRESS_BUFF_SIZE - CIRCULAR_BUFF_RECORD_HDR_SIZE + 1};
+    circular_buff_stats_t stats;
+    size_t data_len;
+
+    /* Larger than the buffer: rejected even in overwrite mode */
+    TEST_CHECK(circular_buff_write_record(cb, &segment, 1) == CIRCUILAR_BUFF_NOT_ENOUGH_SPACE);
+    TEST_CHECK(circular_buff_overwrite_record(cb, &segment, 1) == CIRCUILAR_BUFF_NOT_ENOUGH_SPACE);
+    TEST_CHECK(circular_buff_empty(cb));
+
+    /* Exactly the buffer size: accepted */
+    segment.len--;
+    TEST_CHECK(circular_buff_write_record(cb, &segment, 1) == CIRCULAR_BUFF_OK);
+    TEST_CHECK(circular_buff_full(cb));
+
+    /* No space left and no overwrite: rejected, every rejection is counted */
+    segment.len = 1;
+    TEST_CHECK(circular_buff_write_record(cb, &segment, 1) == CIRCUILAR_BUFF_NOT_ENOUGH_SPACE);
+    circular_buff_get_stats(cb, &stats);
+    TEST_CHECK(stats.overflow_cnt == 3);
+
+    /* Too small to be read: left in the buffer, the size needed is reported */
+    TEST_CHECK(!circular_buff_read_record(cb, data, 4, &data_len));
+    TEST_CHECK(data_len == STRESS_BUFF_SIZE - CIRCULAR_BUFF_RECORD_HDR_SIZE);
+    TEST_CHECK(circular_buff_full(cb));
+    TEST_CHECK(circular_buff_read_record(cb, data, sizeof(data), &data_len));
+    TEST_CHECK(circular_buff_empty(cb));
+}
+
+static void test_record_overwrite(void)
+{
+    uint8_t buffer[STRESS_BUFF_SIZE];
+    circular_buff_t ctrl;
+    c_buff_handle_t cb = circular_buff_init_static(&ctrl, buffer, STRESS_BUFF_SIZE);
+    uint8_t data[STRESS_BUFF_SIZE];
+    circular_buff_segment_t segment = {data, 0};
+    circular_buff_stats_t stats;
+    size_t data_len, rec_cnt = 0;
+    uint32_t seq;
+
+    /* Fill with 10 byte records (12 bytes each) */
+    for (seq = 0; circular_buff_get_free_space(cb) >= 12; seq++)
+    {
+        record_fill(data, seq, 10);
+        segment.len = 10;
+        TEST_CHECK(circular_buff_overwrite_record(cb, &segment, 1) == CIRCULAR_BUFF_OK);
+        rec_cnt++;
+    }
+
+    /* A 30 byte record (32 bytes) drops the oldest whole records until it fits */
+    size_t free_space = circular_buff_get_free_space(cb);
+    size_t dropped = (32 - free_space + 11) / 12;
+
+    record_fill(data, seq, 30);
+    segment.len = 30;
+    TEST_CHECK(circular_buff_overwrite_record(cb, &segment, 1) == CIRCULAR_BUFF_OK);
+
+    circular_buff_get_stats(cb, &stats);
+    TEST_CHECK(stats.records_dropped == dropped);
+    TEST_CHECK(stats.bytes_dropped == dropped * 12);
+    TEST_CHECK(stats.overflow_cnt == 0);
+
+    /* What is left is whole: the newest 10 byte records in order, then the 30 byte record */
+    for (uint32_t expected = dropped; expected < rec_cnt; expected++)
+    {
+        TEST_CHECK(circular_buff_read_record(cb, data, sizeof(data), &data_len) && data_len == 10);
+        TEST_CHECK(record_check(data, data_len, &seq) && seq == expected);
+    }
+
+    TEST_CHECK(circular_buff_read_record(cb, data, sizeof(data), &data_len) && data_len == 30);
+    TEST_CHECK(record_check(data, data_len, &seq) && seq == rec_cnt);
+    TEST_CHECK(circular_buff_empty(cb));
+}
+
+/**
+ * @brief Record overwrite stress context, the producer never waits and drops the oldest records
+ */
+typedef struct
+{
+    c_buff_handle_t cb;
+    atomic_bool done;
+    size_t received;
+    size_t errors;          /* torn records, or records out of order */
+}record_stress_ctx_t;
+
+static void *record_stress_producer(void *arg)
+{
+    record_stress_ctx_t *ctx = arg;
+    uint8_t data[RECORD_MAX_DATA];
+    uint32_t seed = 0xC0FFEE;
+
+    for (uint32_t seq = 0; seq < STRESS_RECORDS; seq++)
+    {
+        size_t len = sizeof(seq) + test_rand(&seed) % (RECORD_MAX_DATA - sizeof(seq) + 1);
+        circular_buff_segment_t segment = {data, len};
+
+        record_fill(data, seq, len);
+        ctx->errors += (circular_buff_overwrite_record(ctx->cb, &segment, 1) != CIRCULAR_BUFF_OK);
+    }
+
+    atomic_store(&ctx->done, true);
+    return NULL;
+}
+
+static void *record_stress_consumer(void *arg)
+{
+    record_stress_ctx_t *ctx = arg;
+    uint8_t data[RECORD_MAX_DATA];
+    uint32_t last_seq = UINT32_MAX, seq = 0;
+    size_t data_len;
+
+    for (;;)
+    {
+        bool done = atomic_load(&ctx->done);
+
+        if (circular_buff_read_record(ctx->cb, data, sizeof(data), &data_len))
+        {
+            /* Records may be missing (dropped), never torn, duplicated or reordered */
+            ctx->errors += !record_check(data, data_len, &seq);
+            ctx->errors += (last_seq != UINT32_MAX) && (seq <= last_seq);
+            last_seq = seq;
+            ctx->received++;
+        }
+        else if (done)
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static void test_record_overwrite_stress(void)
+{
+    static uint8_t buffer[STRESS_BUFF_SIZE];
+    circular_buff_t ctrl;
+    circular_buff_stats_t stats;
+    record_stress_ctx_t ctx = {0};
+    pthread_t producer, consumer;
+
+    ctx.cb = circular_buff_init_static(&ctrl, buffer, STRESS_BUFF_SIZE);
+    atomic_init(&ctx.done, false);
+
+    pthread_create(&consumer, NULL, record_stress_consumer, &ctx);
+    pthread_create(&producer, NULL, record_stress_producer, &ctx);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    /* Every record written was either received or counted as dropped */
+    circular_buff_get_stats(ctx.cb, &stats);
+    TEST_CHECK(ctx.errors == 0);
+    TEST_CHECK(ctx.received + stats.records_dropped == STRESS_RECORDS);
+    TEST_CHECK(ctx.received > 0 && stats.records_dropped > 0);
+}
+
+int main(void)
+{
+    printf("circular buffer, %s index mode\n", CIRCULAR_BUFF_POW2_MODE ? "power-of-two" : "modulo");
+
+    TEST_RUN(test_spsc_stress);
+    TEST_RUN(test_spsc_stress_index_wrap);
+    TEST_RUN(test_fetch_at);
+    TEST_RUN(test_fetch_at_index_wrap);
+    TEST_RUN(test_record_roundtrip);
+    TEST_RUN(test_record_bounds);
+    TEST_RUN(test_record_overwrite);
+    TEST_RUN(test_record_overwrite_stress);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,231 @@
+/**
+ * @file test_circular_queue.c
+ * @brief  Host tests of the type-generic circular queue (CIRCULAR_QUEUE_DECLARE)
+ * @version 0.1
+ */
+
+#include "test.h"
+#include "circular_queue.h"
+#include "pthread.h"
+#include "sched.h"
+#include "string.h"
+
+#define TEST_QUEUE_SIZE     (8)
+#define STRESS_ITEMS        (2u * 1024u * 1024u)
+
+/**
+ * @brief Queue element, larger than a machine word so a torn copy is detected
+ */
+typedef struct
+{
+    uint32_t seq;
+    uint32_t check;         /* ~seq */
+    uint8_t pad[24];
+}test_item_t;
+
+CIRCULAR_QUEUE_DECLARE(test_queue, test_item_t, TEST_QUEUE_SIZE)
+
+static test_item_t item_make(uint32_t seq)
+{
+    test_item_t item = {.seq = seq, .check = ~seq};
+
+    for (size_t i = 0; i < sizeof(item.pad); i++)
+    {
+        item.pad[i] = (uint8_t)(seq + i);
+    }
+
+    return item;
+}
+
+static bool item_is_valid(const test_item_t *item, uint32_t seq)
+{
+    test_item_t expected = item_make(seq);
+
+    return (item->seq == expected.seq) && (item->check == expected.check) &&
+           (memcmp(item->pad, expected.pad, sizeof(item->pad)) == 0);
+}
+
+static void test_fill_and_drain(void)
+{
+    test_queue_t queue;
+    test_item_t item;
+
+    test_queue_init(&queue);
+    TEST_CHECK(test_queue_empty(&queue));
+    TEST_CHECK(test_queue_peek(&queue) == NULL);
+    TEST_CHECK(!test_queue_pop(&queue, &item));
+
+    for (uint32_t seq = 0; seq < TEST_QUEUE_SIZE; seq++)
+    {
+        item = item_make(seq);
+        TEST_CHECK(test_queue_push(&queue, &item));
+        TEST_CHECK(test_queue_count(&queue) == seq + 1);
+    }
+
+    /* Full: rejected, the queue is left untouched */
+    item = item_make(TEST_QUEUE_SIZE);
+    TEST_CHECK(test_queue_full(&queue));
+    TEST_CHECK(!test_queue_push(&queue, &item));
+    TEST_CHECK(test_queue_count(&queue) == TEST_QUEUE_SIZE);
+
+    for (uint32_t seq = 0; seq < TEST_QUEUE_SIZE; seq++)
+    {
+        TEST_CHECK(test_queue_pop(&queue, &item));
+        TEST_CHECK(item_is_valid(&item, seq));
+    }
+
+    TEST_CHECK(test_queue_empty(&queue));
+}
+
+static void test_peek_at_and_drop(void)
+{
+    test_queue_t queue;
+    test_item_t item;
+
+    test_queue_init(&queue);
+
+    for (uint32_t seq = 0; seq < 5; seq++)
+    {
+        item = item_make(seq);
+        test_queue_push(&queue, &item);
+    }
+
+    for (size_t idx = 0; idx < 5; idx++)
+    {
+        TEST_CHECK(test_queue_peek_at(&queue, idx) != NULL && item_is_valid(test_queue_peek_at(&queue, idx), idx));
+    }
+    TEST_CHECK(test_queue_peek_at(&queue, 5) == NULL);
+
+    /* The oldest element is peeked in place and dropped, the rest shifts by one */
+    TEST_CHECK(test_queue_peek(&queue) == test_queue_peek_at(&queue, 0));
+    test_queue_drop(&queue);
+    TEST_CHECK(item_is_valid(test_queue_peek(&queue), 1));
+    TEST_CHECK(item_is_valid(test_queue_peek_at(&queue, 3), 4));
+    TEST_CHECK(test_queue_peek_at(&queue, 4) == NULL);
+}
+
+static void test_index_wrap(void)
+{
+    test_queue_t queue;
+    test_item_t item;
+    uint32_t pushed = 0, popped = 0;
+
+    /* White box: free running indexes just below their wraparound point */
+    test_queue_init(&queue);
+    atomic_store(&queue.head, SIZE_MAX - 3);
+    atomic_store(&queue.tail, SIZE_MAX - 3);
+
+    for (size_t round = 0; round < 4 * TEST_QUEUE_SIZE; round++)
+    {
+        while (!test_queue_full(&queue))
+        {
+            item = item_make(pushed++);
+            test_queue_push(&queue, &item);
+        }
+
+        TEST_CHECK(test_queue_count(&queue) == TEST_QUEUE_SIZE);
+        TEST_CHECK(item_is_valid(test_queue_peek_at(&queue, TEST_QUEUE_SIZE - 1), pushed - 1));
+
+        /* Drain a varying amount so head and tail cross the wraparound at different times */
+        for (size_t i = 0; i <= round % TEST_QUEUE_SIZE; i++)
+        {
+            TEST_CHECK(test_queue_pop(&queue, &item) && item_is_valid(&item, popped++));
+        }
+    }
+}
+
+/**
+ * @brief Pointer elements need a typedef, the push argument is a pointer to a const element
+ */
+typedef test_item_t *test_item_handle_t;
+CIRCULAR_QUEUE_DECLARE(test_handle_queue, test_item_handle_t, 4)
+
+static void test_pointer_elements(void)
+{
+    test_handle_queue_t queue;
+    test_item_t items[4];
+    test_item_handle_t handle;
+
+    test_handle_queue_init(&queue);
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        handle = &items[i];
+        TEST_CHECK(test_handle_queue_push(&queue, &handle));
+    }
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        TEST_CHECK(test_handle_queue_pop(&queue, &handle) && handle == &items[i]);
+    }
+}
+
+static test_queue_t stress_queue;
+
+static void *stress_producer(void *arg)
+{
+    (void)arg;
+
+    for (uint32_t seq = 0; seq < STRESS_ITEMS;)
+    {
+        test_item_t item = item_make(seq);
+
+        if (test_queue_push(&stress_queue, &item))
+        {
+            seq++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void *stress_consumer(void *arg)
+{
+    size_t *errors = arg;
+    test_item_t item;
+
+    for (uint32_t seq = 0; seq < STRESS_ITEMS;)
+    {
+        if (test_queue_pop(&stress_queue, &item))
+        {
+            *errors += !item_is_valid(&item, seq++);
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void test_spsc_stress(void)
+{
+    pthread_t producer, consumer;
+    size_t errors = 0;
+
+    test_queue_init(&stress_queue);
+
+    pthread_create(&consumer, NULL, stress_consumer, &errors);
+    pthread_create(&producer, NULL, stress_producer, NULL);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    TEST_CHECK(errors == 0);
+    TEST_CHECK(test_queue_empty(&stress_queue));
+}
+
+int main(void)
+{
+    TEST_RUN(test_fill_and_drain);
+    TEST_RUN(test_peek_at_and_drop);
+    TEST_RUN(test_index_wrap);
+    TEST_RUN(test_pointer_elements);
+    TEST_RUN(test_spsc_stress);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,194 @@
+/**
+ * @file test_cmd_dispatch.c
+ * @brief  Host tests of the command dispatch table of the communication ports
+ * @version 0.1
+ *
+ * @note   Frames are written into the rx ring of a mock port and the ports are run, see
+ *         mock/uart_mock.h. Port 2 is a point to point link, port 1 is node 1 of a bus
+ *         (HOST_COMM_PORT_1_NODE_ADDR is set from the build).
+ */
+
+#include "test.h"
+#include "test_frame.h"
+#include "uart_mock.h"
+#include "host_comm_port.h"
+
+#define PORT_RUNS           (8)     /* runs of the ports for a frame to be answered */
+#define PORT_FRAMES_MAX     (4)
+
+_Static_assert(HOST_COMM_PORT_1_NODE_ADDR == 1, "port 1 must be node 1 of a bus");
+
+/*@brief Calls of the test handler */
+static uint32_t handler_calls;
+static uint16_t handler_last_len;
+
+static void test_handler(host_comm_port_t *port, packet_data_t *packet)
+{
+    (void)port;
+    handler_calls++;
+    handler_last_len = packet->header.payload_len;
+}
+
+/**@brief Frames answered by a port */
+typedef struct
+{
+    size_t cnt;
+    packet_header_t header[PORT_FRAMES_MAX];
+    uint8_t payload[PORT_FRAMES_MAX][MAX_PAYLOAD_SIZE];
+}port_answer_t;
+
+/**
+ * @brief Send a host to target frame to a port, run the ports and decode the frames answered
+ */
+static void port_send(uart_port_id_t id, uint8_t cmd, uint8_t addr, uint16_t payload_len, port_answer_t *answer)
+{
+    static uint8_t payload[MAX_PAYLOAD_SIZE];
+    static uint8_t data[TX_DATA_BUFF_SIZE];
+    uint8_t frame[MAX_FRAME_SIZE];
+    packet_header_t header = test_frame_header(cmd, addr, payload_len);
+    uart_port_t *uart = uart_get_port(id);
+    size_t len = 0;
+
+    for (size_t i = 0; i < payload_len; i++)
+    {
+        payload[i] = (uint8_t)(i + 1);
+    }
+
+    TEST_CHECK(uart_mock_rx_write(uart, frame, test_frame_build(frame, &header, payload)) > 0);
+
+    for (size_t run = 0; run < PORT_RUNS; run++)
+    {
+        host_comm_port_run();
+        len += uart_mock_tx_read(uart, &data[len], sizeof(data) - len);
+    }
+
+    answer->cnt = 0;
+
+    for (size_t idx = 0; idx < len;)
+    {
+        size_t frame_len = 0;
+
+        if (answer->cnt < PORT_FRAMES_MAX)
+        {
+            frame_len = test_frame_decode(&data[idx], len - idx, &answer->header[answer->cnt], answer->payload[answer->cnt]);
+        }
+
+        TEST_CHECK(frame_len > 0);
+        idx += (frame_len > 0) ? frame_len : len;
+        answer->cnt++;
+    }
+}
+
+/**
+ * @brief Check the frame answered in a given position is a handler error of a type
+ */
+static bool is_handler_error(const port_answer_t *answer, size_t idx, uint8_t type)
+{
+    return (answer->cnt > idx) && (answer->header[idx].type.evt == TARGET_TO_HOST_EVT_HANDLER_ERROR) &&
+           (answer->header[idx].payload_len == 1) && (answer->payload[idx][0] == type);
+}
+
+static void test_unknown_type(void)
+{
+    static port_answer_t answer;
+    host_comm_port_t *port = host_comm_port_get(UART_PORT_2);
+    uint32_t rejected_cnt = port->cmd.rejected_cnt;
+    uint32_t handled_cnt = port->cmd.handled_cnt;
+
+    /* Valid frame, no handler registered for its type: ACK, then the error with the type */
+    port_send(UART_PORT_2, HOST_TO_TARGET_CMD_TURN_ON_LED, PROTOCOL_ADDR_P2P, 0, &answer);
+    TEST_CHECK(answer.cnt == 2 && answer.header[0].type.res == TARGET_TO_HOST_RES_ACK);
+    TEST_CHECK(is_handler_error(&answer, 1, HOST_TO_TARGET_CMD_TURN_ON_LED));
+    TEST_CHECK(port->cmd.rejected_cnt == rejected_cnt + 1 && port->cmd.handled_cnt == handled_cnt);
+}
+
+static void test_payload_len_bounds(void)
+{
+    static port_answer_t answer;
+    host_comm_port_t *port = host_comm_port_get(UART_PORT_2);
+
+    TEST_CHECK(host_comm_port_register_cmd(HOST_TO_TARGET_CMD_TURN_OFF_LED, test_handler, 2, 4, HOST_COMM_CMD_FLAG_NONE));
+
+    /* Bounds not valid, the entry registered stays */
+    TEST_CHECK(!host_comm_port_register_cmd(HOST_TO_TARGET_CMD_TURN_OFF_LED, test_handler, 5, 4, HOST_COMM_CMD_FLAG_NONE));
+    TEST_CHECK(!host_comm_port_register_cmd(HOST_TO_TARGET_CMD_TURN_OFF_LED, test_handler, 0, MAX_PAYLOAD_SIZE + 1, HOST_COMM_CMD_FLAG_NONE));
+
+    for (uint16_t len = 0; len <= 5; len++)
+    {
+        uint32_t rejected_cnt = port->cmd.rejected_cnt;
+        uint32_t handled_cnt = port->cmd.handled_cnt;
+        uint32_t calls = handler_calls;
+        bool in_bounds = (len >= 2) && (len <= 4);
+
+        port_send(UART_PORT_2, HOST_TO_TARGET_CMD_TURN_OFF_LED, PROTOCOL_ADDR_P2P, len, &answer);
+        TEST_CHECK(answer.cnt >= 1 && answer.header[0].type.res == TARGET_TO_HOST_RES_ACK);
+
+        if (in_bounds)
+        {
+            TEST_CHECK(handler_calls == calls + 1 && handler_last_len == len);
+            TEST_CHECK(port->cmd.handled_cnt == handled_cnt + 1 && port->cmd.rejected_cnt == rejected_cnt);
+            TEST_CHECK(answer.cnt == 1);
+        }
+        else
+        {
+            TEST_CHECK(handler_calls == calls);
+            TEST_CHECK(port->cmd.rejected_cnt == rejected_cnt + 1 && port->cmd.handled_cnt == handled_cnt);
+            TEST_CHECK(answer.cnt == 2 && is_handler_error(&answer, 1, HOST_TO_TARGET_CMD_TURN_OFF_LED));
+        }
+    }
+
+    /* Built-in entry: a baudrate request shorter than the baudrate is not handed to its handler */
+    port_send(UART_PORT_2, HOST_TO_TARGET_CMD_SET_BAUDRATE, PROTOCOL_ADDR_P2P, sizeof(uint32_t) - 1, &answer);
+    TEST_CHECK(is_handler_error(&answer, 1, HOST_TO_TARGET_CMD_SET_BAUDRATE));
+    TEST_CHECK(port->baudrate.state == BAUDRATE_ST_IDLE);
+}
+
+static void test_broadcast(void)
+{
+    static port_answer_t answer;
+    host_comm_port_t *port = host_comm_port_get(UART_PORT_1);
+    uint32_t rejected_cnt = port->cmd.rejected_cnt;
+    uint32_t handled_cnt = port->cmd.handled_cnt;
+    uint32_t calls = handler_calls;
+
+    /* Handler without the broadcast flag: dropped, never answered */
+    TEST_CHECK(host_comm_port_register_cmd(HOST_TO_TARGET_CMD_GET_FW_VERSION, test_handler, 0, 0, HOST_COMM_CMD_FLAG_NONE));
+    port_send(UART_PORT_1, HOST_TO_TARGET_CMD_GET_FW_VERSION, PROTOCOL_ADDR_BROADCAST, 0, &answer);
+    TEST_CHECK(answer.cnt == 0 && handler_calls == calls);
+    TEST_CHECK(port->cmd.rejected_cnt == rejected_cnt + 1 && port->cmd.handled_cnt == handled_cnt);
+
+    /* Out of the payload bounds or without handler: dropped, never answered */
+    port_send(UART_PORT_1, HOST_TO_TARGET_CMD_TURN_OFF_LED, PROTOCOL_ADDR_BROADCAST, 1, &answer);
+    TEST_CHECK(answer.cnt == 0);
+    port_send(UART_PORT_1, HOST_TO_TARGET_CMD_TURN_ON_LED, PROTOCOL_ADDR_BROADCAST, 0, &answer);
+    TEST_CHECK(answer.cnt == 0);
+    TEST_CHECK(port->cmd.rejected_cnt == rejected_cnt + 3 && handler_calls == calls);
+
+    /* The same handler is unicast: ACK from node 1 */
+    port_send(UART_PORT_1, HOST_TO_TARGET_CMD_GET_FW_VERSION, 1, 0, &answer);
+    TEST_CHECK(answer.cnt == 1 && answer.header[0].type.res == TARGET_TO_HOST_RES_ACK && answer.header[0].addr == 1);
+    TEST_CHECK(handler_calls == calls + 1 && port->cmd.handled_cnt == handled_cnt + 1);
+
+    /* Handler with the broadcast flag: handled, not answered */
+    TEST_CHECK(host_comm_port_register_cmd(HOST_TO_TARGET_CMD_GET_FW_VERSION, test_handler, 0, 0, HOST_COMM_CMD_FLAG_BROADCAST));
+    port_send(UART_PORT_1, HOST_TO_TARGET_CMD_GET_FW_VERSION, PROTOCOL_ADDR_BROADCAST, 0, &answer);
+    TEST_CHECK(answer.cnt == 0 && handler_calls == calls + 2);
+    TEST_CHECK(port->cmd.handled_cnt == handled_cnt + 2 && port->cmd.rejected_cnt == rejected_cnt + 3);
+
+    /* Frame for another node: not even dispatched */
+    port_send(UART_PORT_1, HOST_TO_TARGET_CMD_GET_FW_VERSION, 2, 0, &answer);
+    TEST_CHECK(answer.cnt == 0 && handler_calls == calls + 2);
+    TEST_CHECK(port->cmd.handled_cnt == handled_cnt + 2 && port->cmd.rejected_cnt == rejected_cnt + 3);
+}
+
+int main(void)
+{
+    uart_init();
+    host_comm_port_init();
+
+    TEST_RUN(test_unknown_type);
+    TEST_RUN(test_payload_len_bounds);
+    TEST_RUN(test_broadcast);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,112 @@
+/**
+ * @file test_frame.h
+ * @brief  Frame building helpers of the host tests
+ * @version 0.1
+ *
+ * @note   Frames are laid out as the target expects them on the wire: preamble, header struct,
+ *         payload, crc of header and payload, postamble.
+ */
+
+#ifndef _TEST_FRAME_H
+#define _TEST_FRAME_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "string.h"
+#include "protocol.h"
+
+/**
+ * @brief Fill a header of a host to target command
+ */
+static inline packet_header_t test_frame_header(uint8_t cmd, uint8_t addr, uint16_t payload_len)
+{
+    packet_header_t header;
+
+    /* Padding bytes are sent too, keep them deterministic */
+    memset(&header, 0, sizeof(header));
+    header.type.cmd = cmd;
+    header.addr = addr;
+    header.dir = HOST_TO_TARGET;
+    header.payload_len = payload_len;
+
+    return header;
+}
+
+/**
+ * @brief Build a frame in a buffer of at least MAX_FRAME_SIZE bytes
+ *
+ * @param frame   buffer the frame is written to
+ * @param header  frame header, header->payload_len bytes are taken from payload
+ * @param payload payload bytes, may be NULL when header->payload_len is 0
+ * @return size_t frame length
+ */
+static inline size_t test_frame_build(uint8_t *frame, const packet_header_t *header, const uint8_t *payload)
+{
+    uint32_t crc = 0;
+    size_t len = 0;
+
+    memcpy(&frame[len], protocol_preamble.bit, PREAMBLE_SIZE_BYTES);
+    len += PREAMBLE_SIZE_BYTES;
+    memcpy(&frame[len], header, HEADER_SIZE_BYTES);
+    len += HEADER_SIZE_BYTES;
+
+    if ((header->payload_len > 0) && (payload != NULL))
+    {
+        memcpy(&frame[len], payload, header->payload_len);
+        len += header->payload_len;
+    }
+
+    crc32_accumulate(&frame[PREAMBLE_SIZE_BYTES], len - PREAMBLE_SIZE_BYTES, &crc);
+    memcpy(&frame[len], &crc, CRC_SIZE_BYTES);
+    len += CRC_SIZE_BYTES;
+    memcpy(&frame[len], protocol_postamble.bit, POSTAMBLE_SIZE_BYTES);
+    len += POSTAMBLE_SIZE_BYTES;
+
+    return len;
+}
+
+/**
+ * @brief Decode a frame sent by the target, as the host does
+ *
+ * @param data    received bytes, the frame must start at data
+ * @param len     number of bytes received
+ * @param header  set to the frame header
+ * @param payload set to the payload bytes, may be NULL
+ * @return size_t frame length, 0 if no valid frame starts at data
+ */
+static inline size_t test_frame_decode(const uint8_t *data, size_t len, packet_header_t *header, uint8_t *payload)
+{
+    uint32_t crc = 0;
+
+    memset(header, 0, sizeof(*header));
+
+    if ((len < FRAME_OVERHEAD_BYTES) || (memcmp(data, protocol_preamble.bit, PREAMBLE_SIZE_BYTES) != 0))
+    {
+        return 0;
+    }
+
+    memcpy(header, &data[PREAMBLE_SIZE_BYTES], HEADER_SIZE_BYTES);
+
+    size_t crc_idx = PREAMBLE_SIZE_BYTES + HEADER_SIZE_BYTES + header->payload_len;
+
+    if ((header->payload_len > MAX_PAYLOAD_SIZE) || (FRAME_OVERHEAD_BYTES + header->payload_len > len))
+    {
+        return 0;
+    }
+
+    crc32_accumulate(&data[PREAMBLE_SIZE_BYTES], crc_idx - PREAMBLE_SIZE_BYTES, &crc);
+
+    if ((memcmp(&data[crc_idx], &crc, CRC_SIZE_BYTES) != 0) ||
+        (memcmp(&data[crc_idx + CRC_SIZE_BYTES], protocol_postamble.bit, POSTAMBLE_SIZE_BYTES) != 0))
+    {
+        return 0;
+    }
+
+    if (payload != NULL)
+    {
+        memcpy(payload, &data[PREAMBLE_SIZE_BYTES + HEADER_SIZE_BYTES], header->payload_len);
+    }
+
+    return FRAME_OVERHEAD_BYTES + header->payload_len;
+}
+
+#endif
@@ -0,0 +1,365 @@
+/**
+ * @file test_frame_parser.c
+ * @brief  Host tests of the streaming frame parser, its resync length and the frame loss under
+ *         bit errors
+ * @version 0.1
+ *
+ * @note   The bit error harness runs a model of the rx fsm receive path over a stream of frames
+ *         with bit errors injected: preamble hunt at every byte offset, then the frame parser and
+ *         the header check. A rejected frame is either discarded as a whole (the hunt before the
+ *         rescan) or hunted again from one byte after its preamble (the rx fsm rescan).
+ */
+
+#include "test.h"
+#include "test_frame.h"
+#include "frame_parser.h"
+#include "stdlib.h"
+
+#define BER_FRAMES          (20000u)
+#define BER_MAX_GAP         (8)
+#define BER_MIN_PAYLOAD     (16)
+#define BER_MAX_PAYLOAD     (64)
+#define BER_STREAM_SIZE     (BER_FRAMES * (BER_MAX_GAP + FRAME_OVERHEAD_BYTES + BER_MAX_PAYLOAD))
+
+static packet_data_t packet;
+
+/**
+ * @brief Feed bytes to the parser in chunks until a verdict, return it
+ *
+ * @param consumed set to the number of bytes parsed
+ */
+static frame_parser_result_t parse(frame_parser_t *parser, const uint8_t *data, size_t len, size_t chunk, size_t *consumed)
+{
+    frame_parser_result_t result = FRAME_PARSER_MORE;
+    size_t idx = 0;
+
+    while (idx < len)
+    {
+        size_t feed_len = (len - idx < chunk) ? (len - idx) : chunk;
+        size_t feed_consumed;
+
+        result = frame_parser_feed(parser, &data[idx], feed_len, &feed_consumed);
+        idx += feed_consumed;
+
+        if ((result != FRAME_PARSER_MORE) && (result != FRAME_PARSER_HEADER_DONE) && (result != FRAME_PARSER_PAYLOAD_DONE))
+        {
+            break;
+        }
+    }
+
+    *consumed = idx;
+    return result;
+}
+
+static void test_verdicts(void)
+{
+    static uint8_t frame[MAX_FRAME_SIZE];
+    uint8_t payload[40];
+    frame_parser_t parser;
+    size_t consumed;
+
+    for (size_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8_t)(0xA0 + i);
+    }
+
+    packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_TURN_ON_LED, PROTOCOL_ADDR_P2P, sizeof(payload));
+    size_t frame_len = test_frame_build(frame, &header, payload);
+    const uint8_t *body = &frame[PREAMBLE_SIZE_BYTES];
+    size_t body_len = frame_len - PREAMBLE_SIZE_BYTES;
+
+    frame_parser_init(&parser, &packet);
+
+    /* The parser stops at every field boundary */
+    frame_parser_start(&parser);
+    TEST_CHECK(frame_parser_feed(&parser, body, body_len, &consumed) == FRAME_PARSER_HEADER_DONE && consumed == HEADER_SIZE_BYTES);
+    TEST_CHECK(frame_parser_feed(&parser, &body[HEADER_SIZE_BYTES], body_len, &consumed) == FRAME_PARSER_PAYLOAD_DONE &&
+               consumed == sizeof(payload));
+
+    for (size_t chunk = 1; chunk <= body_len; chunk++)
+    {
+        frame_parser_start(&parser);
+        TEST_CHECK(parse(&parser, body, body_len, chunk, &consumed) == FRAME_PARSER_FRAME_OK && consumed == body_len);
+        TEST_CHECK(memcmp(&packet.header, &header, HEADER_SIZE_BYTES) == 0);
+        TEST_CHECK(memcmp(packet.payload.buffer, payload, sizeof(payload)) == 0);
+
+        /* Nothing is consumed once the verdict is given */
+        TEST_CHECK(frame_parser_feed(&parser, body, body_len, &consumed) == FRAME_PARSER_MORE && consumed == 0);
+    }
+
+    /* Empty payload */
+    header.payload_len = 0;
+    frame_len = test_frame_build(frame, &header, NULL);
+    frame_parser_start(&parser);
+    TEST_CHECK(parse(&parser, body, frame_len - PREAMBLE_SIZE_BYTES, 3, &consumed) == FRAME_PARSER_FRAME_OK);
+}
+
+static void test_errors(void)
+{
+    static uint8_t frame[MAX_FRAME_SIZE];
+    uint8_t payload[10] = {0};
+    frame_parser_t parser;
+    size_t consumed;
+    packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_TURN_ON_LED, PROTOCOL_ADDR_P2P, sizeof(payload));
+    size_t frame_len = test_frame_build(frame, &header, payload);
+    const uint8_t *body = &frame[PREAMBLE_SIZE_BYTES];
+    size_t body_len = frame_len - PREAMBLE_SIZE_BYTES;
+
+    frame_parser_init(&parser, &packet);
+
+    /* Payload bit flipped: the verdict comes with the last postamble byte */
+    frame[PREAMBLE_SIZE_BYTES + HEADER_SIZE_BYTES + 3] ^= 0x10;
+    frame_parser_start(&parser);
+    TEST_CHECK(parse(&parser, body, body_len, 5, &consumed) == FRAME_PARSER_CRC_ERROR && consumed == body_len);
+    frame[PREAMBLE_SIZE_BYTES + HEADER_SIZE_BYTES + 3] ^= 0x10;
+
+    /* Postamble byte wrong: rejected at that byte, which is not consumed */
+    for (size_t i = 0; i < POSTAMBLE_SIZE_BYTES; i++)
+    {
+        frame[frame_len - POSTAMBLE_SIZE_BYTES + i] ^= 0xFF;
+        frame_parser_start(&parser);
+        TEST_CHECK(parse(&parser, body, body_len, body_len, &consumed) == FRAME_PARSER_POSTAMBLE_ERROR);
+        TEST_CHECK(consumed == body_len - POSTAMBLE_SIZE_BYTES + i);
+        frame[frame_len - POSTAMBLE_SIZE_BYTES + i] ^= 0xFF;
+    }
+}
+
+/**
+ * @brief Brute force resync length: bytes, from the 2nd preamble byte, where no preamble starts
+ *        entirely inside the frame bytes parsed
+ *
+ * @param frame    frame bytes, starting with its preamble
+ * @param frame_len number of frame bytes parsed, preamble included
+ */
+static size_t resync_len_brute_force(const uint8_t *frame, size_t frame_len)
+{
+    for (size_t start = 1; start + PREAMBLE_SIZE_BYTES <= frame_len; start++)
+    {
+        if (memcmp(&frame[start], protocol_preamble.bit, PREAMBLE_SIZE_BYTES) == 0)
+        {
+            return start - 1;
+        }
+    }
+
+    return frame_len - PREAMBLE_SIZE_BYTES;
+}
+
+static void test_resync_len(void)
+{
+    static uint8_t frame[PREAMBLE_SIZE_BYTES + MAX_FRAME_SIZE];
+    frame_parser_t parser;
+    uint32_t seed = 0x2545F491;
+    size_t mismatches = 0;
+
+    frame_parser_init(&parser, &packet);
+
+    for (size_t round = 0; round < 20000; round++)
+    {
+        /* Bytes drawn mostly from the preamble bytes so partial and overlapping preambles are frequent */
+        size_t frame_len = PREAMBLE_SIZE_BYTES + HEADER_SIZE_BYTES + test_rand(&seed) % (MAX_FRAME_SIZE - HEADER_SIZE_BYTES);
+        packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_TURN_ON_LED, PROTOCOL_ADDR_P2P,
+                                                   test_rand(&seed) % (MAX_PAYLOAD_SIZE + 1));
+
+        memcpy(frame, protocol_preamble.bit, PREAMBLE_SIZE_BYTES);
+
+        for (size_t i = PREAMBLE_SIZE_BYTES; i < frame_len; i++)
+        {
+            uint32_t r = test_rand(&seed);
+
+            frame[i] = (r & 0x300) ? protocol_preamble.bit[r & 3] : (uint8_t)r;
+        }
+
+        /* Valid header half of the time, so the frames go past the header too */
+        if (round & 1)
+        {
+            memcpy(&frame[PREAMBLE_SIZE_BYTES], &header, HEADER_SIZE_BYTES);
+        }
+
+        /* Compared after every chunk, up to the verdict */
+        size_t chunk = 1 + test_rand(&seed) % 32;
+        size_t idx = PREAMBLE_SIZE_BYTES;
+        frame_parser_result_t result = FRAME_PARSER_MORE;
+
+        frame_parser_start(&parser);
+        TEST_CHECK(frame_parser_get_resync_len(&parser) == 0);
+
+        while ((idx < frame_len) && ((result == FRAME_PARSER_MORE) || (result == FRAME_PARSER_HEADER_DONE) ||
+                                     (result == FRAME_PARSER_PAYLOAD_DONE)))
+        {
+            size_t len = (frame_len - idx < chunk) ? (frame_len - idx) : chunk;
+            size_t consumed;
+
+            result = frame_parser_feed(&parser, &frame[idx], len, &consumed);
+            idx += consumed;
+            mismatches += (frame_parser_get_resync_len(&parser) != resync_len_brute_force(frame, idx));
+        }
+    }
+
+    TEST_CHECK(mismatches == 0);
+}
+
+/**
+ * @brief Model of the rx fsm receive path over a stream, return the number of frames accepted
+ *
+ * @param rescan true to hunt again from one byte after a rejected preamble, false to discard
+ *               every byte of the rejected frame
+ */
+static size_t receive_stream(const uint8_t *stream, size_t stream_len, bool rescan)
+{
+    frame_parser_t parser;
+    size_t pos = 0;
+    size_t accepted = 0;
+
+    frame_parser_init(&parser, &packet);
+
+    while (pos + PREAMBLE_SIZE_BYTES <= stream_len)
+    {
+        /* Preamble hunt at every byte offset */
+        size_t start = pos;
+
+        while ((start + PREAMBLE_SIZE_BYTES <= stream_len) &&
+               (memcmp(&stream[start], protocol_preamble.bit, PREAMBLE_SIZE_BYTES) != 0))
+        {
+            start++;
+        }
+
+        if (start + PREAMBLE_SIZE_BYTES > stream_len)
+        {
+            break;
+        }
+
+        size_t idx = start + PREAMBLE_SIZE_BYTES;
+        size_t consumed;
+        frame_parser_result_t result;
+
+        frame_parser_start(&parser);
+        result = frame_parser_feed(&parser, &stream[idx], stream_len - idx, &consumed);
+        idx += consumed;
+
+        /* Header checked as the rx fsm does, before any payload byte */
+        if ((result == FRAME_PARSER_HEADER_DONE) && !protocol_check_valid_header(&packet))
+        {
+            result = FRAME_PARSER_HEADER_ERROR;
+        }
+
+        if (result == FRAME_PARSER_HEADER_DONE)
+        {
+            result = parse(&parser, &stream[idx], stream_len - idx, stream_len - idx, &consumed);
+            idx += consumed;
+        }
+
+        if (result == FRAME_PARSER_FRAME_OK)
+        {
+            accepted++;
+            pos = idx;
+        }
+        else if (result == FRAME_PARSER_MORE)
+        {
+            break;
+        }
+        else
+        {
+            pos = rescan ? (start + 1 + frame_parser_get_resync_len(&parser)) : idx;
+        }
+    }
+
+    return accepted;
+}
+
+/**
+ * @brief Append a frame with a random payload to a stream, return its length
+ */
+static size_t stream_add_frame(uint8_t *stream, uint16_t payload_len, uint32_t *seed)
+{
+    uint8_t payload[BER_MAX_PAYLOAD];
+    packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_TURN_ON_LED, PROTOCOL_ADDR_P2P, payload_len);
+
+    for (size_t i = 0; i < payload_len; i++)
+    {
+        payload[i] = (uint8_t)test_rand(seed);
+    }
+
+    return test_frame_build(stream, &header, payload);
+}
+
+static void test_rescan_after_rejected_frame(void)
+{
+    static uint8_t stream[4 * MAX_FRAME_SIZE];
+    uint32_t seed = 0xDEADBEEF;
+    size_t len = 0;
+
+    /* Frame cut after its header, the sender restarted with a whole frame: its length field
+     * swallows the next frame, only the rescan finds it */
+    len += stream_add_frame(&stream[len], 40, &seed);
+    len = PREAMBLE_SIZE_BYTES + HEADER_SIZE_BYTES + 2;
+    len += stream_add_frame(&stream[len], 20, &seed);
+    len += stream_add_frame(&stream[len], 30, &seed);
+
+    TEST_CHECK(receive_stream(stream, len, false) < 2);
+    TEST_CHECK(receive_stream(stream, len, true) == 2);
+
+    /* Noise one byte out of phase with the preamble (xx 55 AA 55 AA ...): the first match is
+     * one byte early, the real preamble overlaps it */
+    len = 0;
+    stream[len++] = protocol_preamble.bit[2];
+    stream[len++] = protocol_preamble.bit[3];
+    len += stream_add_frame(&stream[len], 20, &seed);
+
+    TEST_CHECK(receive_stream(stream, len, true) == 1);
+}
+
+static void test_frame_loss_vs_ber(void)
+{
+    static uint8_t stream[BER_STREAM_SIZE];
+    const double bers[] = {0.0, 1e-5, 1e-4, 3e-4, 1e-3, 3e-3};
+
+    for (size_t b = 0; b < sizeof(bers) / sizeof(bers[0]); b++)
+    {
+        uint32_t seed = 0x1234567;
+        size_t len = 0;
+
+        /* Frames with random gaps of noise between them */
+        for (size_t n = 0; n < BER_FRAMES; n++)
+        {
+            size_t gap = test_rand(&seed) % BER_MAX_GAP;
+
+            for (size_t i = 0; i < gap; i++)
+            {
+                stream[len++] = (uint8_t)test_rand(&seed);
+            }
+
+            len += stream_add_frame(&stream[len], BER_MIN_PAYLOAD + test_rand(&seed) % (BER_MAX_PAYLOAD - BER_MIN_PAYLOAD), &seed);
+        }
+
+        /* Bit errors spread uniformly over the stream */
+        uint64_t bits = (uint64_t)len * 8u;
+        uint64_t flips = (uint64_t)((double)bits * bers[b]);
+
+        for (uint64_t i = 0; i < flips; i++)
+        {
+            uint64_t bit = (((uint64_t)test_rand(&seed) << 32) | test_rand(&seed)) % bits;
+
+            stream[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+        }
+
+        size_t discard = receive_stream(stream, len, false);
+        size_t rescan = receive_stream(stream, len, true);
+
+        printf("    BER %.0e: frame loss, discard %6.2f%% | rescan %6.2f%%\n", bers[b],
+               100.0 * (double)(BER_FRAMES - discard) / BER_FRAMES, 100.0 * (double)(BER_FRAMES - rescan) / BER_FRAMES);
+
+        TEST_CHECK(rescan >= discard);
+        TEST_CHECK((bers[b] > 0.0) || (rescan == BER_FRAMES && discard == BER_FRAMES));
+    }
+}
+
+int main(void)
+{
+    TEST_RUN(test_verdicts);
+    TEST_RUN(test_errors);
+    TEST_RUN(test_resync_len);
+    TEST_RUN(test_rescan_after_rejected_frame);
+    TEST_RUN(test_frame_loss_vs_ber);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,166 @@
+/**
+ * @file test_payload_bounds.c
+ * @brief  Host tests of the 16 bit payload length bounds, built with the default MAX_PAYLOAD_SIZE
+ *         and with a jumbo frame configuration
+ * @version 0.1
+ */
+
+#include "test.h"
+#include "test_frame.h"
+#include "frame_parser.h"
+#include "host_comm_tx_queue.h"
+
+/**@brief Header check of a host to target command of a given payload length */
+static uint8_t header_check(uint16_t payload_len)
+{
+    packet_data_t packet;
+
+    packet.header = test_frame_header(HOST_TO_TARGET_CMD_GET_FW_VERSION, PROTOCOL_ADDR_P2P, payload_len);
+    return protocol_check_valid_header(&packet);
+}
+
+static void test_header_check(void)
+{
+    TEST_CHECK(header_check(0));
+    TEST_CHECK(header_check(UINT8_MAX));
+    TEST_CHECK(header_check(UINT8_MAX + 1) == (UINT8_MAX + 1 <= MAX_PAYLOAD_SIZE));
+    TEST_CHECK(header_check(MAX_PAYLOAD_SIZE));
+    TEST_CHECK(!header_check(MAX_PAYLOAD_SIZE + 1));
+    TEST_CHECK(!header_check(UINT16_MAX));
+}
+
+/**
+ * @brief Feed a frame in chunks to the parser, return the verdict
+ */
+static frame_parser_result_t parse_frame(frame_parser_t *parser, const uint8_t *frame, size_t frame_len, size_t chunk)
+{
+    frame_parser_result_t result = FRAME_PARSER_MORE;
+    size_t idx = PREAMBLE_SIZE_BYTES;
+
+    frame_parser_start(parser);
+
+    while (idx < frame_len)
+    {
+        size_t len = (frame_len - idx < chunk) ? (frame_len - idx) : chunk;
+        size_t consumed;
+
+        result = frame_parser_feed(parser, &frame[idx], len, &consumed);
+        idx += consumed;
+
+        if ((result != FRAME_PARSER_MORE) && (result != FRAME_PARSER_HEADER_DONE) && (result != FRAME_PARSER_PAYLOAD_DONE))
+        {
+            break;
+        }
+    }
+
+    return result;
+}
+
+static void test_parser_max_payload(void)
+{
+    static uint8_t frame[MAX_FRAME_SIZE];
+    static uint8_t payload[MAX_PAYLOAD_SIZE];
+    static packet_data_t packet;
+    frame_parser_t parser;
+    packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_GET_FW_VERSION, PROTOCOL_ADDR_P2P, MAX_PAYLOAD_SIZE);
+
+    for (size_t i = 0; i < MAX_PAYLOAD_SIZE; i++)
+    {
+        payload[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+
+    size_t frame_len = test_frame_build(frame, &header, payload);
+
+    TEST_CHECK(frame_len == MAX_FRAME_SIZE);
+    frame_parser_init(&parser, &packet);
+
+    /* Chunk sizes from single bytes to the whole frame */
+    for (size_t chunk = 1; chunk <= MAX_FRAME_SIZE; chunk = 2 * chunk + 1)
+    {
+        memset(&packet, 0, sizeof(packet));
+        TEST_CHECK(parse_frame(&parser, frame, frame_len, chunk) == FRAME_PARSER_FRAME_OK);
+        TEST_CHECK(packet.header.payload_len == MAX_PAYLOAD_SIZE);
+        TEST_CHECK(memcmp(packet.payload.buffer, payload, MAX_PAYLOAD_SIZE) == 0);
+    }
+}
+
+static void test_parser_oversized_payload(void)
+{
+    static packet_data_t packet;
+    const uint16_t oversized[] = {MAX_PAYLOAD_SIZE + 1, UINT16_MAX};
+    uint8_t data[HEADER_SIZE_BYTES + 16] = {0};
+    frame_parser_t parser;
+    size_t consumed;
+
+    frame_parser_init(&parser, &packet);
+
+    for (size_t i = 0; i < sizeof(oversized) / sizeof(oversized[0]); i++)
+    {
+        packet_header_t header = test_frame_header(HOST_TO_TARGET_CMD_GET_FW_VERSION, PROTOCOL_ADDR_P2P, oversized[i]);
+
+        /* Rejected right after the header, no payload byte is taken */
+        memcpy(data, &header, HEADER_SIZE_BYTES);
+        frame_parser_start(&parser);
+        TEST_CHECK(frame_parser_feed(&parser, data, sizeof(data), &consumed) == FRAME_PARSER_HEADER_ERROR);
+        TEST_CHECK(consumed == HEADER_SIZE_BYTES);
+        TEST_CHECK(frame_parser_feed(&parser, data, sizeof(data), &consumed) == FRAME_PARSER_MORE && consumed == 0);
+    }
+}
+
+static void test_tx_queue_max_payload(void)
+{
+    static host_comm_tx_queue_t tx_queue;
+    static uint8_t payload[MAX_PAYLOAD_SIZE + 1];
+    static tx_request_t request;
+    packet_header_t header = test_frame_header(TARGET_TO_HOST_RES_FW_VERSION, PROTOCOL_ADDR_P2P, MAX_PAYLOAD_SIZE);
+    size_t queued = 0;
+
+    for (size_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8_t)(i ^ (i >> 8));
+    }
+
+    host_comm_tx_queue_init(&tx_queue);
+
+    /* Oversized payloads are rejected, nothing is queued */
+    header.payload_len = MAX_PAYLOAD_SIZE + 1;
+    TEST_CHECK(!host_comm_tx_queue_write_packet(&tx_queue, TX_SRC_FW_USER, false, &header, payload));
+    TEST_CHECK(!host_comm_tx_queue_write_lossy_packet(&tx_queue, &header, payload));
+    TEST_CHECK(host_comm_tx_queue_get_pending_transfers(&tx_queue) == 0);
+
+    /* Max payloads until the payload buffer is full, all read back intact */
+    header.payload_len = MAX_PAYLOAD_SIZE;
+
+    while (host_comm_tx_queue_write_packet(&tx_queue, TX_SRC_FW_USER, true, &header, payload))
+    {
+        queued++;
+    }
+
+    TEST_CHECK(queued == TX_QUEUE_BUFF_SIZE / MAX_PAYLOAD_SIZE);
+
+    for (size_t i = 0; i < queued; i++)
+    {
+        TEST_CHECK(host_comm_tx_queue_read_request(&tx_queue, &request));
+        TEST_CHECK(request.packet.header.payload_len == MAX_PAYLOAD_SIZE && request.ack_expected);
+        TEST_CHECK(memcmp(request.packet.payload.buffer, payload, MAX_PAYLOAD_SIZE) == 0);
+    }
+
+    /* Lossy max payload */
+    TEST_CHECK(host_comm_tx_queue_write_lossy_packet(&tx_queue, &header, payload));
+    TEST_CHECK(host_comm_tx_queue_read_request(&tx_queue, &request));
+    TEST_CHECK(request.packet.header.payload_len == MAX_PAYLOAD_SIZE);
+    TEST_CHECK(memcmp(request.packet.payload.buffer, payload, MAX_PAYLOAD_SIZE) == 0);
+    TEST_CHECK(host_comm_tx_queue_get_pending_transfers(&tx_queue) == 0);
+}
+
+int main(void)
+{
+    printf("payload bounds, MAX_PAYLOAD_SIZE %d\n", MAX_PAYLOAD_SIZE);
+
+    TEST_RUN(test_header_check);
+    TEST_RUN(test_parser_max_payload);
+    TEST_RUN(test_parser_oversized_payload);
+    TEST_RUN(test_tx_queue_max_payload);
+
+    return TEST_RESULT();
+}
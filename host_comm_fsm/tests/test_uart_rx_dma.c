@@ -0,0 +1,273 @@
+/**
+ * @file test_uart_rx_dma.c
+ * @brief  Host tests of the circular DMA reception publishing, built once per index mode
+ *         (CIRCULAR_BUFF_POW2_MODE)
+ * @version 0.1
+ *
+ * @note   The DMA is simulated: it writes a byte sequence (0, 1, 2, ...) straight into the buffer
+ *         memory, wrapping at its end, and the tests call uart_rx_dma_publish() with the positions
+ *         the half transfer (HT), full transfer (TC) and IDLE line events would report.
+ */
+
+#include "test.h"
+#include "uart_rx_dma.h"
+#include "string.h"
+
+#if CIRCULAR_BUFF_POW2_MODE
+#define DMA_BUFF_SIZE       (64)
+#else
+#define DMA_BUFF_SIZE       (60)
+#endif
+#define DMA_HT_POS          (DMA_BUFF_SIZE / 2)
+#define DMA_TC_POS          (DMA_BUFF_SIZE)
+
+/**
+ * @brief Simulated reception: circular buffer used as DMA memory, DMA and consumer positions
+ */
+typedef struct
+{
+    uint8_t buffer[DMA_BUFF_SIZE];
+    circular_buff_t ctrl;
+    c_buff_handle_t cb;
+    uart_rx_dma_t rx_dma;
+    size_t dma_pos;         /* next position written by the DMA */
+    uint8_t dma_seq;        /* next byte written by the DMA */
+    uint8_t read_seq;       /* next byte expected by the consumer */
+}test_rx_t;
+
+static void rx_init(test_rx_t *rx)
+{
+    memset(rx, 0, sizeof(*rx));
+    rx->cb = circular_buff_init_static(&rx->ctrl, rx->buffer, DMA_BUFF_SIZE);
+    uart_rx_dma_init(&rx->rx_dma, rx->cb);
+}
+
+/**
+ * @brief DMA writes len bytes, whatever the data still unread
+ * @return size_t DMA write position a HT, TC or IDLE event reports, DMA_TC_POS at the end of the buffer
+ */
+static size_t dma_receive(test_rx_t *rx, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        rx->buffer[rx->dma_pos] = rx->dma_seq++;
+        rx->dma_pos = (rx->dma_pos + 1) % DMA_BUFF_SIZE;
+    }
+
+    return (rx->dma_pos == 0 && len != 0) ? DMA_TC_POS : rx->dma_pos;
+}
+
+/**
+ * @brief Consume all the data published, return false if it is not the received sequence
+ */
+static bool rx_consume(test_rx_t *rx, size_t expected_len)
+{
+    uint8_t data[DMA_BUFF_SIZE];
+    size_t len = circular_buff_get_data_len(rx->cb);
+    bool ok = (len == expected_len) && circular_buff_read(rx->cb, data, len);
+
+    for (size_t i = 0; ok && (i < len); i++)
+    {
+        ok = (data[i] == rx->read_seq++);
+    }
+
+    return ok;
+}
+
+static void test_half_and_full_transfer(void)
+{
+    static test_rx_t rx;
+
+    rx_init(&rx);
+
+    /* HT then TC, the TC position (buffer length) maps to the beginning of the buffer */
+    for (size_t lap = 0; lap < 4; lap++)
+    {
+        TEST_CHECK(dma_receive(&rx, DMA_HT_POS) == DMA_HT_POS);
+        TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, DMA_HT_POS) == DMA_HT_POS);
+        TEST_CHECK(rx_consume(&rx, DMA_HT_POS));
+
+        TEST_CHECK(dma_receive(&rx, DMA_BUFF_SIZE - DMA_HT_POS) == DMA_TC_POS);
+        TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, DMA_TC_POS) == DMA_BUFF_SIZE - DMA_HT_POS);
+        TEST_CHECK(rx.rx_dma.pos == 0);
+        TEST_CHECK(rx_consume(&rx, DMA_BUFF_SIZE - DMA_HT_POS));
+
+        /* IDLE reported right after TC, the DMA counter reloaded: nothing new */
+        TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, 0) == 0);
+    }
+
+    TEST_CHECK(!uart_rx_dma_is_overrun(&rx.rx_dma));
+}
+
+static void test_idle_positions(void)
+{
+    static test_rx_t rx;
+    size_t pos;
+
+    rx_init(&rx);
+
+    /* IDLE in each half, then the HT and TC events of the same lap */
+    pos = dma_receive(&rx, 5);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == 5);
+    pos = dma_receive(&rx, DMA_HT_POS - 5);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == DMA_HT_POS - 5);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, DMA_HT_POS) == 0);           /* HT at the IDLE position */
+    TEST_CHECK(rx_consume(&rx, DMA_HT_POS));
+
+    pos = dma_receive(&rx, 3);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == 3);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == 0);                  /* same event twice */
+    pos = dma_receive(&rx, DMA_BUFF_SIZE - DMA_HT_POS - 3);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == DMA_BUFF_SIZE - DMA_HT_POS - 3);
+    TEST_CHECK(rx_consume(&rx, DMA_BUFF_SIZE - DMA_HT_POS));
+
+    /* Single bytes at every position of two laps */
+    for (size_t i = 0; i < 2 * DMA_BUFF_SIZE; i++)
+    {
+        pos = dma_receive(&rx, 1);
+        TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == 1);
+        TEST_CHECK(rx_consume(&rx, 1));
+    }
+
+    TEST_CHECK(!uart_rx_dma_is_overrun(&rx.rx_dma));
+}
+
+static void test_wrap_around(void)
+{
+    static test_rx_t rx;
+    size_t pos;
+
+    rx_init(&rx);
+
+    /* IDLE near the end, then the next event after the DMA wrapped (its TC event coalesced) */
+    pos = dma_receive(&rx, DMA_BUFF_SIZE - 4);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == DMA_BUFF_SIZE - 4);
+    TEST_CHECK(rx_consume(&rx, DMA_BUFF_SIZE - 4));
+
+    pos = dma_receive(&rx, 10);
+    TEST_CHECK(pos == 6);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == 10);
+
+    /* The bytes straddle the end of the buffer, the reader sees them in order */
+    TEST_CHECK(rx_consume(&rx, 10));
+
+    /* Unread data kept across the wrap, the free space is what is left */
+    pos = dma_receive(&rx, DMA_BUFF_SIZE - 6);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == DMA_BUFF_SIZE - 6);
+    pos = dma_receive(&rx, 6);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == 6);
+    TEST_CHECK(circular_buff_get_free_space(rx.cb) == 0);
+    TEST_CHECK(rx_consume(&rx, DMA_BUFF_SIZE));
+    TEST_CHECK(!uart_rx_dma_is_overrun(&rx.rx_dma));
+}
+
+static void test_overrun(void)
+{
+    static test_rx_t rx;
+    size_t pos;
+
+    rx_init(&rx);
+
+    /* Consumer stalled: HT and TC fill the buffer exactly, no overrun yet */
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, dma_receive(&rx, DMA_HT_POS)) == DMA_HT_POS);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, dma_receive(&rx, DMA_BUFF_SIZE - DMA_HT_POS)) == DMA_BUFF_SIZE - DMA_HT_POS);
+    TEST_CHECK(circular_buff_get_free_space(rx.cb) == 0);
+    TEST_CHECK(!uart_rx_dma_is_overrun(&rx.rx_dma));
+
+    /* One more byte overwrote the oldest unread byte: nothing is published, the flag is set */
+    pos = dma_receive(&rx, 1);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == 0);
+    TEST_CHECK(uart_rx_dma_is_overrun(&rx.rx_dma));
+    TEST_CHECK(rx.rx_dma.overrun_cnt == 1);
+    TEST_CHECK(circular_buff_get_data_len(rx.cb) == DMA_BUFF_SIZE);
+
+    /* Publishing stays stopped even once the consumer caught up */
+    circular_buff_commit_read(rx.cb, DMA_BUFF_SIZE);
+    pos = dma_receive(&rx, 2);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == 0);
+    TEST_CHECK(circular_buff_empty(rx.cb));
+    TEST_CHECK(rx.rx_dma.overrun_cnt == 1);
+
+    /* Partial overrun: the new bytes exceed the free space left by unread data */
+    rx_init(&rx);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, dma_receive(&rx, 20)) == 20);
+    circular_buff_commit_read(rx.cb, 5);
+    pos = dma_receive(&rx, DMA_BUFF_SIZE - 15 + 1);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == 0);
+    TEST_CHECK(uart_rx_dma_is_overrun(&rx.rx_dma) && rx.rx_dma.overrun_cnt == 1);
+    TEST_CHECK(circular_buff_get_data_len(rx.cb) == 15);
+}
+
+static void test_restart(void)
+{
+    static test_rx_t rx;
+    size_t pos;
+
+    rx_init(&rx);
+
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, dma_receive(&rx, 40)) == 40);
+    pos = dma_receive(&rx, DMA_HT_POS);                                     /* more than the free space */
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == 0);
+    TEST_CHECK(uart_rx_dma_is_overrun(&rx.rx_dma));
+
+    /* Driver recovery: DMA stopped, buffer reset, DMA restarted at the beginning of the buffer */
+    circular_buff_reset(rx.cb);
+    uart_rx_dma_restart(&rx.rx_dma);
+    rx.dma_pos = 0;
+    rx.read_seq = rx.dma_seq;
+
+    TEST_CHECK(!uart_rx_dma_is_overrun(&rx.rx_dma));
+    TEST_CHECK(rx.rx_dma.overrun_cnt == 1);
+
+    pos = dma_receive(&rx, 7);
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, pos) == 7);
+    TEST_CHECK(rx_consume(&rx, 7));
+    TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, dma_receive(&rx, DMA_HT_POS - 7)) == DMA_HT_POS - 7);
+    TEST_CHECK(rx_consume(&rx, DMA_HT_POS - 7));
+}
+
+static void test_random_events(void)
+{
+    static test_rx_t rx;
+    uint32_t seed = 0xC0FFEE;
+    size_t unread = 0;
+
+    rx_init(&rx);
+
+    /* Bursts never longer than half of the buffer (the HT/TC bound), consumer reads randomly */
+    for (size_t i = 0; i < 100000; i++)
+    {
+        size_t burst = test_rand(&seed) % (DMA_BUFF_SIZE / 2 + 1);
+
+        if (unread + burst > DMA_BUFF_SIZE)
+        {
+            TEST_CHECK(rx_consume(&rx, unread));
+            unread = 0;
+        }
+
+        TEST_CHECK(uart_rx_dma_publish(&rx.rx_dma, dma_receive(&rx, burst)) == burst);
+        unread += burst;
+
+        if (test_rand(&seed) & 1)
+        {
+            TEST_CHECK(rx_consume(&rx, unread));
+            unread = 0;
+        }
+    }
+
+    TEST_CHECK(!uart_rx_dma_is_overrun(&rx.rx_dma));
+}
+
+int main(void)
+{
+    printf("uart rx dma, %s index mode\n", CIRCULAR_BUFF_POW2_MODE ? "power-of-two" : "modulo");
+
+    TEST_RUN(test_half_and_full_transfer);
+    TEST_RUN(test_idle_positions);
+    TEST_RUN(test_wrap_around);
+    TEST_RUN(test_overrun);
+    TEST_RUN(test_restart);
+    TEST_RUN(test_random_events);
+
+    return TEST_RESULT();
+}